@@ -0,0 +1,51 @@
+#include "AdaptiveInterval.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kAlpha = 0.3;        // weight of the newest change in the EWMA
+constexpr double kSnapChange = 0.5;   // a 50% jump in one sample goes straight to the fast rate
+constexpr double kBusy = 0.25;        // average change above this halves the interval
+constexpr double kQuiet = 0.08;       // and below this stretches it by half
+constexpr double kFloor = 1.0;        // keeps noise around zero from looking volatile
+
+} // namespace
+
+AdaptiveInterval::AdaptiveInterval()
+    : minMs(1000), maxMs(1000), intervalMs(1000), ewma(0.0), previous(), hasPrevious(false) {}
+
+void AdaptiveInterval::setBounds(int newMinMs, int newMaxMs) {
+    minMs = std::max(50, newMinMs);
+    maxMs = std::max(minMs, newMaxMs);
+    intervalMs = std::clamp(intervalMs, minMs, maxMs);
+}
+
+void AdaptiveInterval::observe(std::initializer_list<double> values) {
+    double change = 0.0;
+    int i = 0;
+    for (double value : values) {
+        if (i == kMaxValues) break;
+        double scale = std::max({std::fabs(previous[i]), std::fabs(value), kFloor});
+        change = std::max(change, std::fabs(value - previous[i]) / scale);
+        previous[i++] = value;
+    }
+    if (!hasPrevious) {
+        hasPrevious = true;
+        return;
+    }
+    ewma = kAlpha * change + (1.0 - kAlpha) * ewma;
+
+    if (change > kSnapChange) {
+        intervalMs = minMs;
+    } else if (ewma > kBusy) {
+        intervalMs = std::max(minMs, intervalMs / 2);
+    } else if (ewma < kQuiet) {
+        intervalMs = std::min(maxMs, intervalMs + intervalMs / 2);
+    }
+}
+
+void AdaptiveInterval::snap() {
+    intervalMs = minMs;
+    nextDue = Clock::time_point();
+}
@@ -0,0 +1,40 @@
+#ifndef ADAPTIVE_INTERVAL_H
+#define ADAPTIVE_INTERVAL_H
+
+#include <chrono>
+#include <initializer_list>
+
+class AdaptiveInterval {
+public:
+    // Sampling interval that follows how much a source's headline value moves. An EWMA of the
+    // relative change between samples stretches the interval towards maxMs while things are quiet
+    // and shrinks it while they are busy; one large jump goes straight back to minMs.
+    // Values should be in units where 1 is a change worth noticing (10% CPU, 1 MB/s, 1 C), since
+    // changes are measured against max(|value|, 1).
+    static constexpr int kMaxValues = 4;
+    using Clock = std::chrono::steady_clock;
+
+    AdaptiveInterval();
+
+    void setBounds(int minMs, int maxMs);
+    void observe(std::initializer_list<double> values); // the biggest change among them counts
+    void snap();  // back to the fastest rate, e.g. when PSI fires
+
+    bool isDue(Clock::time_point now) const { return now >= nextDue; }
+    Clock::time_point getNextDue() const { return nextDue; }
+    void ran(Clock::time_point now) { nextDue = now + std::chrono::milliseconds(intervalMs); }
+
+    int getIntervalMs() const { return intervalMs; }
+    double getVolatility() const { return ewma; }
+
+private:
+    int minMs;
+    int maxMs;
+    int intervalMs;
+    double ewma;
+    double previous[kMaxValues];
+    bool hasPrevious;
+    Clock::time_point nextDue;
+};
+
+#endif
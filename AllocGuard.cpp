@@ -0,0 +1,93 @@
+#include "AllocGuard.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef STATSBY_ALLOC_GUARD
+
+namespace {
+
+thread_local long long allocations = 0;
+
+void* allocate(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* allocateAligned(size_t size, std::align_val_t alignment) {
+    allocations++;
+    size_t align = static_cast<size_t>(alignment);
+    void* p = aligned_alloc(align, (size + align - 1) / align * align);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+// Every other form (nothrow, arrays) forwards to these in libstdc++, but not reliably elsewhere.
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+void* operator new(size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { free(p); }
+
+bool AllocGuard::isEnabled() {
+    return true;
+}
+
+long long AllocGuard::threadAllocations() {
+    return allocations;
+}
+
+#else
+
+bool AllocGuard::isEnabled() {
+    return false;
+}
+
+long long AllocGuard::threadAllocations() {
+    return 0;
+}
+
+#endif
+
+void AllocGuard::begin() {
+    start = threadAllocations();
+}
+
+void AllocGuard::end() {
+    last = threadAllocations() - start;
+    if (++runs <= kWarmupTicks || last == 0) {
+        return;
+    }
+    // Reported once per tick name: past the first, the debug window keeps count.
+    if (steadyTotal == 0) {
+        fprintf(stderr, "Allocation guard: %s allocated %lld times in one tick after warm-up\n", name.c_str(), last);
+        const char* abortOnAllocation = getenv("STATSBY_ALLOC_GUARD_ABORT");
+        if (abortOnAllocation && *abortOnAllocation == '1') {
+            abort();
+        }
+    }
+    steadyTotal += last;
+}
@@ -0,0 +1,36 @@
+#ifndef ALLOC_GUARD_H
+#define ALLOC_GUARD_H
+
+#include <string>
+
+class AllocGuard {
+public:
+    // Counts heap allocations per sampling tick in builds configured with -DSTATSBY_ALLOC_GUARD=ON,
+    // which replace the global operator new. Once a tick has run kWarmupTicks times (buffers
+    // grown, interfaces listed) it should allocate nothing; one that does is reported on stderr,
+    // and with STATSBY_ALLOC_GUARD_ABORT=1 in the environment the process aborts right there so a
+    // core dump shows who. In normal builds nothing is counted and begin()/end() cost nothing.
+    static constexpr int kWarmupTicks = 3;
+
+    explicit AllocGuard(const std::string& name) : name(name), runs(0), start(0), last(0), steadyTotal(0) {}
+
+    // Both on the thread that runs the tick; only that thread's allocations count.
+    void begin();
+    void end();
+
+    long long getLast() const { return last; }
+    long long getSteadyTotal() const { return steadyTotal; } // summed over ticks after warm-up
+
+    static bool isEnabled();
+    // Allocations made by the calling thread so far.
+    static long long threadAllocations();
+
+private:
+    std::string name;
+    int runs;
+    long long start;
+    long long last;
+    long long steadyTotal;
+};
+
+#endif
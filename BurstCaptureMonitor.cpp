@@ -0,0 +1,283 @@
+#include "BurstCaptureMonitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kPressureFiles[] = {"cpu", "memory", "io"};
+
+long long monotonicNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// "0-3,8,10-11" as in /sys/devices/system/cpu/isolated; an empty file means none.
+void parseCpuList(const char* text, std::vector<bool>& cpus) {
+    const char* p = text;
+    while (*p >= '0' && *p <= '9') {
+        char* end = nullptr;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (*end == '-') {
+            last = strtol(end + 1, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < static_cast<long>(cpus.size()); ++cpu) {
+            cpus[cpu] = true;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+}
+
+bool startsWith(const char* p, const char* end, const char* prefix, size_t length) {
+    return static_cast<size_t>(end - p) >= length && memcmp(p, prefix, length) == 0;
+}
+
+} // namespace
+
+BurstCaptureMonitor::BurstCaptureMonitor(const std::string& procRoot, const std::string& sysRoot)
+    : procRoot(procRoot), sysRoot(sysRoot), durationSeconds(5), requestedCpu(-1), samplerCpu(-1), notifyFd(-1),
+      running(false), capturing(false), capturedOnce(false), coreCount(0), count(0), missed(0), startTime(0),
+      prevStall{}, prevNs(0) {}
+
+BurstCaptureMonitor::~BurstCaptureMonitor() {
+    stop();
+}
+
+void BurstCaptureMonitor::setDuration(int seconds) {
+    durationSeconds = std::clamp(seconds, 1, kMaxSeconds);
+}
+
+int BurstCaptureMonitor::pickHousekeepingCpu() const {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return -1;
+    }
+    std::vector<bool> excluded(CPU_SETSIZE);
+    for (const char* name : {"isolated", "nohz_full"}) {
+        ProcFile list(sysRoot + "/devices/system/cpu/" + name);
+        if (list.read()) {
+            parseCpuList(list.data(), excluded);
+        }
+    }
+    int fallback = -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (!excluded[cpu]) return cpu;
+        if (fallback < 0) fallback = cpu;
+    }
+    return fallback;
+}
+
+bool BurstCaptureMonitor::trigger(const std::string& why) {
+    auto cooldown = std::chrono::seconds(durationSeconds + kCooldownSeconds);
+    if (capturedOnce && Clock::now() - lastCapture < cooldown) {
+        return false;
+    }
+    return start(why);
+}
+
+bool BurstCaptureMonitor::start(const std::string& why) {
+    if (capturing) {
+        return false;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (!statFile.isOpen()) {
+        statFile.open(procRoot + "/stat");
+        for (int i = 0; i < 3; ++i) {
+            pressureFiles[i].open(procRoot + "/pressure/" + kPressureFiles[i]);
+        }
+    }
+    // Also grows the buffer to fit /proc/stat, so the sampler's reads never have to.
+    if (!statFile.read()) {
+        return false;
+    }
+    // Offline CPUs have no line, so the numbers can have gaps; map each one to its column.
+    coreIds.clear();
+    const char* p = statFile.data();
+    const char* end = p + statFile.size();
+    while (p < end && startsWith(p, end, "cpu", 3)) {
+        if (p[3] >= '0' && p[3] <= '9') {
+            coreIds.push_back(atoi(p + 3));
+        }
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        p = lineEnd ? lineEnd + 1 : end;
+    }
+    int highest = coreIds.empty() ? -1 : *std::max_element(coreIds.begin(), coreIds.end());
+    coreSlots.assign(static_cast<size_t>(highest + 1), 0);
+    for (size_t column = 0; column < coreIds.size(); ++column) {
+        coreSlots[coreIds[column]] = column + 1;
+    }
+
+    size_t capacity = static_cast<size_t>(durationSeconds) * kRateHz;
+    coreCount = coreIds.size();
+    samples.assign(capacity, BurstSample());
+    coreUsage.assign(capacity * coreCount, 0.0f);
+    lastPercent.assign(coreCount + 1, 0.0f);
+    prevBusy.assign(coreCount + 1, 0);
+    prevTotal.assign(coreCount + 1, 0);
+    count.store(0, std::memory_order_relaxed);
+    missed = 0;
+    reason = why;
+    startTime = std::time(nullptr);
+    lastCapture = Clock::now();
+    capturedOnce = true;
+    samplerCpu = requestedCpu >= 0 ? requestedCpu : pickHousekeepingCpu();
+
+    running = true;
+    capturing = true;
+    worker = std::thread(&BurstCaptureMonitor::run, this);
+    // Pinned from here so samplerCpu is only ever written on this thread. Pinning can fail (the
+    // CPU went offline, a cpuset excludes it); the capture still runs, just wherever the
+    // scheduler puts it.
+    if (samplerCpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(samplerCpu, &set);
+        if (pthread_setaffinity_np(worker.native_handle(), sizeof(set), &set) != 0) {
+            samplerCpu = -1;
+        }
+    }
+    return true;
+}
+
+void BurstCaptureMonitor::stop() {
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void BurstCaptureMonitor::run() {
+    const long long periodNs = 1000000000LL / kRateHz;
+    long long startNs = monotonicNs();
+    sample(nullptr, nullptr, startNs); // baseline for the first interval
+    long long due = startNs;
+    size_t recorded = 0;
+    while (running && recorded < samples.size()) {
+        due += periodNs;
+        timespec wake = {static_cast<time_t>(due / 1000000000LL), static_cast<long>(due % 1000000000LL)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {
+        }
+        long long nowNs = monotonicNs();
+        // Late by whole periods: skip them rather than sampling back to back to catch up.
+        if (nowNs - due >= periodNs) {
+            long long late = (nowNs - due) / periodNs;
+            missed += static_cast<int>(late);
+            due += late * periodNs;
+        }
+        BurstSample& out = samples[recorded];
+        sample(&out, coreUsage.data() + recorded * coreCount, nowNs);
+        out.seconds = static_cast<float>((nowNs - startNs) / 1e9);
+        count.store(++recorded, std::memory_order_release);
+    }
+
+    running = false;
+    capturing = false;
+    if (notifyFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(notifyFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void BurstCaptureMonitor::sample(BurstSample* out, float* cores, long long nowNs) {
+    double elapsedNs = static_cast<double>(nowNs - prevNs);
+    prevNs = nowNs;
+
+    // cpu lines first, then intr (long), ctxt, btime, processes, procs_running, procs_blocked.
+    // Counters tick at USER_HZ, so a core only moves once per tick; one whose counters haven't
+    // moved since the last sample keeps its last value instead of dropping to 0.
+    if (statFile.read()) {
+        const char* p = statFile.data();
+        const char* end = p + statFile.size();
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!lineEnd) lineEnd = end;
+            if (startsWith(p, lineEnd, "cpu", 3)) {
+                char* field = const_cast<char*>(p + 3);
+                size_t slot = 0;
+                bool tracked = true;
+                if (*field >= '0' && *field <= '9') {
+                    // A CPU brought online mid-capture has no column and is skipped.
+                    unsigned long cpu = strtoul(field, &field, 10);
+                    slot = cpu < coreSlots.size() ? coreSlots[cpu] : 0;
+                    tracked = slot != 0;
+                }
+                if (tracked) {
+                    unsigned long long values[8] = {};
+                    for (unsigned long long& value : values) {
+                        value = strtoull(field, &field, 10);
+                    }
+                    // user nice system idle iowait irq softirq steal; guest is already in user.
+                    unsigned long long busy = values[0] + values[1] + values[2] + values[5] + values[6] + values[7];
+                    unsigned long long total = busy + values[3] + values[4];
+                    if (total > prevTotal[slot] && busy >= prevBusy[slot]) {
+                        lastPercent[slot] =
+                            static_cast<float>((busy - prevBusy[slot]) * 100.0 / (total - prevTotal[slot]));
+                    }
+                    prevBusy[slot] = busy;
+                    prevTotal[slot] = total;
+                    if (slot == 0) {
+                        if (out) out->cpuPercent = lastPercent[0];
+                    } else if (cores) {
+                        cores[slot - 1] = lastPercent[slot];
+                    }
+                }
+            } else if (out && startsWith(p, lineEnd, "procs_running ", 14)) {
+                out->running = static_cast<float>(strtoul(p + 14, nullptr, 10));
+            } else if (out && startsWith(p, lineEnd, "procs_blocked ", 14)) {
+                out->blocked = static_cast<float>(strtoul(p + 14, nullptr, 10));
+                break; // nothing we want after it
+            }
+            p = lineEnd + 1;
+        }
+    }
+
+    // "some avg10=0.00 avg60=0.00 avg300=0.00 total=123456", total in microseconds.
+    float* pressure[3] = {out ? &out->cpuPressure : nullptr, out ? &out->memoryPressure : nullptr,
+                          out ? &out->ioPressure : nullptr};
+    for (int i = 0; i < 3; ++i) {
+        if (!pressureFiles[i].read()) continue;
+        const char* total = strstr(pressureFiles[i].data(), "total=");
+        if (!total) continue;
+        unsigned long long stall = strtoull(total + 6, nullptr, 10);
+        if (pressure[i] && elapsedNs > 0 && stall >= prevStall[i]) {
+            *pressure[i] = static_cast<float>(std::min(100.0, (stall - prevStall[i]) * 1000.0 * 100.0 / elapsedNs));
+        }
+        prevStall[i] = stall;
+    }
+}
+
+bool BurstCaptureMonitor::save(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "seconds,cpu,running,blocked,cpu_psi,memory_psi,io_psi");
+    for (size_t c = 0; c < coreCount; ++c) {
+        fprintf(file, ",cpu%d", coreIds[c]);
+    }
+    fprintf(file, "\n");
+    size_t recorded = getSampleCount();
+    for (size_t i = 0; i < recorded; ++i) {
+        const BurstSample& s = samples[i];
+        fprintf(file, "%.3f,%.1f,%.0f,%.0f,%.2f,%.2f,%.2f", s.seconds, s.cpuPercent, s.running, s.blocked,
+                s.cpuPressure, s.memoryPressure, s.ioPressure);
+        for (size_t c = 0; c < coreCount; ++c) {
+            fprintf(file, ",%.0f", coreUsage[i * coreCount + c]);
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
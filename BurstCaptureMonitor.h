@@ -0,0 +1,109 @@
+#ifndef BURST_CAPTURE_MONITOR_H
+#define BURST_CAPTURE_MONITOR_H
+
+#include "ProcFile.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BurstSample {
+    float seconds = 0.0f;        // since the capture started
+    float cpuPercent = 0.0f;
+    float running = 0.0f;        // procs_running: tasks on a runqueue right now
+    float blocked = 0.0f;        // procs_blocked: tasks in uninterruptible I/O wait
+    float cpuPressure = 0.0f;    // % of the interval some task stalled on CPU ("some" total)
+    float memoryPressure = 0.0f;
+    float ioPressure = 0.0f;
+};
+
+class BurstCaptureMonitor {
+public:
+    // Samples /proc/stat (total and per-core CPU, runnable and blocked tasks) and the PSI stall
+    // totals at kRateHz for a few seconds, so stalls that the normal one-second averages smear out
+    // show up. Runs on its own thread, pinned to a housekeeping CPU (the first allowed one not in
+    // isolated or nohz_full) so it stays off the cores being measured. Buffers are sized when a
+    // capture starts, so the sampling loop itself only preads and parses.
+    static constexpr int kRateHz = 100;
+    static constexpr int kMaxSeconds = 60;
+
+    explicit BurstCaptureMonitor(const std::string& procRoot = "/proc", const std::string& sysRoot = "/sys");
+    ~BurstCaptureMonitor();
+    BurstCaptureMonitor(const BurstCaptureMonitor&) = delete;
+    BurstCaptureMonitor& operator=(const BurstCaptureMonitor&) = delete;
+
+    void setDuration(int seconds);
+    void setCpu(int cpu) { requestedCpu = cpu; } // -1 picks a housekeeping CPU
+    // Optional eventfd poked when a capture completes; set it before starting one.
+    void setNotifyFd(int fd) { notifyFd = fd; }
+
+    // Throws away the last capture and starts a new one, unless one is running.
+    bool start(const std::string& reason);
+    // The same for automatic triggers, which also wait out a cooldown after the last capture so
+    // one long stall doesn't keep replacing the window being looked at.
+    bool trigger(const std::string& reason);
+    void stop();
+    bool isCapturing() const { return capturing; }
+
+    // Samples recorded so far. Safe to read while capturing: the sampler only appends, and
+    // nothing is rewritten until the next start().
+    size_t getSampleCount() const { return count.load(std::memory_order_acquire); }
+    size_t getCapacity() const { return samples.size(); }
+    const std::vector<BurstSample>& getSamples() const { return samples; }
+    size_t getCoreCount() const { return coreCount; }
+    // The CPU number behind each column; with CPUs offline these aren't 0..coreCount-1.
+    const std::vector<int>& getCoreIds() const { return coreIds; }
+    // coreCount values per sample, sample-major.
+    const std::vector<float>& getCoreUsage() const { return coreUsage; }
+    const std::string& getReason() const { return reason; }
+    std::time_t getStartTime() const { return startTime; }
+    int getSamplerCpu() const { return samplerCpu; } // -1 when pinning failed
+    int getMissed() const { return missed; } // periods skipped because the sampler ran late
+
+    // One CSV row per sample, per-core columns last.
+    bool save(const std::string& path) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kCooldownSeconds = 30;
+
+    std::string procRoot;
+    std::string sysRoot;
+    int durationSeconds;
+    int requestedCpu;
+    int samplerCpu;
+    int notifyFd;
+
+    std::atomic<bool> running;
+    std::atomic<bool> capturing;
+    std::thread worker;
+    Clock::time_point lastCapture;
+    bool capturedOnce;
+
+    ProcFile statFile;
+    ProcFile pressureFiles[3]; // cpu, memory, io
+    std::vector<BurstSample> samples;
+    std::vector<float> coreUsage;
+    size_t coreCount;
+    std::vector<int> coreIds;
+    std::vector<size_t> coreSlots; // by CPU number: its slot in prevBusy etc., 0 if it has no column
+    std::atomic<size_t> count;
+    std::atomic<int> missed;
+    std::string reason;
+    std::time_t startTime;
+
+    // Previous raw counters; slot 0 is the all-CPU line, 1.. the cores.
+    std::vector<unsigned long long> prevBusy;
+    std::vector<unsigned long long> prevTotal;
+    std::vector<float> lastPercent;
+    unsigned long long prevStall[3];
+    long long prevNs;
+
+    int pickHousekeepingCpu() const;
+    void run();
+    void sample(BurstSample* out, float* cores, long long nowNs);
+};
+
+#endif
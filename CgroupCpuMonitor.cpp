@@ -0,0 +1,178 @@
+#include "CgroupCpuMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+bool hasToken(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        if (list.substr(0, comma) == token) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+} // namespace
+
+CgroupCpuMonitor::CgroupCpuMonitor(const std::string& cgroupRoot, const std::string& procRoot)
+    : cgroupRoot(cgroupRoot), procRoot(procRoot), v1(false), prevUsageUsec(0), prevPeriods(0), prevThrottled(0),
+      prevThrottledUsec(0), hasPrev(false) {
+    onlineCpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    open();
+}
+
+void CgroupCpuMonitor::setCgroupPath(const std::string& path) {
+    if (path != configuredPath) {
+        configuredPath = path;
+        open();
+    }
+}
+
+void CgroupCpuMonitor::open() {
+    quotas.clear();
+    cpuStatFile.close();
+    usageFile.close();
+    hasPrev = false;
+    stats = CgroupCpuStats();
+
+    // v2 has one hierarchy with cgroup.controllers at the root; v1 mounts cpu,cpuacct separately.
+    v1 = access((cgroupRoot + "/cgroup.controllers").c_str(), F_OK) != 0;
+    std::string mount = cgroupRoot;
+    if (v1) {
+        mount = access((cgroupRoot + "/cpu,cpuacct").c_str(), F_OK) == 0 ? cgroupRoot + "/cpu,cpuacct"
+                                                                          : cgroupRoot + "/cpu";
+    }
+
+    // Lines look like "0::/user.slice/..." on v2 and "4:cpu,cpuacct:/docker/..." on v1.
+    std::string path = configuredPath;
+    if (path.empty()) {
+        ProcFile self(procRoot + "/self/cgroup");
+        if (!self.read()) {
+            return;
+        }
+        std::string_view text = self.view();
+        while (!text.empty()) {
+            size_t newline = text.find('\n');
+            std::string_view line = text.substr(0, newline);
+            text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+            size_t first = line.find(':');
+            size_t second = first == std::string_view::npos ? first : line.find(':', first + 1);
+            if (second == std::string_view::npos) continue;
+            std::string_view controllers = line.substr(first + 1, second - first - 1);
+            if (v1 ? hasToken(controllers, "cpu") : controllers.empty()) {
+                path = std::string(line.substr(second + 1));
+                break;
+            }
+        }
+    }
+    if (path.empty() || path[0] != '/') {
+        path = "/" + path;
+    }
+    while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+    stats.path = path;
+
+    std::string dir = mount + (path == "/" ? "" : path);
+    if (v1) {
+        cpuStatFile.open(dir + "/cpu.stat");
+        usageFile.open(dir + "/cpuacct.usage");
+    } else {
+        cpuStatFile.open(dir + "/cpu.stat");
+    }
+    stats.available = cpuStatFile.isOpen();
+
+    // The effective limit is the tightest one between here and the root.
+    std::string walk = path;
+    while (true) {
+        std::string ancestor = mount + (walk == "/" ? "" : walk);
+        Quota quota;
+        if (v1) {
+            quota.quota.open(ancestor + "/cpu.cfs_quota_us");
+            quota.period.open(ancestor + "/cpu.cfs_period_us");
+        } else {
+            quota.max.open(ancestor + "/cpu.max");
+        }
+        if (quota.max.isOpen() || quota.quota.isOpen()) {
+            quotas.push_back(std::move(quota));
+        }
+        if (walk == "/") break;
+        size_t slash = walk.rfind('/');
+        walk = slash == 0 ? "/" : walk.substr(0, slash);
+    }
+    lastSample = std::chrono::steady_clock::now();
+}
+
+double CgroupCpuMonitor::readQuotaCores() {
+    double tightest = 0.0;
+    for (Quota& quota : quotas) {
+        double cores = 0.0;
+        if (v1) {
+            if (!quota.quota.read() || !quota.period.read()) continue;
+            long long quotaUs = strtoll(quota.quota.data(), nullptr, 10);
+            long long periodUs = strtoll(quota.period.data(), nullptr, 10);
+            if (quotaUs > 0 && periodUs > 0) cores = static_cast<double>(quotaUs) / periodUs;
+        } else {
+            if (!quota.max.read() || strncmp(quota.max.data(), "max", 3) == 0) continue;
+            char* next = nullptr;
+            long long quotaUs = strtoll(quota.max.data(), &next, 10);
+            long long periodUs = strtoll(next, nullptr, 10);
+            if (quotaUs > 0 && periodUs > 0) cores = static_cast<double>(quotaUs) / periodUs;
+        }
+        if (cores > 0 && (tightest == 0.0 || cores < tightest)) {
+            tightest = cores;
+        }
+    }
+    return tightest;
+}
+
+void CgroupCpuMonitor::update() {
+    if (!stats.available) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsedSeconds = now - lastSample;
+    double elapsed = elapsedSeconds.count();
+    lastSample = now;
+
+    long long usageUsec = 0, periods = 0, throttled = 0, throttledTime = 0;
+    if (v1) {
+        KeyField fields[] = {{"nr_periods", &periods}, {"nr_throttled", &throttled}, {"throttled_time", &throttledTime}};
+        if (cpuStatFile.read()) parseKeyTable(cpuStatFile.view(), fields, 3);
+        if (usageFile.read()) usageUsec = strtoll(usageFile.data(), nullptr, 10) / 1000;
+        throttledTime /= 1000; // ns -> us
+    } else {
+        KeyField fields[] = {
+            {"usage_usec", &usageUsec}, {"nr_periods", &periods}, {"nr_throttled", &throttled},
+            {"throttled_usec", &throttledTime},
+        };
+        if (cpuStatFile.read()) parseKeyTable(cpuStatFile.view(), fields, 4);
+    }
+
+    double quotaCores = readQuotaCores();
+    stats.limited = quotaCores > 0;
+    stats.quotaCores = stats.limited ? std::min(quotaCores, static_cast<double>(onlineCpus)) : onlineCpus;
+    stats.totalThrottles = throttled;
+
+    if (hasPrev && elapsed > 0) {
+        auto delta = [](unsigned long long current, unsigned long long previous) {
+            return current >= previous ? static_cast<double>(current - previous) : 0.0;
+        };
+        stats.usageCores = delta(usageUsec, prevUsageUsec) / 1e6 / elapsed;
+        stats.quotaPercent = stats.usageCores / stats.quotaCores * 100.0;
+        double periodDelta = delta(periods, prevPeriods);
+        double throttledDelta = delta(throttled, prevThrottled);
+        stats.throttledPercent = periodDelta > 0 ? throttledDelta / periodDelta * 100.0 : 0.0;
+        stats.throttlesPerSec = throttledDelta / elapsed;
+        stats.throttledMsPerSec = delta(throttledTime, prevThrottledUsec) / 1000.0 / elapsed;
+    }
+    prevUsageUsec = usageUsec;
+    prevPeriods = periods;
+    prevThrottled = throttled;
+    prevThrottledUsec = throttledTime;
+    hasPrev = true;
+}
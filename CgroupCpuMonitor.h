@@ -0,0 +1,60 @@
+#ifndef CGROUP_CPU_MONITOR_H
+#define CGROUP_CPU_MONITOR_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct CgroupCpuStats {
+    bool available = false;
+    std::string path;              // cgroup path as seen in /proc/self/cgroup
+    bool limited = false;          // a cpu.max / cfs quota applies here or on an ancestor
+    double quotaCores = 0.0;       // tightest quota on the path, in CPUs
+    double usageCores = 0.0;       // CPUs' worth of time used over the last interval
+    double quotaPercent = 0.0;     // usage against the quota, or against all online CPUs when unlimited
+    double throttledPercent = 0.0; // share of enforcement periods that hit the quota
+    double throttledMsPerSec = 0.0;
+    double throttlesPerSec = 0.0;
+    long long totalThrottles = 0;  // nr_throttled since the cgroup was created
+};
+
+class CgroupCpuMonitor {
+public:
+    // CPU usage normalized to the cgroup quota, plus CFS throttling. Works on cgroup v2 (cpu.max,
+    // cpu.stat) and falls back to the v1 cpu,cpuacct controller.
+    explicit CgroupCpuMonitor(const std::string& cgroupRoot = "/sys/fs/cgroup", const std::string& procRoot = "/proc");
+
+    // Empty means the cgroup this process runs in.
+    void setCgroupPath(const std::string& path);
+    void update();
+    const CgroupCpuStats& getStats() const { return stats; }
+
+private:
+    struct Quota {
+        ProcFile max;     // v2 "quota period" or "max period"
+        ProcFile quota;   // v1 cpu.cfs_quota_us
+        ProcFile period;  // v1 cpu.cfs_period_us
+    };
+
+    std::string cgroupRoot;
+    std::string procRoot;
+    std::string configuredPath;
+    bool v1;
+    std::vector<Quota> quotas;     // this cgroup and every ancestor, limits nest
+    ProcFile cpuStatFile;
+    ProcFile usageFile;            // v1 cpuacct.usage, ns
+    unsigned long long prevUsageUsec;
+    unsigned long long prevPeriods;
+    unsigned long long prevThrottled;
+    unsigned long long prevThrottledUsec;
+    bool hasPrev;
+    int onlineCpus;
+    std::chrono::steady_clock::time_point lastSample;
+    CgroupCpuStats stats;
+
+    void open();
+    double readQuotaCores();
+};
+
+#endif
@@ -0,0 +1,246 @@
+#include "CollectorPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+CollectorPool::CollectorPool(int threads) : stopping(false) {
+    readyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    for (int i = 0; i < std::max(1, threads); ++i) {
+        workers.emplace_back(&CollectorPool::work, this);
+    }
+}
+
+CollectorPool::~CollectorPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    // A worker stuck in a read still has to come back before the collectors it uses go away.
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (readyFd >= 0) {
+        close(readyFd);
+    }
+}
+
+int CollectorPool::addSource(const std::string& name, std::chrono::milliseconds deadline,
+                             std::function<void()> collect, std::function<void()> publish,
+                             std::function<double()> signal) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Source source;
+    source.collect = std::move(collect);
+    source.publish = std::move(publish);
+    source.signal = std::move(signal);
+    source.deadline = deadline;
+    source.allocations = AllocGuard(name);
+    sources.push_back(std::move(source));
+
+    CollectorStatus entry;
+    entry.name = name;
+    entry.deadlineMs = static_cast<double>(deadline.count());
+    status.push_back(entry);
+    return static_cast<int>(sources.size()) - 1;
+}
+
+void CollectorPool::setIntervalBounds(int minMs, int maxMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t id = 0; id < sources.size(); ++id) {
+        sources[id].rate.setBounds(minMs, maxMs);
+        status[id].intervalMs = sources[id].signal ? sources[id].rate.getIntervalMs() : 0;
+    }
+}
+
+void CollectorPool::snapAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t id = 0; id < sources.size(); ++id) {
+        sources[id].rate.snap();
+        status[id].intervalMs = sources[id].signal ? sources[id].rate.getIntervalMs() : 0;
+    }
+}
+
+void CollectorPool::setEnabled(int id, bool enabled) {
+    status[id].enabled = enabled;
+}
+
+bool CollectorPool::isRunning(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sources[id].running;
+}
+
+bool CollectorPool::isStale(int id) const {
+    return status[id].stale;
+}
+
+std::chrono::steady_clock::time_point CollectorPool::nextDue() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Clock::time_point due = Clock::time_point::max();
+    for (size_t id = 0; id < sources.size(); ++id) {
+        // A source without a signal still keeps its rate's last ran() time, which is when a
+        // straggler's result gets picked up too.
+        if (status[id].enabled) {
+            due = std::min(due, sources[id].rate.getNextDue());
+        }
+    }
+    return due;
+}
+
+void CollectorPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) {
+            return;
+        }
+        int id = queue.front();
+        queue.erase(queue.begin());
+        Source& source = sources[id];
+        lock.unlock();
+        source.allocations.begin();
+        source.collect();
+        source.allocations.end();
+        lock.lock();
+        source.lastDuration = Clock::now() - source.started;
+        source.running = false;
+        source.finished = true;
+        if (!source.awaited && readyFd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = write(readyFd, &one, sizeof(one));
+            (void)ignored;
+        }
+        taskDone.notify_all();
+    }
+}
+
+void CollectorPool::finishLocked(int id) {
+    Source& source = sources[id];
+    CollectorStatus& entry = status[id];
+    source.finished = false;
+    entry.running = false;
+    entry.lastMs = std::chrono::duration<double, std::milli>(source.lastDuration).count();
+    entry.allocations = source.allocations.getLast();
+    if (source.lastDuration > source.deadline) {
+        // Already counted if the round gave up waiting on it.
+        if (!source.late) entry.overruns++;
+        entry.stale = true;
+        source.skipNext = true;
+    } else {
+        entry.stale = false;
+    }
+    source.late = false;
+    ready.push_back(id);
+}
+
+void CollectorPool::checkLateLocked(int id, Clock::time_point now) {
+    // Still running: counted as an overrun once, as soon as anyone looks after its deadline.
+    Source& source = sources[id];
+    CollectorStatus& entry = status[id];
+    entry.running = true;
+    if (!source.late && now - source.started > source.deadline) {
+        source.late = true;
+        entry.stale = true;
+        entry.overruns++;
+    }
+}
+
+void CollectorPool::startRound() {
+    ready.clear();
+    submitted.clear();
+    Clock::duration longest{};
+    Clock::time_point now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int id = 0; id < static_cast<int>(sources.size()); ++id) {
+            Source& source = sources[id];
+            CollectorStatus& entry = status[id];
+            if (source.finished) {
+                // Came back after finishRound() stopped waiting and nobody published it since. One
+                // that overran sits this round out below, which is its skip.
+                finishLocked(id);
+            }
+            if (source.running) {
+                checkLateLocked(id, now);
+                continue;
+            }
+            if (!entry.enabled) {
+                entry.stale = false;
+                continue;
+            }
+            if (source.skipNext) {
+                source.skipNext = false;
+                continue;
+            }
+            if (source.signal && !source.rate.isDue(now)) {
+                continue;
+            }
+            // The deadline covers time spent queued behind other sources too.
+            source.rate.ran(now);
+            source.running = true;
+            source.awaited = true;
+            source.started = now;
+            queue.push_back(id);
+            submitted.push_back(id);
+            longest = std::max(longest, source.deadline);
+        }
+    }
+    roundDeadline = Clock::now() + longest;
+    if (!submitted.empty()) {
+        workAvailable.notify_all();
+    }
+    publishReady();
+}
+
+void CollectorPool::finishRound() {
+    ready.clear();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        taskDone.wait_until(lock, std::min(roundDeadline, Clock::now() + kCallerWait), [this] {
+            return std::none_of(submitted.begin(), submitted.end(), [this](int id) { return sources[id].running; });
+        });
+        Clock::time_point now = Clock::now();
+        for (int id : submitted) {
+            sources[id].awaited = false;
+            if (sources[id].finished) {
+                finishLocked(id);
+            } else {
+                checkLateLocked(id, now);
+            }
+        }
+    }
+
+    publishReady();
+}
+
+bool CollectorPool::publishFinished() {
+    uint64_t drained;
+    ssize_t ignored = read(readyFd, &drained, sizeof(drained));
+    (void)ignored;
+    ready.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Clock::time_point now = Clock::now();
+        for (int id = 0; id < static_cast<int>(sources.size()); ++id) {
+            if (sources[id].finished) {
+                finishLocked(id);
+            } else if (sources[id].running) {
+                checkLateLocked(id, now);
+            }
+        }
+    }
+    publishReady();
+    return !ready.empty();
+}
+
+void CollectorPool::publishReady() {
+    // The workers are done with these until they are queued again, so their results can be copied out.
+    for (int id : ready) {
+        Source& source = sources[id];
+        source.publish();
+        if (source.signal) {
+            source.rate.observe({source.signal()});
+            status[id].intervalMs = source.rate.getIntervalMs();
+        }
+    }
+}
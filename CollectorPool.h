@@ -0,0 +1,106 @@
+#ifndef COLLECTOR_POOL_H
+#define COLLECTOR_POOL_H
+
+#include "AdaptiveInterval.h"
+#include "AllocGuard.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CollectorStatus {
+    std::string name;
+    bool enabled = false;
+    bool stale = false;       // missed its deadline; the values shown are from an earlier round
+    bool running = false;     // still in flight on a worker
+    double lastMs = 0.0;      // how long the last completed run took
+    double deadlineMs = 0.0;
+    int intervalMs = 0;       // current adaptive interval, 0 when it runs every round
+    int overruns = 0;
+    long long allocations = 0; // heap allocations in the last run, in STATSBY_ALLOC_GUARD builds
+};
+
+class CollectorPool {
+public:
+    // Runs collectors on a few worker threads so one source stuck in a slow read (an ACPI thermal
+    // zone, a hung NFS mount, nvidia-smi) can't hold up the rest. Each source is split into a
+    // collect step that runs on a worker and a publish step that copies its results out on the
+    // caller's thread, so readers never see a collector halfway through an update.
+    explicit CollectorPool(int threads = 2);
+    ~CollectorPool();
+    CollectorPool(const CollectorPool&) = delete;
+    CollectorPool& operator=(const CollectorPool&) = delete;
+
+    // Returns the id used by the other calls; ids count up from 0 in registration order.
+    // With a signal, the source runs on an AdaptiveInterval fed with signal() after each publish;
+    // without one it runs every round.
+    int addSource(const std::string& name, std::chrono::milliseconds deadline, std::function<void()> collect,
+                  std::function<void()> publish, std::function<double()> signal = nullptr);
+    void setIntervalBounds(int minMs, int maxMs);
+    void snapAll();
+    void setEnabled(int id, bool enabled);
+    bool isRunning(int id) const;
+    bool isStale(int id) const;
+    // When the earliest enabled source is next due, or time_point::max() with none enabled.
+    std::chrono::steady_clock::time_point nextDue() const;
+
+    // startRound() publishes whatever finished since last time and hands the due sources to the
+    // workers; finishRound() waits a few ms for them, so the caller can do its own work in between
+    // and quick sources still land in the same round. Slower ones finish in the background: the
+    // worker signals getReadyFd() and the caller publishes them with publishFinished(). A source
+    // that runs past its deadline is marked stale and skipped for the next round.
+    void startRound();
+    void finishRound();
+    // Returns true when something was published. Drains getReadyFd().
+    bool publishFinished();
+    // An eventfd that becomes readable when a source finishes after finishRound() stopped waiting.
+    int getReadyFd() const { return readyFd; }
+    const std::vector<CollectorStatus>& getStatus() const { return status; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // The longest finishRound() blocks the caller, which is the UI thread: well under a frame.
+    static constexpr std::chrono::milliseconds kCallerWait{4};
+
+    struct Source {
+        std::function<void()> collect;
+        std::function<void()> publish;
+        std::function<double()> signal;
+        AdaptiveInterval rate;
+        AllocGuard allocations{""};
+        Clock::duration deadline;
+        Clock::time_point started;
+        Clock::duration lastDuration{};
+        bool running = false;
+        bool finished = false;  // collected but not yet published
+        bool skipNext = false;
+        bool late = false;      // already counted as an overrun
+        bool awaited = false;   // finishRound() is still waiting on it, so no need to signal
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable taskDone;
+    std::vector<int> queue; // FIFO; a vector so steady-state rounds don't allocate
+    std::vector<Source> sources;
+    std::vector<std::thread> workers;
+    bool stopping;
+    int readyFd;
+
+    // Only touched on the caller's thread.
+    std::vector<CollectorStatus> status;
+    std::vector<int> submitted;
+    std::vector<int> ready;
+    Clock::time_point roundDeadline;
+
+    void work();
+    void finishLocked(int id);
+    void checkLateLocked(int id, Clock::time_point now);
+    void publishReady();
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "CompressedMemoryMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+
+CompressedMemoryMonitor::CompressedMemoryMonitor() {
+    DIR* dir = opendir("/sys/block");
+    if (dir) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            std::string name = ent->d_name;
+            if (name.rfind("zram", 0) == 0) {
+                ZramDevice device;
+                if (device.mmStat.open("/sys/block/" + name + "/mm_stat")) {
+                    zramDevices.push_back(std::move(device));
+                    ZramDeviceStats deviceStats;
+                    deviceStats.name = name;
+                    stats.zram.push_back(deviceStats);
+                }
+            }
+        }
+        closedir(dir);
+    }
+
+    meminfoFile.open("/proc/meminfo");
+    vmstatFile.open("/proc/vmstat");
+    thpEnabledFile.open("/sys/kernel/mm/transparent_hugepage/enabled");
+    zswapEnabledFile.open("/sys/module/zswap/parameters/enabled");
+    zswapPoolFile.open("/sys/kernel/debug/zswap/pool_total_size");
+    zswapStoredFile.open("/sys/kernel/debug/zswap/stored_pages");
+    lastSample = std::chrono::steady_clock::now();
+}
+
+void CompressedMemoryMonitor::updateZram() {
+    // mm_stat: orig_data_size compr_data_size mem_used_total mem_limit mem_used_max same_pages ...
+    stats.zramOriginalBytes = 0;
+    stats.zramUsedBytes = 0;
+    for (size_t i = 0; i < zramDevices.size(); ++i) {
+        ZramDeviceStats& out = stats.zram[i];
+        if (!zramDevices[i].mmStat.read()) {
+            continue;
+        }
+        char* next = nullptr;
+        out.originalBytes = strtoll(zramDevices[i].mmStat.data(), &next, 10);
+        out.compressedBytes = strtoll(next, &next, 10);
+        out.usedBytes = strtoll(next, &next, 10);
+        out.ratio = out.compressedBytes > 0 ? static_cast<double>(out.originalBytes) / out.compressedBytes : 0.0;
+        stats.zramOriginalBytes += out.originalBytes;
+        stats.zramUsedBytes += out.usedBytes;
+    }
+    stats.zramRatio = stats.zramUsedBytes > 0 ? static_cast<double>(stats.zramOriginalBytes) / stats.zramUsedBytes : 0.0;
+}
+
+void CompressedMemoryMonitor::updateMeminfo() {
+    long long zswapKb = -1;
+    long long zswappedKb = -1;
+    const KeyField fields[] = {
+        {"HugePages_Total", &stats.hugePagesTotal},
+        {"HugePages_Free", &stats.hugePagesFree},
+        {"Hugepagesize", &stats.hugePageSize},
+        {"AnonHugePages", &stats.anonHugePages},
+        {"Zswap", &zswapKb},
+        {"Zswapped", &zswappedKb},
+    };
+    if (meminfoFile.read()) {
+        parseKeyTable(meminfoFile.view(), fields, 6);
+    }
+
+    stats.zswapEnabled = zswapEnabledFile.read() && zswapEnabledFile.size() > 0 && zswapEnabledFile.data()[0] == 'Y';
+    if (zswapKb >= 0 && zswappedKb >= 0) {
+        // 5.19+ reports the pool in meminfo, no debugfs needed.
+        stats.zswapPoolBytes = zswapKb * 1024;
+        stats.zswapStoredBytes = zswappedKb * 1024;
+    } else if (zswapPoolFile.read() && zswapStoredFile.read()) {
+        stats.zswapPoolBytes = strtoll(zswapPoolFile.data(), nullptr, 10);
+        stats.zswapStoredBytes = strtoll(zswapStoredFile.data(), nullptr, 10) * sysconf(_SC_PAGESIZE);
+    } else {
+        stats.zswapPoolBytes = 0;
+        stats.zswapStoredBytes = 0;
+    }
+    stats.zswapRatio = stats.zswapPoolBytes > 0 ? static_cast<double>(stats.zswapStoredBytes) / stats.zswapPoolBytes : 0.0;
+}
+
+void CompressedMemoryMonitor::updateThp() {
+    if (thpEnabledFile.read()) {
+        std::string_view text = thpEnabledFile.view();
+        size_t open = text.find('[');
+        size_t close = text.find(']', open);
+        if (open != std::string_view::npos && close != std::string_view::npos) {
+            std::string_view mode = text.substr(open + 1, close - open - 1);
+            if (stats.thpMode != mode) {
+                stats.thpMode.assign(mode);
+            }
+        }
+    }
+
+    long long current[5] = {};
+    const KeyField fields[] = {
+        {"thp_fault_alloc", &current[0]},
+        {"thp_fault_fallback", &current[1]},
+        {"thp_collapse_alloc", &current[2]},
+        {"thp_collapse_alloc_failed", &current[3]},
+        {"thp_split_page", &current[4]},
+    };
+    if (!vmstatFile.read() || parseKeyTable(vmstatFile.view(), fields, 5) == 0) {
+        hasPrev = false;
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+    if (hasPrev && elapsed.count() > 0) {
+        double* rates[] = {&stats.thpFaultAllocRate, &stats.thpFaultFallbackRate, &stats.thpCollapseAllocRate,
+                           &stats.thpCollapseFailedRate, &stats.thpSplitRate};
+        for (int i = 0; i < 5; ++i) {
+            *rates[i] = std::max(0LL, current[i] - thpCounters[i]) / elapsed.count();
+        }
+    }
+    std::copy(current, current + 5, thpCounters);
+    hasPrev = true;
+}
+
+void CompressedMemoryMonitor::update() {
+    updateZram();
+    updateMeminfo();
+    updateThp();
+}
+
+long long CompressedMemoryMonitor::getUncompressedDemand(const CompressedMemoryStats& stats, long long usedKb) {
+    // The compressed copies (zram's mem_used_total, the zswap pool) are already inside usedKb, so
+    // swap them for the original sizes rather than adding those on top.
+    long long compressedKb = (stats.zramUsedBytes + stats.zswapPoolBytes) / 1024;
+    long long originalKb = (stats.zramOriginalBytes + stats.zswapStoredBytes) / 1024;
+    return usedKb - compressedKb + originalKb;
+}
@@ -0,0 +1,73 @@
+#ifndef COMPRESSED_MEMORY_MONITOR_H
+#define COMPRESSED_MEMORY_MONITOR_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct ZramDeviceStats {
+    std::string name;
+    long long originalBytes = 0;   // uncompressed size of what's stored
+    long long compressedBytes = 0; // size after compression
+    long long usedBytes = 0;       // RAM the device really takes, allocator overhead included
+    double ratio = 0.0;
+};
+
+struct CompressedMemoryStats {
+    std::vector<ZramDeviceStats> zram;
+    long long zramOriginalBytes = 0;
+    long long zramUsedBytes = 0;
+    double zramRatio = 0.0;
+
+    bool zswapEnabled = false;
+    long long zswapStoredBytes = 0; // uncompressed size of pages held in the pool
+    long long zswapPoolBytes = 0;   // RAM the pool takes
+    double zswapRatio = 0.0;
+
+    long long hugePagesTotal = 0;
+    long long hugePagesFree = 0;
+    long long hugePageSize = 0;     // KB
+    long long anonHugePages = 0;    // KB backed by THP
+    std::string thpMode;            // the bracketed entry of transparent_hugepage/enabled
+    double thpFaultAllocRate = 0.0;
+    double thpFaultFallbackRate = 0.0;
+    double thpCollapseAllocRate = 0.0;
+    double thpCollapseFailedRate = 0.0;
+    double thpSplitRate = 0.0;
+};
+
+class CompressedMemoryMonitor {
+public:
+    // zram, zswap and huge page accounting, so memory held compressed in RAM isn't invisible.
+    CompressedMemoryMonitor();
+    void update();
+    const CompressedMemoryStats& getStats() const { return stats; }
+
+    // What "used" would be if nothing were compressed: resident use with the zram/zswap pools
+    // counted at their uncompressed size.
+    static long long getUncompressedDemand(const CompressedMemoryStats& stats, long long usedKb);
+
+private:
+    struct ZramDevice {
+        ProcFile mmStat;
+    };
+
+    std::vector<ZramDevice> zramDevices;
+    ProcFile meminfoFile;
+    ProcFile vmstatFile;
+    ProcFile thpEnabledFile;
+    ProcFile zswapEnabledFile;
+    ProcFile zswapPoolFile;   // debugfs fallback for kernels without Zswap: in meminfo
+    ProcFile zswapStoredFile;
+    long long thpCounters[5] = {};
+    bool hasPrev = false;
+    std::chrono::steady_clock::time_point lastSample;
+    CompressedMemoryStats stats;
+
+    void updateZram();
+    void updateMeminfo();
+    void updateThp();
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "ConfigManager.h"
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <iostream>
 #include <filesystem>
 #include <limits.h> 
@@ -8,6 +9,29 @@
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// std::stoi/stof, but "12abc" is an error too rather than 12.
+int toInt(const std::string& value) {
+    size_t used = 0;
+    int result = std::stoi(value, &used);
+    if (used != value.size()) {
+        throw std::invalid_argument(value);
+    }
+    return result;
+}
+
+float toFloat(const std::string& value) {
+    size_t used = 0;
+    float result = std::stof(value, &used);
+    if (used != value.size()) {
+        throw std::invalid_argument(value);
+    }
+    return result;
+}
+
+} // namespace
+
 ConfigManager::ConfigManager(const std::string& filename)
     : configFilename(filename) {}
 
@@ -23,50 +47,84 @@ std::string ConfigManager::get_config_path() {
     return configFilename;
 }
 
-void ConfigManager::loadConfig(AppConfig& config) {
+bool ConfigManager::loadConfig(AppConfig& config) {
     // Tries to load settings from the config file. If it's not there, just uses defaults.
+    // The file is read into a fresh AppConfig, so a key deleted from it goes back to its default,
+    // and config only changes if every line parsed: a typo saved while the overlay runs keeps the
+    // current settings instead of taking the process down.
     std::string path = get_config_path();
     std::ifstream file(path);
     if (!file.is_open()) {
         std::cerr << "Config file not found or could not be opened: " << path << ". Using default settings." << std::endl;
-        return; 
+        return false;
     }
+    AppConfig parsed;
 
     std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        if (std::getline(iss, key, '=')) {
-            std::string value;
-            if (std::getline(iss, value)) {
+    std::string key;
+    int lineNumber = 0;
+    try {
+        while (std::getline(file, line)) {
+            lineNumber++;
+            std::istringstream iss(line);
+            if (std::getline(iss, key, '=')) {
+                std::string value;
+                if (std::getline(iss, value)) {
                 
-                key.erase(0, key.find_first_not_of(" \t\r\n"));
-                key.erase(key.find_last_not_of(" \t\r\n") + 1);
-                value.erase(0, value.find_first_not_of(" \t\r\n"));
-                value.erase(value.find_last_not_of(" \t\r\n") + 1);
+                    key.erase(0, key.find_first_not_of(" \t\r\n"));
+                    key.erase(key.find_last_not_of(" \t\r\n") + 1);
+                    value.erase(0, value.find_first_not_of(" \t\r\n"));
+                    value.erase(value.find_last_not_of(" \t\r\n") + 1);
 
-                if (key == "enable_fading_colors") config.enable_fading_colors = (value == "true");
-                else if (key == "hue_speed") config.hue_speed = std::stof(value);
-                else if (key == "text_color_r") config.text_color.x = std::stof(value);
-                else if (key == "text_color_g") config.text_color.y = std::stof(value);
-                else if (key == "text_color_b") config.text_color.z = std::stof(value);
-                else if (key == "text_color_a") config.text_color.w = std::stof(value);
-                else if (key == "show_cpu_usage") config.show_cpu_usage = (value == "true");
-                else if (key == "show_cpu_temp") config.show_cpu_temp = (value == "true");
-                else if (key == "show_memory_stats") config.show_memory_stats = (value == "true");
-                else if (key == "show_net_down") config.show_net_down = (value == "true");
-                else if (key == "show_net_up") config.show_net_up = (value == "true");
-                else if (key == "show_ping") config.show_ping = (value == "true");
-                else if (key == "show_gpu_usage") config.show_gpu_usage = (value == "true");
-                else if (key == "show_gpu_mem") config.show_gpu_mem = (value == "true");
-                else if (key == "show_gpu_temp") config.show_gpu_temp = (value == "true");
-                else if (key == "show_fps") config.show_fps = (value == "true");
-                else if (key == "show_app_cpu") config.show_app_cpu = (value == "true");
-                else if (key == "show_app_mem") config.show_app_mem = (value == "true");
+                    if (key == "enable_fading_colors") parsed.enable_fading_colors = (value == "true");
+                    else if (key == "hue_speed") parsed.hue_speed = toFloat(value);
+                    else if (key == "text_color_r") parsed.text_color.x = toFloat(value);
+                    else if (key == "text_color_g") parsed.text_color.y = toFloat(value);
+                    else if (key == "text_color_b") parsed.text_color.z = toFloat(value);
+                    else if (key == "text_color_a") parsed.text_color.w = toFloat(value);
+                    else if (const MetricDescriptor* metric = findMetricByShowKey(key))
+                        parsed.show_metrics[static_cast<size_t>(metric->id)] = (value == "true");
+                    else if (key == "show_cgroup_cpu") parsed.show_cgroup_cpu = (value == "true");
+                    else if (key == "show_tcp") parsed.show_tcp = (value == "true");
+                    else if (key == "show_packet_drops") parsed.show_packet_drops = (value == "true");
+                    else if (key == "show_gpu_processes") parsed.show_gpu_processes = (value == "true");
+                    else if (key == "show_probes") parsed.show_probes = (value == "true");
+                    else if (key == "show_interrupts") parsed.show_interrupts = (value == "true");
+                    else if (key == "show_perf_counters") parsed.show_perf_counters = (value == "true");
+                    else if (key == "show_runqueue_latency") parsed.show_runqueue_latency = (value == "true");
+                    else if (key == "show_numa") parsed.show_numa = (value == "true");
+                    else if (key == "show_compressed_memory") parsed.show_compressed_memory = (value == "true");
+                    else if (key == "show_hugepages") parsed.show_hugepages = (value == "true");
+                    else if (key == "probe_targets") parsed.probe_targets = value;
+                    else if (key == "probe_interval_ms") parsed.probe_interval_ms = toInt(value);
+                    else if (key == "probe_timeout_ms") parsed.probe_timeout_ms = toInt(value);
+                    else if (key == "cgroup_path") parsed.cgroup_path = value;
+                    else if (key == "show_kernel_events") parsed.show_kernel_events = (value == "true");
+                    else if (key == "show_spike_captures") parsed.show_spike_captures = (value == "true");
+                    else if (key == "spike_cpu_threshold") parsed.spike_cpu_threshold = toFloat(value);
+                    else if (key == "spike_memory_pressure") parsed.spike_memory_pressure = toFloat(value);
+                    else if (key == "spike_io_pressure") parsed.spike_io_pressure = toFloat(value);
+                    else if (key == "spike_history") parsed.spike_history = toInt(value);
+                    else if (key == "burst_seconds") parsed.burst_seconds = toInt(value);
+                    else if (key == "burst_on_trigger") parsed.burst_on_trigger = (value == "true");
+                    else if (key == "burst_cpu") parsed.burst_cpu = toInt(value);
+                    else if (key == "adaptive_sampling") parsed.adaptive_sampling = (value == "true");
+                    else if (key == "sample_min_ms") parsed.sample_min_ms = toInt(value);
+                    else if (key == "sample_max_ms") parsed.sample_max_ms = toInt(value);
+                    else if (key == "io_uring_reads") parsed.io_uring_reads = (value == "true");
+                    else if (key == "show_custom_metrics") parsed.show_custom_metrics = (value == "true");
+                    else if (key == "custom_metric") parsed.custom_metrics.push_back(value);
+                }
             }
         }
+    } catch (const std::logic_error&) { // invalid_argument or out_of_range from the conversions
+        std::cerr << "Config " << path << ":" << lineNumber << ": bad value for " << key
+                  << ", keeping the current settings." << std::endl;
+        return false;
     }
     file.close();
+    config = parsed;
+    return true;
 }
 
 void ConfigManager::saveConfig(const AppConfig& config) {
@@ -84,18 +142,44 @@ void ConfigManager::saveConfig(const AppConfig& config) {
     file << "text_color_g=" << config.text_color.y << "\n";
     file << "text_color_b=" << config.text_color.z << "\n";
     file << "text_color_a=" << config.text_color.w << "\n";
-    file << "show_cpu_usage=" << (config.show_cpu_usage ? "true" : "false") << "\n";
-    file << "show_cpu_temp=" << (config.show_cpu_temp ? "true" : "false") << "\n";
-    file << "show_memory_stats=" << (config.show_memory_stats ? "true" : "false") << "\n";
-    file << "show_net_down=" << (config.show_net_down ? "true" : "false") << "\n";
-    file << "show_net_up=" << (config.show_net_up ? "true" : "false") << "\n";
-    file << "show_ping=" << (config.show_ping ? "true" : "false") << "\n";
-    file << "show_gpu_usage=" << (config.show_gpu_usage ? "true" : "false") << "\n";
-    file << "show_gpu_mem=" << (config.show_gpu_mem ? "true" : "false") << "\n";
-    file << "show_gpu_temp=" << (config.show_gpu_temp ? "true" : "false") << "\n";
-    file << "show_fps=" << (config.show_fps ? "true" : "false") << "\n";
-    file << "show_app_cpu=" << (config.show_app_cpu ? "true" : "false") << "\n";
-    file << "show_app_mem=" << (config.show_app_mem ? "true" : "false") << "\n";
+    for (const MetricDescriptor& metric : kMetrics) {
+        if (metric.showKey) {
+            file << metric.showKey << "=" << (config.show_metrics[static_cast<size_t>(metric.id)] ? "true" : "false")
+                 << "\n";
+        }
+    }
+    file << "show_cgroup_cpu=" << (config.show_cgroup_cpu ? "true" : "false") << "\n";
+    file << "show_tcp=" << (config.show_tcp ? "true" : "false") << "\n";
+    file << "show_packet_drops=" << (config.show_packet_drops ? "true" : "false") << "\n";
+    file << "show_gpu_processes=" << (config.show_gpu_processes ? "true" : "false") << "\n";
+    file << "show_probes=" << (config.show_probes ? "true" : "false") << "\n";
+    file << "show_interrupts=" << (config.show_interrupts ? "true" : "false") << "\n";
+    file << "show_perf_counters=" << (config.show_perf_counters ? "true" : "false") << "\n";
+    file << "show_runqueue_latency=" << (config.show_runqueue_latency ? "true" : "false") << "\n";
+    file << "show_numa=" << (config.show_numa ? "true" : "false") << "\n";
+    file << "show_compressed_memory=" << (config.show_compressed_memory ? "true" : "false") << "\n";
+    file << "show_hugepages=" << (config.show_hugepages ? "true" : "false") << "\n";
+    file << "probe_targets=" << config.probe_targets << "\n";
+    file << "probe_interval_ms=" << config.probe_interval_ms << "\n";
+    file << "probe_timeout_ms=" << config.probe_timeout_ms << "\n";
+    file << "cgroup_path=" << config.cgroup_path << "\n";
+    file << "show_kernel_events=" << (config.show_kernel_events ? "true" : "false") << "\n";
+    file << "show_spike_captures=" << (config.show_spike_captures ? "true" : "false") << "\n";
+    file << "spike_cpu_threshold=" << config.spike_cpu_threshold << "\n";
+    file << "spike_memory_pressure=" << config.spike_memory_pressure << "\n";
+    file << "spike_io_pressure=" << config.spike_io_pressure << "\n";
+    file << "spike_history=" << config.spike_history << "\n";
+    file << "burst_seconds=" << config.burst_seconds << "\n";
+    file << "burst_on_trigger=" << (config.burst_on_trigger ? "true" : "false") << "\n";
+    file << "burst_cpu=" << config.burst_cpu << "\n";
+    file << "adaptive_sampling=" << (config.adaptive_sampling ? "true" : "false") << "\n";
+    file << "sample_min_ms=" << config.sample_min_ms << "\n";
+    file << "sample_max_ms=" << config.sample_max_ms << "\n";
+    file << "io_uring_reads=" << (config.io_uring_reads ? "true" : "false") << "\n";
+    file << "show_custom_metrics=" << (config.show_custom_metrics ? "true" : "false") << "\n";
+    for (const std::string& metric : config.custom_metrics) {
+        file << "custom_metric=" << metric << "\n";
+    }
 
     file.close();
 }
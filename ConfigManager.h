@@ -2,6 +2,7 @@
 #define CONFIG_MANAGER_H
 
 #include "imgui.h" 
+#include "MetricRegistry.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -12,32 +13,73 @@ struct AppConfig {
     float hue_speed = 0.05f;
     ImVec4 text_color = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); 
 
-    
-    bool show_cpu_usage = true;
-    bool show_cpu_temp = true;
-    bool show_memory_stats = true;
-    bool show_net_down = true;
-    bool show_net_up = true;
-    bool show_ping = true;
-    bool show_gpu_usage = true;
-    bool show_gpu_mem = true;
-    bool show_gpu_temp = true;
-    bool show_fps = true;
+    // One toggle per registered metric, saved under its descriptor's showKey (show_cpu_usage, ...).
+    MetricVisibility show_metrics = defaultMetricVisibility();
 
     
-    bool show_app_cpu = true;
-    bool show_app_mem = true;
+    bool show_cgroup_cpu = false;
+    bool show_tcp = false;
+    bool show_packet_drops = false;
+    bool show_gpu_processes = false;
+    bool show_probes = false;
+    bool show_interrupts = false;
+    bool show_perf_counters = false;
+    bool show_runqueue_latency = false;
+    bool show_numa = false;
+    bool show_compressed_memory = false;
+    bool show_hugepages = false;
+
+    // TCP latency probes. The first target is what the "Ping" line shows.
+    std::string probe_targets = "8.8.8.8:53";
+    int probe_interval_ms = 5000;
+    int probe_timeout_ms = 1000;
+
+    // Cgroup whose cpu.max/cpu.stat the cgroup CPU line reads. Empty means our own, which is the pod
+    // or container when running inside one.
+    std::string cgroup_path = "";
+
+    // Spike capture: a detailed snapshot whenever CPU % or memory/IO PSI avg10 crosses a threshold (0 = off).
+    bool show_kernel_events = false;
+    bool show_spike_captures = false;
+    float spike_cpu_threshold = 90.0f;
+    float spike_memory_pressure = 10.0f;
+    float spike_io_pressure = 20.0f;
+    int spike_history = 8;
+
+    // Burst capture: 100 Hz CPU, per-core, runqueue and PSI samples for burst_seconds, started with
+    // F2, from the config window, or on a spike/PSI trigger with burst_on_trigger. burst_cpu is the
+    // CPU the sampler is pinned to; -1 picks the first one not isolated or nohz_full.
+    int burst_seconds = 5;
+    bool burst_on_trigger = false;
+    int burst_cpu = -1;
+
+    // Each source samples between these bounds depending on how much its values move.
+    // Off means a fixed one second, as before.
+    bool adaptive_sampling = true;
+    int sample_min_ms = 250;
+    int sample_max_ms = 5000;
+    // Read the per-tick sysfs counters (NIC statistics, GPU) as one io_uring batch where the
+    // kernel allows it; off, or when io_uring is unavailable, each file is pread. Off by default:
+    // it saves syscalls but sysfs reads go through io-wq workers, so it costs more CPU, not less
+    // (see bench/ProcFileBatchBench.cpp).
+    bool io_uring_reads = false;
+
+    // Site-specific values, one "custom_metric=" line each, e.g.
+    // custom_metric=name=Queue;key=depth;interval=5000;timeout=2000;exec=/usr/local/bin/qstat -s
+    bool show_custom_metrics = true;
+    std::vector<std::string> custom_metrics;
 };
 
 class ConfigManager {
 public:
     ConfigManager(const std::string& filename);
-    void loadConfig(AppConfig& config);
+    // False, with config untouched, when the file is missing or a value doesn't parse.
+    bool loadConfig(AppConfig& config);
     void saveConfig(const AppConfig& config);
+    std::string get_config_path();
 
 private:
     std::string configFilename;
-    std::string get_config_path();
 };
 
 #endif 
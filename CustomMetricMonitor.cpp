@@ -0,0 +1,287 @@
+#include "CustomMetricMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kMaxStreamLine = 64 * 1024; // a stream that never sends a newline doesn't get to grow forever
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// Whitespace-separated words with '...' and "..." quoting; there is no shell, so nothing else is special.
+std::vector<std::string> splitCommand(const std::string& command) {
+    std::vector<std::string> argv;
+    std::string word;
+    bool inWord = false;
+    char quote = 0;
+    for (char c : command) {
+        if (quote) {
+            if (c == quote) quote = 0;
+            else word += c;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            inWord = true;
+        } else if (c == ' ' || c == '\t') {
+            if (inWord) argv.push_back(word);
+            word.clear();
+            inWord = false;
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    if (inWord) argv.push_back(word);
+    return argv;
+}
+
+bool parseNumber(std::string_view text, double& value) {
+    char number[64];
+    size_t length = std::min(text.size(), sizeof(number) - 1);
+    memcpy(number, text.data(), length);
+    number[length] = '\0';
+    char* end = nullptr;
+    value = strtod(number, &end);
+    return end != number;
+}
+
+// First thing in the text that looks like a number.
+bool firstNumber(std::string_view text, double& value) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        bool digit = c >= '0' && c <= '9';
+        bool signedDigit = (c == '-' || c == '.') && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '9';
+        if ((digit || signedDigit) && parseNumber(text.substr(i), value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool CustomMetricSpec::parse(const std::string& spec, CustomMetricSpec& out) {
+    out = CustomMetricSpec();
+    size_t pos = 0;
+    bool hasSource = false;
+    while (pos < spec.size() && !hasSource) {
+        size_t semicolon = spec.find(';', pos);
+        std::string field = trim(spec.substr(pos, semicolon == std::string::npos ? std::string::npos : semicolon - pos));
+        size_t equals = field.find('=');
+        std::string name = trim(field.substr(0, equals));
+        std::string value = equals == std::string::npos ? "" : trim(field.substr(equals + 1));
+
+        if (name == "file" || name == "exec" || name == "stream") {
+            // The source goes last and keeps any ';' in a command line.
+            size_t start = spec.find('=', pos) + 1;
+            out.target = trim(spec.substr(start));
+            out.source = name == "file" ? CustomMetricSource::File
+                       : name == "exec" ? CustomMetricSource::Command : CustomMetricSource::Stream;
+            hasSource = true;
+        } else if (name == "name") {
+            out.label = value;
+        } else if (name == "unit") {
+            out.unit = value;
+        } else if (name == "key") {
+            out.key = value;
+        } else if (name == "regex") {
+            out.pattern = value;
+        } else if (name == "interval") {
+            out.intervalMs = std::max(100, atoi(value.c_str()));
+        } else if (name == "timeout") {
+            out.timeoutMs = std::max(10, atoi(value.c_str()));
+        } else if (!name.empty()) {
+            return false;
+        }
+        if (semicolon == std::string::npos) break;
+        pos = semicolon + 1;
+    }
+    if (out.label.empty()) {
+        out.label = out.key.empty() ? out.target : out.key;
+    }
+    return hasSource && !out.target.empty();
+}
+
+void CustomMetricMonitor::setMetrics(const std::vector<std::string>& specs) {
+    if (specs == currentSpecs) {
+        return;
+    }
+    currentSpecs = specs;
+    reactor.clear();
+    metrics.clear(); // stops any running children
+    stats.clear();
+    for (const std::string& text : specs) {
+        Metric metric;
+        if (!CustomMetricSpec::parse(text, metric.spec)) {
+            std::cerr << "Ignoring invalid custom metric: " << text << std::endl;
+            continue;
+        }
+        if (!metric.spec.pattern.empty()) {
+            try {
+                metric.regex = std::regex(metric.spec.pattern);
+                metric.hasRegex = true;
+            } catch (const std::regex_error&) {
+                std::cerr << "Ignoring custom metric with invalid regex: " << text << std::endl;
+                continue;
+            }
+        }
+        if (metric.spec.source == CustomMetricSource::File) {
+            metric.file.open(metric.spec.target);
+        } else {
+            metric.argv = splitCommand(metric.spec.target);
+            metric.process = std::make_unique<Subprocess>();
+        }
+        CustomMetricStats stat;
+        stat.label = metric.spec.label;
+        stat.unit = metric.spec.unit;
+        metrics.push_back(std::move(metric));
+        stats.push_back(std::move(stat));
+    }
+    // Spawned once the vectors stop moving, since the tasks hold references into them.
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        if (metrics[i].spec.source == CustomMetricSource::Command) {
+            reactor.spawn(runCommand(metrics[i], stats[i]));
+        } else if (metrics[i].spec.source == CustomMetricSource::Stream) {
+            reactor.spawn(runStream(metrics[i], stats[i]));
+        }
+    }
+}
+
+bool CustomMetricMonitor::extract(const Metric& metric, std::string_view text, double& value) {
+    if (metric.hasRegex) {
+        std::cmatch match;
+        if (!std::regex_search(text.data(), text.data() + text.size(), match, metric.regex)) {
+            return false;
+        }
+        int group = match.size() > 1 && match[1].matched ? 1 : 0;
+        return firstNumber(std::string_view(match[group].first, match[group].length()), value);
+    }
+    if (!metric.spec.key.empty()) {
+        // "key=value" anywhere a word starts, so both one-pair-per-line and "a=1 b=2" lines work.
+        const std::string& key = metric.spec.key;
+        for (size_t at = text.find(key); at != std::string_view::npos; at = text.find(key, at + 1)) {
+            bool wordStart = at == 0 || strchr(" \t\n,;{", text[at - 1]) != nullptr;
+            size_t after = at + key.size();
+            while (after < text.size() && (text[after] == ' ' || text[after] == '\t')) after++;
+            if (wordStart && after < text.size() && (text[after] == '=' || text[after] == ':')) {
+                size_t start = text.find_first_not_of(" \t\"", after + 1);
+                if (start != std::string_view::npos && parseNumber(text.substr(start), value)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    return firstNumber(text, value);
+}
+
+void CustomMetricMonitor::updateFile(Metric& metric, CustomMetricStats& stat, Clock::time_point now) {
+    metric.nextRun = now + std::chrono::milliseconds(metric.spec.intervalMs);
+    if (!metric.file.isOpen() && !metric.file.open(metric.spec.target)) {
+        stat.stale = true;
+        stat.error = "cannot open " + metric.spec.target;
+        return;
+    }
+    double value = 0.0;
+    if (metric.file.read() && extract(metric, metric.file.view(), value)) {
+        stat.value = value;
+        stat.valid = true;
+        stat.stale = false;
+        stat.error.clear();
+    } else {
+        stat.stale = true;
+        stat.error = "no match";
+    }
+}
+
+Task<> CustomMetricMonitor::runCommand(Metric& metric, CustomMetricStats& stat) {
+    Subprocess& process = *metric.process;
+    while (true) {
+        auto started = Clock::now();
+        bool launched = process.start(metric.argv);
+        bool finished = false;
+        if (launched) {
+            finished = co_await reactor.complete(process, started + std::chrono::milliseconds(metric.spec.timeoutMs));
+        }
+        double value = 0.0;
+        if (!launched) {
+            stat.stale = true;
+            stat.error = process.error();
+        } else if (!finished) {
+            stat.stale = true;
+            stat.error = "timed out";
+        } else if (process.exitStatus() != 0) {
+            stat.stale = true;
+            stat.error = "exit status " + std::to_string(process.exitStatus());
+        } else if (extract(metric, process.output(), value)) {
+            stat.value = value;
+            stat.valid = true;
+            stat.stale = false;
+            stat.error.clear();
+        } else {
+            stat.stale = true;
+            stat.error = "no match";
+        }
+        co_await reactor.sleepUntil(started + std::chrono::milliseconds(metric.spec.intervalMs));
+    }
+}
+
+Task<> CustomMetricMonitor::runStream(Metric& metric, CustomMetricStats& stat) {
+    Subprocess& process = *metric.process;
+    while (true) {
+        if (!process.start(metric.argv)) {
+            stat.stale = true;
+            stat.error = process.error();
+            co_await reactor.sleepFor(std::chrono::milliseconds(metric.spec.intervalMs));
+            continue;
+        }
+        metric.lastValue = Clock::now();
+        bool open = true;
+        while (open) {
+            bool ready = co_await reactor.readable(process.outputFd());
+            open = ready && process.readAvailable();
+            // Only whole lines; a partial one stays in the buffer for the next read.
+            std::string_view output = process.output();
+            size_t consumed = 0;
+            double value = 0.0;
+            for (size_t newline = output.find('\n'); newline != std::string_view::npos;
+                 newline = output.find('\n', consumed)) {
+                if (extract(metric, output.substr(consumed, newline - consumed), value)) {
+                    stat.value = value;
+                    stat.valid = true;
+                    stat.error.clear();
+                    metric.lastValue = Clock::now();
+                }
+                consumed = newline + 1;
+            }
+            process.consume(consumed);
+            if (process.output().size() > kMaxStreamLine) {
+                process.clearOutput();
+            }
+        }
+        process.stop();
+        stat.stale = true;
+        stat.error = "exited with status " + std::to_string(process.exitStatus());
+        co_await reactor.sleepFor(std::chrono::milliseconds(metric.spec.intervalMs));
+    }
+}
+
+void CustomMetricMonitor::update() {
+    // Whatever the commands and streams have ready; their timers fire here too, so they run no
+    // more often than update() is called.
+    reactor.runFor(0);
+    auto now = Clock::now();
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        Metric& metric = metrics[i];
+        if (metric.spec.source == CustomMetricSource::File) {
+            if (now >= metric.nextRun) updateFile(metric, stats[i], now);
+        } else if (metric.spec.source == CustomMetricSource::Stream && metric.process->isRunning()) {
+            stats[i].stale = now - metric.lastValue > std::chrono::milliseconds(metric.spec.timeoutMs);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef CUSTOM_METRIC_MONITOR_H
+#define CUSTOM_METRIC_MONITOR_H
+
+#include "ProcFile.h"
+#include "Reactor.h"
+#include "Subprocess.h"
+#include <chrono>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+enum class CustomMetricSource { File, Command, Stream };
+
+struct CustomMetricSpec {
+    std::string label;
+    std::string unit;
+    CustomMetricSource source = CustomMetricSource::File;
+    std::string target;        // file path, or the command line
+    std::string key;           // key=value extractor
+    std::string pattern;       // regex extractor, first capture group or the whole match
+    int intervalMs = 1000;     // file/command: how often to read; stream: restart delay after it exits
+    int timeoutMs = 1000;      // command: kill after; stream: stale when no value arrives for this long
+
+    // Accepts "name=Label;interval=5000;timeout=1000;key=depth;unit=jobs;exec=/usr/bin/qstat -n", with
+    // exactly one of file=, exec= (one-shot) or stream= (long-running), which takes the rest of the line.
+    // Optional regex= instead of key=; with neither, the first number in the output is used.
+    static bool parse(const std::string& spec, CustomMetricSpec& out);
+};
+
+struct CustomMetricStats {
+    std::string label;
+    std::string unit;
+    double value = 0.0;
+    bool valid = false;   // a value has been read at least once
+    bool stale = false;   // the last read failed, or a stream went quiet for longer than its timeout
+    std::string error;
+};
+
+class CustomMetricMonitor {
+public:
+    // Site-specific numbers from config.ini. Nothing here blocks: commands and streams are
+    // coroutines on a reactor that update() runs without waiting, and streams keep one child
+    // running and parse its lines as they come, so there is no fork per sample.
+    CustomMetricMonitor() = default;
+
+    void setMetrics(const std::vector<std::string>& specs);
+    void update();
+    const std::vector<CustomMetricStats>& getStats() const { return stats; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Metric {
+        CustomMetricSpec spec;
+        std::vector<std::string> argv;
+        std::regex regex;
+        bool hasRegex = false;
+        ProcFile file;
+        std::unique_ptr<Subprocess> process;
+        Clock::time_point nextRun;
+        Clock::time_point lastValue;
+    };
+
+    std::vector<std::string> currentSpecs;
+    std::vector<Metric> metrics;
+    std::vector<CustomMetricStats> stats;
+    // After the metrics, so the tasks referring to them go first.
+    Reactor reactor;
+
+    void updateFile(Metric& metric, CustomMetricStats& stat, Clock::time_point now);
+    Task<> runCommand(Metric& metric, CustomMetricStats& stat);
+    Task<> runStream(Metric& metric, CustomMetricStats& stat);
+    static bool extract(const Metric& metric, std::string_view text, double& value);
+};
+
+#endif
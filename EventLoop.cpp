@@ -0,0 +1,148 @@
+#include "EventLoop.h"
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+EventLoop::EventLoop() : timerFd(-1), wakeFd(-1), signalFd(-1), inotifyFd(-1), exitFd(-1), wakeups(0) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        return;
+    }
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    add(timerFd, EPOLLIN, Timer);
+    add(wakeFd, EPOLLIN, Wake);
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    if (pthread_sigmask(SIG_BLOCK, &signals, nullptr) == 0) {
+        signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        add(signalFd, EPOLLIN, Quit);
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (int fd : {epollFd, timerFd, wakeFd, signalFd, inotifyFd}) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void EventLoop::add(int fd, uint32_t events, uint64_t data) {
+    if (epollFd < 0 || fd < 0) {
+        return;
+    }
+    epoll_event event;
+    event.events = events;
+    event.data.u64 = data;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void EventLoop::watch(int fd, Event event) {
+    add(fd, EPOLLIN, event);
+}
+
+void EventLoop::watchPressure(const std::vector<int>& fds) {
+    for (int fd : fds) {
+        add(fd, EPOLLPRI, Pressure);
+    }
+}
+
+void EventLoop::watchConfig(const std::string& path) {
+    if (epollFd < 0 || inotifyFd >= 0) {
+        return;
+    }
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    configName = slash == std::string::npos ? path : path.substr(slash + 1);
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        return;
+    }
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return;
+    }
+    add(inotifyFd, EPOLLIN, Config);
+}
+
+void EventLoop::watchExit(int fd) {
+    if (epollFd < 0) {
+        return;
+    }
+    // A pidfd that was already closed has left the set by itself; this drops one that is still open.
+    if (exitFd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, exitFd, nullptr);
+    }
+    exitFd = fd;
+    add(fd, EPOLLIN | EPOLLONESHOT, Exited);
+}
+
+void EventLoop::armTimer(int ms) {
+    if (timerFd < 0) {
+        return;
+    }
+    // An all-zero it_value would disarm it instead.
+    ms = ms > 0 ? ms : 1;
+    itimerspec spec = {};
+    spec.it_value.tv_sec = ms / 1000;
+    spec.it_value.tv_nsec = (ms % 1000) * 1000000L;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+unsigned EventLoop::wait(int timeoutMs) {
+    if (epollFd < 0) {
+        return 0;
+    }
+    epoll_event ready[16];
+    int count = epoll_wait(epollFd, ready, 16, timeoutMs);
+    if (count <= 0) {
+        return 0; // timed out, or EINTR from a signal we don't own
+    }
+    wakeups++;
+
+    unsigned events = 0;
+    for (int i = 0; i < count; ++i) {
+        Event event = static_cast<Event>(ready[i].data.u64);
+        if (event == Timer || event == Wake) {
+            // Both are counters; one read resets them.
+            uint64_t ignored;
+            ssize_t n = read(event == Timer ? timerFd : wakeFd, &ignored, sizeof(ignored));
+            (void)n;
+            events |= event;
+        } else if (event == Quit) {
+            signalfd_siginfo info;
+            while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+                events |= info.ssi_signo == SIGHUP ? Config : Quit;
+            }
+        } else if (event == Config) {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t n;
+            while ((n = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + n;) {
+                    const inotify_event* change = reinterpret_cast<const inotify_event*>(p);
+                    if (change->len > 0 && configName == change->name) {
+                        events |= Config;
+                    }
+                    p += sizeof(inotify_event) + change->len;
+                }
+            }
+        } else {
+            events |= event;
+        }
+    }
+    return events;
+}
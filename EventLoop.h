@@ -0,0 +1,67 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class EventLoop {
+public:
+    // The overlay's main-thread reactor: one epoll set over the X connections, a timerfd for the
+    // next collector deadline, an eventfd other threads poke, inotify on the config file, the
+    // watched process's pidfd and a signalfd, so the process sleeps in epoll_wait until one of them has something.
+    // The constructor blocks SIGINT/SIGTERM/SIGHUP for signalfd; threads started after it inherit
+    // that mask, so construct it before anything spawns threads.
+    enum Event : unsigned {
+        Display = 1 << 0,   // the GLFW X connection has input
+        Hotkey = 1 << 1,    // the global hotkey connection has input
+        Timer = 1 << 2,     // the armed timer expired
+        Wake = 1 << 3,      // wake() was called, possibly from another thread
+        Config = 1 << 4,    // the config file was rewritten, or SIGHUP
+        Pressure = 1 << 5,  // a PSI trigger fired
+        Quit = 1 << 6,      // SIGINT or SIGTERM
+        Collected = 1 << 7, // a collector finished in the background
+        Exited = 1 << 8,    // the watched process exited
+    };
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool isAvailable() const { return epollFd >= 0; }
+
+    // Input fds are only reported, never read; the owner drains them. PSI triggers signal with
+    // EPOLLPRI, which epoll consumes, so a Pressure event is the only notice of that stall.
+    void watch(int fd, Event event);
+    void watchPressure(const std::vector<int>& fds);
+    // Watches the directory so editors that save by renaming a new file over the old one count.
+    void watchConfig(const std::string& path);
+    // The watched process's pidfd, reported once as Exited (it stays readable until closed).
+    // Call again with each new pidfd, or -1; the previous one is dropped.
+    void watchExit(int fd);
+
+    // One-shot; re-arming replaces the previous expiry.
+    void armTimer(int ms);
+    // Safe from any thread. Also usable as a plain fd: write a uint64_t 1 to it.
+    void wake();
+    int getWakeFd() const { return wakeFd; }
+
+    // Blocks for up to timeoutMs (-1: until something happens) and returns the Events that fired.
+    unsigned wait(int timeoutMs);
+    long long getWakeups() const { return wakeups; }
+
+private:
+    int epollFd;
+    int timerFd;
+    int wakeFd;
+    int signalFd;
+    int inotifyFd;
+    int exitFd;
+    std::string configName;
+    long long wakeups;
+
+    void add(int fd, uint32_t events, uint64_t data);
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "GpuBackend.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr double kNvidiaSmiInterval = 5.0; // seconds
+constexpr int kNvidiaSmiTimeoutMs = 3000;  // a wedged driver can leave nvidia-smi hanging for good
+
+// The files are read as one batch at the top of update(); this only parses them.
+bool parseNumber(const ProcFile& file, long long& value) {
+    if (file.size() == 0) {
+        return false;
+    }
+    char* end = nullptr;
+    value = strtoll(file.data(), &end, 10);
+    return end != file.data();
+}
+
+// Opens the first candidate that exists; sysfs layouts move around between kernel versions.
+void openFirst(ProcFile& file, std::initializer_list<std::string> candidates) {
+    for (const std::string& path : candidates) {
+        if (file.open(path)) {
+            return;
+        }
+    }
+}
+
+std::string findHwmon(const std::string& devicePath) {
+    std::string hwmonRoot = devicePath + "/hwmon";
+    DIR* dir = opendir(hwmonRoot.c_str());
+    if (!dir) {
+        return "";
+    }
+    std::string found;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "hwmon", 5) == 0) {
+            found = hwmonRoot + "/" + ent->d_name;
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+std::string driverName(const std::string& cardPath) {
+    char target[256];
+    ssize_t length = readlink((cardPath + "/device/driver").c_str(), target, sizeof(target) - 1);
+    if (length <= 0) {
+        return "";
+    }
+    target[length] = '\0';
+    const char* slash = strrchr(target, '/');
+    return slash ? slash + 1 : target;
+}
+
+bool isCardEntry(const char* name) {
+    // card0, card1, ... but not the card0-DP-1 connector entries.
+    if (strncmp(name, "card", 4) != 0 || name[4] == '\0') {
+        return false;
+    }
+    for (const char* p = name + 4; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<std::unique_ptr<GpuBackend>> probeGpuBackends(const std::string& drmRoot, const std::string& procRoot) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(drmRoot.c_str());
+    if (dir) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            if (isCardEntry(ent->d_name)) {
+                names.push_back(ent->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) {
+        return atoi(a.c_str() + 4) < atoi(b.c_str() + 4);
+    });
+
+    std::vector<std::unique_ptr<GpuBackend>> backends;
+    bool nvidia = access((procRoot + "/driver/nvidia/version").c_str(), F_OK) == 0;
+    for (const std::string& name : names) {
+        std::string cardPath = drmRoot + "/" + name;
+        std::string driver = driverName(cardPath);
+        if (driver == "amdgpu") {
+            backends.push_back(std::make_unique<AmdgpuBackend>(cardPath, name));
+        } else if (driver == "i915" || driver == "xe") {
+            backends.push_back(std::make_unique<IntelBackend>(cardPath, name, driver));
+        } else if (driver == "nvidia") {
+            nvidia = true;
+        }
+    }
+    if (nvidia) {
+        backends.push_back(std::make_unique<NvidiaSmiBackend>());
+    }
+    return backends;
+}
+
+AmdgpuBackend::AmdgpuBackend(const std::string& cardPath, const std::string& cardName) {
+    std::string device = cardPath + "/device";
+    busyFile.open(device + "/gpu_busy_percent");
+    vramUsedFile.open(device + "/mem_info_vram_used");
+    vramTotalFile.open(device + "/mem_info_vram_total");
+    std::string hwmon = findHwmon(device);
+    if (!hwmon.empty()) {
+        temperatureFile.open(hwmon + "/temp1_input");
+        openFirst(powerFile, {hwmon + "/power1_average", hwmon + "/power1_input"});
+        frequencyFile.open(hwmon + "/freq1_input");
+    }
+    for (ProcFile* file : {&busyFile, &vramUsedFile, &vramTotalFile, &temperatureFile, &powerFile, &frequencyFile}) {
+        reads.add(*file);
+    }
+
+    cards.resize(1);
+    cards[0].name = cardName;
+    cards[0].driver = "amdgpu";
+}
+
+void AmdgpuBackend::update() {
+    reads.read();
+    GpuCardStats& card = cards[0];
+    long long value = 0;
+    card.hasUsage = parseNumber(busyFile, value);
+    card.usage = card.hasUsage ? static_cast<double>(value) : 0.0;
+
+    long long total = 0;
+    card.hasMemory = parseNumber(vramUsedFile, value) && parseNumber(vramTotalFile, total);
+    card.memoryUsed = card.hasMemory ? value / (1024 * 1024) : 0;
+    card.memoryTotal = card.hasMemory ? total / (1024 * 1024) : 0;
+
+    card.hasTemperature = parseNumber(temperatureFile, value);
+    card.temperature = card.hasTemperature ? static_cast<int>(value / 1000) : 0;
+
+    card.hasPower = parseNumber(powerFile, value);
+    card.power = card.hasPower ? value / 1e6 : 0.0;
+
+    card.hasFrequency = parseNumber(frequencyFile, value);
+    card.frequency = card.hasFrequency ? static_cast<int>(value / 1000000) : 0;
+}
+
+IntelBackend::IntelBackend(const std::string& cardPath, const std::string& cardName, const std::string& driver)
+    : prevResidencyMs(0), prevEnergy(0), hasPrev(false) {
+    if (driver == "xe") {
+        std::string gt = cardPath + "/device/tile0/gt0";
+        frequencyFile.open(gt + "/freq0/act_freq");
+        maxFrequencyFile.open(gt + "/freq0/max_freq");
+        residencyFile.open(gt + "/gtidle/idle_residency_ms");
+    } else {
+        openFirst(frequencyFile, {cardPath + "/gt/gt0/rps_act_freq_mhz", cardPath + "/gt_act_freq_mhz"});
+        openFirst(maxFrequencyFile, {cardPath + "/gt/gt0/rps_max_freq_mhz", cardPath + "/gt_max_freq_mhz"});
+        openFirst(residencyFile, {cardPath + "/gt/gt0/rc6_residency_ms", cardPath + "/power/rc6_residency_ms"});
+    }
+    std::string hwmon = findHwmon(cardPath + "/device");
+    if (!hwmon.empty()) {
+        energyFile.open(hwmon + "/energy1_input");
+    }
+    for (ProcFile* file : {&frequencyFile, &maxFrequencyFile, &residencyFile, &energyFile}) {
+        reads.add(*file);
+    }
+    lastSample = std::chrono::steady_clock::now();
+
+    cards.resize(1);
+    cards[0].name = cardName;
+    cards[0].driver = driver;
+}
+
+void IntelBackend::update() {
+    reads.read();
+    GpuCardStats& card = cards[0];
+    auto now = std::chrono::steady_clock::now();
+    double elapsedMs = std::chrono::duration<double, std::milli>(now - lastSample).count();
+    lastSample = now;
+
+    long long value = 0;
+    card.hasFrequency = parseNumber(frequencyFile, value);
+    card.frequency = card.hasFrequency ? static_cast<int>(value) : 0;
+    card.maxFrequency = parseNumber(maxFrequencyFile, value) ? static_cast<int>(value) : 0;
+
+    // The GT is either busy or parked in RC6, so the idle residency delta gives an approximate busy %.
+    long long residency = 0;
+    bool haveResidency = parseNumber(residencyFile, residency);
+    long long energy = 0;
+    bool haveEnergy = parseNumber(energyFile, energy);
+
+    card.hasUsage = haveResidency && hasPrev && elapsedMs > 0;
+    if (card.hasUsage) {
+        double idle = (residency - prevResidencyMs) * 100.0 / elapsedMs;
+        card.idleResidency = std::min(100.0, std::max(0.0, idle));
+        card.usage = 100.0 - card.idleResidency;
+    }
+    card.hasPower = haveEnergy && hasPrev && elapsedMs > 0 && energy >= prevEnergy;
+    if (card.hasPower) {
+        card.power = (energy - prevEnergy) / (elapsedMs * 1000.0); // uJ per ms -> W
+    }
+    prevResidencyMs = residency;
+    prevEnergy = energy;
+    hasPrev = true;
+}
+
+NvidiaSmiBackend::NvidiaSmiBackend() : updatedOnce(false) {}
+
+void NvidiaSmiBackend::update() {
+    auto currentTime = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsedSeconds = currentTime - lastUpdate;
+    if (updatedOnce && elapsedSeconds.count() < kNvidiaSmiInterval) {
+        return;
+    }
+    lastUpdate = currentTime;
+    updatedOnce = true;
+
+    // One line per GPU; fields that the card does not support come back as "[N/A]".
+    static const std::vector<std::string> command = {
+        "nvidia-smi",
+        "--query-gpu=utilization.gpu,memory.used,memory.total,temperature.gpu,power.draw,clocks.gr,clocks.max.gr",
+        "--format=csv,noheader,nounits",
+    };
+    if (!nvidiaSmi.run(command, kNvidiaSmiTimeoutMs)) {
+        cards.clear();
+        return;
+    }
+    std::string_view output = nvidiaSmi.output();
+    size_t index = 0;
+    while (!output.empty()) {
+        size_t newline = output.find('\n');
+        line.assign(output.substr(0, newline));
+        output.remove_prefix(newline == std::string_view::npos ? output.size() : newline + 1);
+        double fields[7] = {};
+        bool valid[7] = {};
+        const char* p = line.c_str();
+        for (int i = 0; i < 7 && *p; ++i) {
+            char* end = nullptr;
+            fields[i] = strtod(p, &end);
+            valid[i] = end != p;
+            const char* comma = strchr(p, ',');
+            if (!comma) break;
+            p = comma + 1;
+        }
+        if (!valid[0]) {
+            continue;
+        }
+        if (cards.size() < index + 1) {
+            cards.resize(index + 1);
+            cards[index].name = "nvidia" + std::to_string(index);
+            cards[index].driver = "nvidia";
+        }
+        GpuCardStats& card = cards[index++];
+        card.hasUsage = true;
+        card.usage = fields[0];
+        card.hasMemory = valid[1] && valid[2];
+        card.memoryUsed = static_cast<long long>(fields[1]);
+        card.memoryTotal = static_cast<long long>(fields[2]);
+        card.hasTemperature = valid[3];
+        card.temperature = static_cast<int>(fields[3]);
+        card.hasPower = valid[4];
+        card.power = fields[4];
+        card.hasFrequency = valid[5];
+        card.frequency = static_cast<int>(fields[5]);
+        card.maxFrequency = valid[6] ? static_cast<int>(fields[6]) : 0;
+    }
+    cards.resize(index);
+}
@@ -0,0 +1,96 @@
+#ifndef GPU_BACKEND_H
+#define GPU_BACKEND_H
+
+#include "ProcFile.h"
+#include "ProcFileBatch.h"
+#include "Subprocess.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct GpuCardStats {
+    std::string name;           // "card0", or "nvidia0" for cards only nvidia-smi knows about
+    std::string driver;         // amdgpu, i915, xe, nvidia
+    double usage = 0.0;         // %
+    long long memoryUsed = 0;   // MB
+    long long memoryTotal = 0;  // MB
+    int temperature = 0;        // C
+    double power = 0.0;         // W
+    int frequency = 0;          // MHz
+    int maxFrequency = 0;       // MHz
+    double idleResidency = 0.0; // % of the interval in RC6/gtidle (Intel only)
+
+    bool hasUsage = false;
+    bool hasMemory = false;
+    bool hasTemperature = false;
+    bool hasPower = false;
+    bool hasFrequency = false;
+};
+
+class GpuBackend {
+public:
+    // One implementation per vendor. Sysfs backends own exactly one card and keep its files open;
+    // the nvidia-smi backend covers every NVIDIA card with one command.
+    virtual ~GpuBackend() = default;
+    virtual void update() = 0;
+    const std::vector<GpuCardStats>& getCards() const { return cards; }
+
+protected:
+    std::vector<GpuCardStats> cards;
+};
+
+// Probes drmRoot once and returns a backend for every card it recognizes, in card order, plus
+// nvidia-smi when procRoot shows the NVIDIA driver loaded. Point both at a fake tree to exercise
+// the sysfs readers without the hardware.
+std::vector<std::unique_ptr<GpuBackend>> probeGpuBackends(const std::string& drmRoot = "/sys/class/drm",
+                                                          const std::string& procRoot = "/proc");
+
+class AmdgpuBackend : public GpuBackend {
+public:
+    // gpu_busy_percent, mem_info_vram_*, and hwmon temp/power/sclk for one amdgpu card.
+    AmdgpuBackend(const std::string& cardPath, const std::string& cardName);
+    void update() override;
+
+private:
+    ProcFile busyFile;
+    ProcFile vramUsedFile;
+    ProcFile vramTotalFile;
+    ProcFile temperatureFile;
+    ProcFile powerFile;
+    ProcFile frequencyFile;
+    ProcFileBatch reads;
+};
+
+class IntelBackend : public GpuBackend {
+public:
+    // i915 and xe: actual/max frequency and RC6 (gtidle on xe) residency, which stands in for busy %.
+    IntelBackend(const std::string& cardPath, const std::string& cardName, const std::string& driver);
+    void update() override;
+
+private:
+    ProcFile frequencyFile;
+    ProcFile maxFrequencyFile;
+    ProcFile residencyFile;
+    ProcFile energyFile;        // hwmon energy1_input on discrete cards, microjoules
+    ProcFileBatch reads;
+    long long prevResidencyMs;
+    long long prevEnergy;
+    bool hasPrev;
+    std::chrono::steady_clock::time_point lastSample;
+};
+
+class NvidiaSmiBackend : public GpuBackend {
+public:
+    // Runs nvidia-smi, so it refreshes at most every few seconds.
+    NvidiaSmiBackend();
+    void update() override;
+
+private:
+    Subprocess nvidiaSmi;
+    std::string line;
+    std::chrono::steady_clock::time_point lastUpdate;
+    bool updatedOnce;
+};
+
+#endif
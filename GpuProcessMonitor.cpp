@@ -0,0 +1,241 @@
+#include "GpuProcessMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+
+namespace {
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool isNumeric(const char* name) {
+    if (*name == '\0') return false;
+    for (const char* p = name; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+    }
+    return true;
+}
+
+// "1234 KiB", "12 MiB" or plain bytes, returned in KB.
+long long parseMemoryKb(std::string_view value) {
+    char* end = nullptr;
+    long long amount = strtoll(value.data(), &end, 10);
+    std::string_view unit = value.substr(end - value.data());
+    unit.remove_prefix(std::min(unit.find_first_not_of(" \t"), unit.size()));
+    if (startsWith(unit, "KiB")) return amount;
+    if (startsWith(unit, "MiB")) return amount * 1024;
+    if (startsWith(unit, "GiB")) return amount * 1024 * 1024;
+    return amount / 1024;
+}
+
+bool isVramRegion(std::string_view region) {
+    return startsWith(region, "vram") || startsWith(region, "local");
+}
+
+struct EngineSample {
+    std::string_view name;
+    unsigned long long value = 0;
+    unsigned long long total = 0;
+    int capacity = 1;
+};
+
+} // namespace
+
+GpuProcessMonitor::GpuProcessMonitor(const std::string& procRoot)
+    : procRoot(procRoot), updatesSinceRescan(kRescanInterval), tick(0) {
+    lastSample = std::chrono::steady_clock::now();
+}
+
+void GpuProcessMonitor::rescan() {
+    // readlink on every fd of every process is the expensive part, so only do it every few updates
+    // and poll the fdinfo files that turned out to be DRM in between.
+    updatesSinceRescan = 0;
+    drmFds.clear();
+    DIR* procDir = opendir(procRoot.c_str());
+    if (!procDir) {
+        return;
+    }
+    struct dirent* procEnt;
+    while ((procEnt = readdir(procDir)) != NULL) {
+        if (!isNumeric(procEnt->d_name)) continue;
+        std::string pidPath = procRoot + "/" + procEnt->d_name;
+        DIR* fdDir = opendir((pidPath + "/fd").c_str());
+        if (!fdDir) continue; // other users' processes without CAP_SYS_PTRACE
+
+        std::string name;
+        struct dirent* fdEnt;
+        while ((fdEnt = readdir(fdDir)) != NULL) {
+            if (!isNumeric(fdEnt->d_name)) continue;
+            char target[64];
+            ssize_t length = readlinkat(dirfd(fdDir), fdEnt->d_name, target, sizeof(target) - 1);
+            if (length <= 0) continue;
+            target[length] = '\0';
+            if (strncmp(target, "/dev/dri/", 9) != 0) continue;
+
+            if (name.empty()) {
+                ProcFile comm(pidPath + "/comm");
+                if (comm.read()) {
+                    name.assign(comm.data(), strcspn(comm.data(), "\n"));
+                }
+            }
+            DrmFd drmFd;
+            drmFd.pid = atoi(procEnt->d_name);
+            drmFd.name = name;
+            if (drmFd.info.open(pidPath + "/fdinfo/" + fdEnt->d_name)) {
+                drmFds.push_back(std::move(drmFd));
+            }
+        }
+        closedir(fdDir);
+    }
+    closedir(procDir);
+}
+
+bool GpuProcessMonitor::sampleFd(DrmFd& drmFd, double elapsedNs, GpuProcessStats& out) {
+    if (!drmFd.info.read()) {
+        return false;
+    }
+
+    std::string_view driver, pdev, clientId;
+    EngineSample engines[16];
+    int engineCount = 0;
+    long long memoryVram = 0, memorySystem = 0, residentVram = 0, residentSystem = 0;
+    bool haveResident = false;
+
+    auto engineFor = [&](std::string_view name) -> EngineSample* {
+        for (int i = 0; i < engineCount; ++i) {
+            if (engines[i].name == name) return &engines[i];
+        }
+        if (engineCount == 16) return nullptr;
+        engines[engineCount].name = name;
+        return &engines[engineCount++];
+    };
+
+    std::string_view text = drmFd.info.view();
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos || !startsWith(line, "drm-")) continue;
+        std::string_view key = line.substr(4, colon - 4);
+        std::string_view value = line.substr(colon + 1);
+        value.remove_prefix(std::min(value.find_first_not_of(" \t"), value.size()));
+
+        EngineSample* engine = nullptr;
+        if (key == "driver") {
+            driver = value;
+        } else if (key == "pdev") {
+            pdev = value;
+        } else if (key == "client-id") {
+            clientId = value;
+        } else if (startsWith(key, "engine-capacity-")) {
+            if ((engine = engineFor(key.substr(16)))) engine->capacity = std::max(1, atoi(value.data()));
+        } else if (startsWith(key, "engine-")) {
+            if ((engine = engineFor(key.substr(7)))) engine->value = strtoull(value.data(), nullptr, 10);
+        } else if (startsWith(key, "total-cycles-")) {
+            if ((engine = engineFor(key.substr(13)))) engine->total = strtoull(value.data(), nullptr, 10);
+        } else if (startsWith(key, "cycles-")) {
+            if ((engine = engineFor(key.substr(7)))) engine->value = strtoull(value.data(), nullptr, 10);
+        } else if (startsWith(key, "resident-")) {
+            haveResident = true;
+            (isVramRegion(key.substr(9)) ? residentVram : residentSystem) += parseMemoryKb(value);
+        } else if (startsWith(key, "memory-")) {
+            (isVramRegion(key.substr(7)) ? memoryVram : memorySystem) += parseMemoryKb(value);
+        }
+    }
+    if (clientId.empty()) {
+        return false; // the fd number was reused for something that is not a DRM client
+    }
+
+    std::pair<std::string_view, unsigned long long> key(pdev, strtoull(clientId.data(), nullptr, 10));
+    auto entry = clients.find(key);
+    if (entry == clients.end()) {
+        entry = clients.emplace(ClientKey(key.first, key.second), Client()).first;
+    }
+    Client& client = entry->second;
+    if (client.lastSeen == tick) {
+        return true; // already counted through another fd or process this tick
+    }
+    client.lastSeen = tick;
+
+    out.clients++;
+    if (out.driver.empty()) {
+        out.driver = std::string(driver);
+    }
+    out.vramKb += haveResident ? residentVram : memoryVram;
+    out.systemKb += haveResident ? residentSystem : memorySystem;
+
+    for (int i = 0; i < engineCount; ++i) {
+        EngineSample& sample = engines[i];
+        auto found = std::find_if(client.engines.begin(), client.engines.end(),
+                                  [&](const Engine& e) { return e.name == sample.name; });
+        if (found == client.engines.end()) {
+            Engine engine;
+            engine.name = std::string(sample.name);
+            engine.prevValue = sample.value;
+            engine.prevTotal = sample.total;
+            client.engines.push_back(engine);
+            continue;
+        }
+        double percent = 0.0;
+        if (sample.value >= found->prevValue) {
+            double busy = static_cast<double>(sample.value - found->prevValue);
+            if (sample.total > found->prevTotal) {
+                percent = busy * 100.0 / (sample.total - found->prevTotal);
+            } else if (sample.total == 0 && elapsedNs > 0) {
+                percent = busy * 100.0 / elapsedNs;
+            }
+            percent = std::min(100.0, percent / sample.capacity);
+        }
+        found->prevValue = sample.value;
+        found->prevTotal = sample.total;
+        if (percent > out.busyPercent) {
+            out.busyPercent = percent;
+            out.busiestEngine = found->name;
+        }
+    }
+    return true;
+}
+
+void GpuProcessMonitor::update() {
+    if (++updatesSinceRescan >= kRescanInterval) {
+        rescan();
+    }
+    ++tick;
+    auto now = std::chrono::steady_clock::now();
+    double elapsedNs = std::chrono::duration<double, std::nano>(now - lastSample).count();
+    lastSample = now;
+
+    // fds of one process are contiguous after a rescan, so each pid gets one row.
+    stats.processes.clear();
+    size_t kept = 0;
+    for (size_t i = 0; i < drmFds.size(); ++i) {
+        DrmFd& drmFd = drmFds[i];
+        if (stats.processes.empty() || stats.processes.back().pid != drmFd.pid) {
+            stats.processes.emplace_back();
+            stats.processes.back().pid = drmFd.pid;
+            stats.processes.back().name = drmFd.name;
+        }
+        if (sampleFd(drmFd, elapsedNs, stats.processes.back())) {
+            if (kept != i) drmFds[kept] = std::move(drmFd);
+            ++kept;
+        }
+    }
+    drmFds.resize(kept);
+    stats.drmFds = static_cast<int>(kept);
+
+    stats.processes.erase(std::remove_if(stats.processes.begin(), stats.processes.end(),
+                                         [](const GpuProcessStats& p) { return p.clients == 0; }),
+                          stats.processes.end());
+    std::sort(stats.processes.begin(), stats.processes.end(), [](const GpuProcessStats& a, const GpuProcessStats& b) {
+        return a.busyPercent != b.busyPercent ? a.busyPercent > b.busyPercent : a.vramKb > b.vramKb;
+    });
+
+    for (auto it = clients.begin(); it != clients.end();) {
+        it = it->second.lastSeen == tick ? std::next(it) : clients.erase(it);
+    }
+}
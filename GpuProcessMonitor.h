@@ -0,0 +1,81 @@
+#ifndef GPU_PROCESS_MONITOR_H
+#define GPU_PROCESS_MONITOR_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct GpuProcessStats {
+    int pid = 0;
+    std::string name;
+    std::string driver;
+    double busyPercent = 0.0;       // busiest engine over the last interval
+    std::string busiestEngine;      // render, gfx, video, copy, ...
+    long long vramKb = 0;
+    long long systemKb = 0;         // GTT / system memory charged to the process's clients
+    int clients = 0;                // distinct DRM clients after de-duplication
+};
+
+struct GpuProcessTable {
+    std::vector<GpuProcessStats> processes; // busiest first
+    int drmFds = 0;                         // cached fdinfo files polled each update
+};
+
+class GpuProcessMonitor {
+public:
+    // Per-process GPU busy % and memory from the drm-* keys in /proc/[pid]/fdinfo, for any vendor
+    // whose driver implements DRM fdinfo (amdgpu, i915, xe, msm, panfrost, ...).
+    explicit GpuProcessMonitor(const std::string& procRoot = "/proc");
+    void update();
+    const GpuProcessTable& getStats() const { return stats; }
+
+private:
+    static constexpr int kRescanInterval = 10; // updates between full /proc fd scans
+
+    // A file descriptor that pointed at /dev/dri/* at the last rescan; its fdinfo stays open.
+    struct DrmFd {
+        int pid;
+        std::string name;
+        ProcFile info;
+    };
+
+    struct Engine {
+        std::string name;
+        unsigned long long prevValue = 0;  // ns busy, or cycles on drivers that report drm-cycles-*
+        unsigned long long prevTotal = 0;  // drm-total-cycles-*, zero for ns engines
+    };
+
+    // Clients are shared by dup() and fork(), so they are keyed by pdev + drm-client-id.
+    struct Client {
+        std::vector<Engine> engines;
+        int lastSeen = 0;
+    };
+    using ClientKey = std::pair<std::string, unsigned long long>;
+    // Also compares against a pair<string_view, ...> straight out of the fdinfo buffer, so looking
+    // up a known client doesn't build a key string every update.
+    struct ClientKeyLess {
+        using is_transparent = void;
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            std::string_view pdevA = a.first, pdevB = b.first;
+            return pdevA != pdevB ? pdevA < pdevB : a.second < b.second;
+        }
+    };
+
+    std::string procRoot;
+    std::vector<DrmFd> drmFds;
+    std::map<ClientKey, Client, ClientKeyLess> clients;
+    int updatesSinceRescan;
+    int tick;
+    std::chrono::steady_clock::time_point lastSample;
+    GpuProcessTable stats;
+
+    void rescan();
+    bool sampleFd(DrmFd& drmFd, double elapsedNs, GpuProcessStats& out);
+};
+
+#endif
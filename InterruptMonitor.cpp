@@ -0,0 +1,175 @@
+#include "InterruptMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+InterruptMonitor::InterruptMonitor() {
+    interrupts.file.open("/proc/interrupts");
+    softirqs.file.open("/proc/softirqs");
+}
+
+InterruptMonitor::InterruptMonitor(ProcTableScanner::Isa isa) : scanner(isa) {
+    interrupts.file.open("/proc/interrupts");
+    softirqs.file.open("/proc/softirqs");
+}
+
+InterruptMonitor::InterruptMonitor(ProcTableScanner::Isa isa, const std::string& interruptsPath,
+                                   const std::string& softirqsPath)
+    : scanner(isa) {
+    interrupts.file.open(interruptsPath);
+    softirqs.file.open(softirqsPath);
+}
+
+bool InterruptMonitor::parseTable(Source& source, bool& layoutChanged) {
+    // Both files are a "CPU0 CPU1 ..." header followed by "LABEL: n n n ... description" rows.
+    layoutChanged = false;
+    if (!source.file.read() || source.file.size() == 0) {
+        return false;
+    }
+    const char* p = source.file.data();
+    const char* end = p + source.file.size();
+    InterruptTable& table = source.table;
+
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!lineEnd) lineEnd = end;
+    size_t cpuCount = scanner.countTokens(p, lineEnd);
+    if (cpuCount == 0) {
+        return false;
+    }
+    if (cpuCount != table.cpuIds.size()) {
+        layoutChanged = true;
+        table.cpuIds.clear();
+        for (const char* q = p; q < lineEnd;) {
+            const char* cpu = static_cast<const char*>(memmem(q, lineEnd - q, "CPU", 3));
+            if (!cpu) break;
+            table.cpuIds.push_back(atoi(cpu + 3));
+            q = cpu + 3;
+        }
+        table.cpuIds.resize(cpuCount, -1);
+    }
+    p = lineEnd + 1;
+
+    size_t row = 0;
+    while (p < end) {
+        lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+
+        const char* label = p;
+        while (label < lineEnd && *label == ' ') ++label;
+        const char* colon = static_cast<const char*>(memchr(label, ':', lineEnd - label));
+        if (!colon) {
+            p = lineEnd + 1;
+            continue;
+        }
+        std::string_view name(label, colon - label);
+
+        if (row >= table.names.size()) {
+            layoutChanged = true;
+            table.names.emplace_back(name);
+            table.descriptions.emplace_back();
+        } else if (table.names[row] != name) {
+            layoutChanged = true;
+            table.names[row].assign(name);
+        }
+        if (source.counts.size() < (row + 1) * cpuCount) {
+            source.counts.resize((row + 1) * cpuCount);
+        }
+        if (source.totalOnly.size() <= row) {
+            source.totalOnly.resize(row + 1);
+        }
+
+        // Rows like ERR/MIS only carry a single total. It is kept in column 0 but the row is
+        // marked, so updateSource doesn't count it as CPU0's.
+        unsigned long long* values = source.counts.data() + row * cpuCount;
+        const char* rest = lineEnd;
+        size_t parsed = scanner.parseRow(colon + 1, lineEnd, values, cpuCount, &rest);
+        bool totalOnly = parsed < cpuCount;
+        if (totalOnly) {
+            for (size_t i = 1; i < parsed; ++i) values[0] += values[i];
+            std::fill(values + 1, values + cpuCount, 0ULL);
+        }
+        if (source.totalOnly[row] != totalOnly) {
+            layoutChanged = true;
+            source.totalOnly[row] = totalOnly;
+        }
+
+        while (rest < lineEnd && *rest == ' ') ++rest;
+        std::string_view description(rest, lineEnd - rest);
+        if (table.descriptions[row] != description) {
+            table.descriptions[row].assign(description);
+        }
+
+        ++row;
+        p = lineEnd + 1;
+    }
+
+    if (row != table.names.size()) {
+        layoutChanged = true;
+        table.names.resize(row);
+        table.descriptions.resize(row);
+    }
+    source.counts.resize(row * cpuCount);
+    source.totalOnly.resize(row);
+    return true;
+}
+
+void InterruptMonitor::updateSource(Source& source) {
+    InterruptTable& table = source.table;
+    auto now = std::chrono::steady_clock::now();
+    bool layoutChanged = false;
+    if (!parseTable(source, layoutChanged)) {
+        table = InterruptTable();
+        source.hasPrev = false;
+        return;
+    }
+
+    size_t rows = table.names.size();
+    size_t cpus = table.cpuIds.size();
+    table.rates.resize(rows * cpus);
+    table.rowRates.assign(rows, 0.0);
+    table.cpuRates.assign(cpus, 0.0);
+    table.totalRate = 0.0;
+    table.imbalance = 0.0;
+
+    std::chrono::duration<double> elapsed = now - source.lastSample;
+    if (source.hasPrev && !layoutChanged && elapsed.count() > 0) {
+        double inv = 1.0 / elapsed.count();
+        for (size_t r = 0; r < rows; ++r) {
+            if (source.totalOnly[r]) {
+                size_t i = r * cpus;
+                std::fill(table.rates.begin() + i, table.rates.begin() + i + cpus, 0.0);
+                table.rowRates[r] =
+                    source.counts[i] >= source.prevCounts[i] ? (source.counts[i] - source.prevCounts[i]) * inv : 0.0;
+                continue;
+            }
+            for (size_t c = 0; c < cpus; ++c) {
+                size_t i = r * cpus + c;
+                // A counter going backwards means the IRQ was freed and reused, treat it as a fresh start.
+                double rate = source.counts[i] >= source.prevCounts[i] ? (source.counts[i] - source.prevCounts[i]) * inv : 0.0;
+                table.rates[i] = rate;
+                table.rowRates[r] += rate;
+                table.cpuRates[c] += rate;
+            }
+        }
+        double maxCpuRate = 0.0;
+        for (double rate : table.cpuRates) {
+            table.totalRate += rate;
+            maxCpuRate = std::max(maxCpuRate, rate);
+        }
+        if (table.totalRate > 0 && cpus > 0) {
+            table.imbalance = maxCpuRate / (table.totalRate / cpus);
+        }
+    } else {
+        std::fill(table.rates.begin(), table.rates.end(), 0.0);
+    }
+
+    source.prevCounts.swap(source.counts);
+    source.counts.resize(source.prevCounts.size());
+    source.hasPrev = true;
+    source.lastSample = now;
+}
+
+void InterruptMonitor::update() {
+    updateSource(interrupts);
+    updateSource(softirqs);
+}
@@ -0,0 +1,57 @@
+#ifndef INTERRUPT_MONITOR_H
+#define INTERRUPT_MONITOR_H
+
+#include "ProcFile.h"
+#include "ProcTableScanner.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct InterruptTable {
+    // Per-IRQ x per-CPU rates for one of /proc/interrupts or /proc/softirqs.
+    std::vector<int> cpuIds;                 // CPU number for each column
+    std::vector<std::string> names;          // row label, e.g. "45" or "NET_RX"
+    std::vector<std::string> descriptions;   // trailing text, e.g. "PCI-MSIX nvme0q1"
+    std::vector<double> rates;               // names.size() x cpuIds.size(), row-major, events/s
+    std::vector<double> rowRates;            // per-IRQ total events/s
+    std::vector<double> cpuRates;            // per-CPU total events/s, rows without per-CPU counts left out
+    double totalRate = 0.0;
+    double imbalance = 0.0;                  // busiest CPU rate / mean CPU rate, 1.0 is perfectly even
+
+    size_t cpuCount() const { return cpuIds.size(); }
+    double rate(size_t row, size_t cpu) const { return rates[row * cpuIds.size() + cpu]; }
+};
+
+class InterruptMonitor {
+public:
+    // Turns /proc/interrupts and /proc/softirqs into rate matrices so IRQ affinity imbalance is visible.
+    InterruptMonitor();
+    explicit InterruptMonitor(ProcTableScanner::Isa isa);
+    // Reads recorded copies instead of the live files, for bench/ProcTableScannerBench.
+    InterruptMonitor(ProcTableScanner::Isa isa, const std::string& interruptsPath, const std::string& softirqsPath);
+    void update();
+
+    const InterruptTable& getInterrupts() const { return interrupts.table; }
+    const InterruptTable& getSoftirqs() const { return softirqs.table; }
+    const ProcTableScanner& getScanner() const { return scanner; }
+
+private:
+    struct Source {
+        ProcFile file;
+        InterruptTable table;
+        std::vector<unsigned long long> counts;
+        std::vector<unsigned long long> prevCounts;
+        std::vector<bool> totalOnly; // per row: ERR/MIS and the like, one count in column 0
+        bool hasPrev = false;
+        std::chrono::steady_clock::time_point lastSample;
+    };
+
+    ProcTableScanner scanner;
+    Source interrupts;
+    Source softirqs;
+
+    void updateSource(Source& source);
+    bool parseTable(Source& source, bool& layoutChanged);
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "KernelEventMonitor.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMessageLength = 160;
+
+// Pulls "name" and pid out of text like "1234 (name)" or "name:1234".
+void parsePidParen(const std::string& text, size_t at, KernelEvent& event) {
+    event.pid = atoi(text.c_str() + at);
+    size_t open = text.find('(', at);
+    size_t close = open == std::string::npos ? open : text.find(')', open);
+    if (close != std::string::npos) {
+        event.victim = text.substr(open + 1, close - open - 1);
+    }
+}
+
+void parseNameColonPid(const std::string& text, size_t start, size_t end, KernelEvent& event) {
+    size_t colon = text.rfind(':', end);
+    if (colon == std::string::npos || colon < start) {
+        return;
+    }
+    event.victim = text.substr(start, colon - start);
+    event.pid = atoi(text.c_str() + colon + 1);
+}
+
+} // namespace
+
+KernelEventMonitor::KernelEventMonitor(const std::string& kmsgPath, const std::string& procRoot)
+    : kmsgPath(kmsgPath), kmsgFd(-1), wakeFd(-1), notifyFd(-1), running(false), nextEvent(0), recorded(0),
+      copiedRecorded(0), prevOomKills(0), hasPrev(false) {
+    vmstatFile.open(procRoot + "/vmstat");
+    lastSample = std::chrono::steady_clock::now();
+}
+
+KernelEventMonitor::~KernelEventMonitor() {
+    stop();
+}
+
+const char* KernelEventMonitor::typeName(KernelEventType type) {
+    switch (type) {
+    case KernelEventType::OomKill: return "OOM kill";
+    case KernelEventType::HungTask: return "Hung task";
+    case KernelEventType::SoftLockup: return "Lockup";
+    case KernelEventType::MachineCheck: return "MCE";
+    case KernelEventType::NicReset: return "NIC reset";
+    default: return "?";
+    }
+}
+
+bool KernelEventMonitor::classify(const std::string& message, KernelEvent& event) {
+    size_t at;
+    if ((at = message.find("Killed process ")) != std::string::npos) {
+        // "Out of memory: Killed process 1234 (name) total-vm:..." and the memcg variant
+        event.type = KernelEventType::OomKill;
+        parsePidParen(message, at + 15, event);
+    } else if ((at = message.find("INFO: task ")) != std::string::npos &&
+               message.find(" blocked for more than ") != std::string::npos) {
+        // "INFO: task name:1234 blocked for more than 120 seconds."
+        event.type = KernelEventType::HungTask;
+        parseNameColonPid(message, at + 11, message.find(" blocked for more than "), event);
+    } else if (message.find("soft lockup") != std::string::npos || message.find("hard LOCKUP") != std::string::npos) {
+        // "watchdog: BUG: soft lockup - CPU#3 stuck for 22s! [name:1234]"
+        event.type = KernelEventType::SoftLockup;
+        size_t open = message.rfind('[');
+        size_t close = message.rfind(']');
+        if (open != std::string::npos && close != std::string::npos && close > open) {
+            parseNameColonPid(message, open + 1, close, event);
+        }
+    } else if (message.find("[Hardware Error]") != std::string::npos ||
+               message.find("Machine check events logged") != std::string::npos) {
+        event.type = KernelEventType::MachineCheck;
+    } else if ((at = message.find("NETDEV WATCHDOG: ")) != std::string::npos) {
+        // "NETDEV WATCHDOG: eth0 (e1000e): transmit queue 0 timed out"
+        event.type = KernelEventType::NicReset;
+        size_t start = at + 17;
+        event.victim = message.substr(start, message.find(' ', start) - start);
+    } else if ((at = message.find(": Reset adapter")) != std::string::npos ||
+               (at = message.find(": Detected Hardware Unit Hang")) != std::string::npos ||
+               (at = message.find(": Detected Tx Unit Hang")) != std::string::npos) {
+        // "e1000e 0000:00:19.0 eth0: Reset adapter unexpectedly"
+        event.type = KernelEventType::NicReset;
+        size_t start = message.rfind(' ', at);
+        start = start == std::string::npos ? 0 : start + 1;
+        event.victim = message.substr(start, at - start);
+    } else {
+        return false;
+    }
+    event.message = message.substr(0, kMessageLength);
+    return true;
+}
+
+void KernelEventMonitor::start() {
+    if (isRunning()) {
+        return;
+    }
+    stats.status.clear();
+    kmsgFd = ::open(kmsgPath.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (kmsgFd < 0) {
+        stats.status = errno == EPERM || errno == EACCES ? "no access to /dev/kmsg (dmesg_restrict, needs CAP_SYSLOG)"
+                                                          : strerror(errno);
+        stats.available = false;
+        return;
+    }
+    // Only messages from now on; the backlog was logged before we were watching.
+    lseek(kmsgFd, 0, SEEK_END);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        stop();
+        return;
+    }
+    stats.available = true;
+    running = true;
+    worker = std::thread(&KernelEventMonitor::run, this);
+}
+
+void KernelEventMonitor::stop() {
+    if (worker.joinable()) {
+        running = false;
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+        worker.join();
+    }
+    if (kmsgFd >= 0) close(kmsgFd);
+    if (wakeFd >= 0) close(wakeFd);
+    kmsgFd = -1;
+    wakeFd = -1;
+}
+
+void KernelEventMonitor::run() {
+    // Each read() returns exactly one record, so the buffer only needs to fit the longest line.
+    char record[8192];
+    pollfd fds[2] = {{kmsgFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    while (running) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            continue; // stop() woke us; the loop condition decides
+        }
+        while (running) {
+            ssize_t n = read(kmsgFd, record, sizeof(record) - 1);
+            if (n > 0) {
+                handleRecord(record, n);
+            } else if (n < 0 && errno == EPIPE) {
+                continue; // records were overwritten before we got to them, carry on from the next one
+            } else {
+                break; // EAGAIN: drained
+            }
+        }
+    }
+}
+
+void KernelEventMonitor::handleRecord(const char* record, size_t length) {
+    // "prio,seq,timestamp_us,flags[,...];message\n" followed by optional " KEY=value" lines.
+    const char* end = record + length;
+    const char* semicolon = static_cast<const char*>(memchr(record, ';', length));
+    if (!semicolon) {
+        return;
+    }
+    const char* field = static_cast<const char*>(memchr(record, ',', semicolon - record));
+    field = field ? static_cast<const char*>(memchr(field + 1, ',', semicolon - field - 1)) : nullptr;
+    unsigned long long timestampUs = field ? strtoull(field + 1, nullptr, 10) : 0;
+
+    const char* text = semicolon + 1;
+    const char* newline = static_cast<const char*>(memchr(text, '\n', end - text));
+    std::string message(text, newline ? newline : end);
+
+    KernelEvent event;
+    if (!classify(message, event)) {
+        return;
+    }
+    timespec monotonic;
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    long long nowUs = monotonic.tv_sec * 1000000LL + monotonic.tv_nsec / 1000;
+    long long agoSeconds = timestampUs > 0 && static_cast<long long>(timestampUs) < nowUs
+                               ? (nowUs - static_cast<long long>(timestampUs)) / 1000000 : 0;
+    event.when = std::time(nullptr) - agoSeconds;
+
+    {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        counts[static_cast<int>(event.type)]++;
+        if (events.size() < static_cast<size_t>(kMaxEvents)) {
+            events.push_back(std::move(event));
+        } else {
+            events[nextEvent] = std::move(event);
+        }
+        nextEvent = (nextEvent + 1) % kMaxEvents;
+        recorded++;
+    }
+    if (notifyFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(notifyFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void KernelEventMonitor::update() {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+
+    long long oomKills = 0;
+    KeyField fields[] = {{"oom_kill", &oomKills}};
+    if (vmstatFile.read() && parseKeyTable(vmstatFile.view(), fields, 1) == 1) {
+        if (hasPrev && elapsed.count() > 0 && oomKills >= prevOomKills) {
+            stats.oomKillRate = (oomKills - prevOomKills) / elapsed.count();
+        }
+        stats.oomKillTotal = oomKills;
+        prevOomKills = oomKills;
+        hasPrev = true;
+    }
+
+    // Events are rare, so most updates have nothing new and skip re-copying every string.
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    if (recorded == copiedRecorded) {
+        return;
+    }
+    copiedRecorded = recorded;
+    stats.events.clear();
+    for (size_t i = 0; i < events.size(); ++i) {
+        stats.events.push_back(events[(nextEvent + events.size() - 1 - i) % events.size()]);
+    }
+    std::copy(counts, counts + static_cast<int>(KernelEventType::Count), stats.counts);
+}
@@ -0,0 +1,82 @@
+#ifndef KERNEL_EVENT_MONITOR_H
+#define KERNEL_EVENT_MONITOR_H
+
+#include "ProcFile.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class KernelEventType { OomKill, HungTask, SoftLockup, MachineCheck, NicReset, Count };
+
+struct KernelEvent {
+    KernelEventType type = KernelEventType::OomKill;
+    std::time_t when = 0;
+    std::string victim;    // killed/stuck process, or the interface for NIC resets
+    int pid = 0;
+    std::string message;   // the kernel line, shortened
+};
+
+struct KernelEventStats {
+    bool available = false;
+    std::string status;
+    std::vector<KernelEvent> events; // newest first
+    int counts[static_cast<int>(KernelEventType::Count)] = {};
+    double oomKillRate = 0.0;        // /proc/vmstat oom_kill per second
+    long long oomKillTotal = 0;
+};
+
+class KernelEventMonitor {
+public:
+    // Tails /dev/kmsg from its current end on a thread that sleeps in poll() until the kernel logs
+    // something, and picks out the handful of messages that explain sudden stalls and drops.
+    static constexpr int kMaxEvents = 32;
+
+    explicit KernelEventMonitor(const std::string& kmsgPath = "/dev/kmsg", const std::string& procRoot = "/proc");
+    ~KernelEventMonitor();
+    KernelEventMonitor(const KernelEventMonitor&) = delete;
+    KernelEventMonitor& operator=(const KernelEventMonitor&) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const { return worker.joinable(); }
+    // Optional eventfd poked after each recorded event; set it before start().
+    void setNotifyFd(int fd) { notifyFd = fd; }
+
+    // Reads the oom_kill counter and copies out the events seen so far.
+    void update();
+    const KernelEventStats& getStats() const { return stats; }
+
+    static const char* typeName(KernelEventType type);
+    // Exposed so the patterns can be checked against captured log lines.
+    static bool classify(const std::string& message, KernelEvent& event);
+
+private:
+    std::string kmsgPath;
+    int kmsgFd;
+    int wakeFd;
+    int notifyFd;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    std::mutex eventsMutex;
+    std::vector<KernelEvent> events; // ring, oldest overwritten first
+    size_t nextEvent;
+    unsigned long long recorded;       // events ever added, so update() can tell the ring moved
+    unsigned long long copiedRecorded; // recorded as of the last copy into stats
+    int counts[static_cast<int>(KernelEventType::Count)] = {};
+
+    ProcFile vmstatFile;
+    long long prevOomKills;
+    bool hasPrev;
+    std::chrono::steady_clock::time_point lastSample;
+    KernelEventStats stats;
+
+    void run();
+    void handleRecord(const char* record, size_t length);
+};
+
+#endif
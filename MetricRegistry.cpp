@@ -0,0 +1,31 @@
+#include "MetricRegistry.h"
+#include <cmath>
+#include <cstdio>
+
+const MetricDescriptor* findMetricByShowKey(const std::string& key) {
+    for (const MetricDescriptor& metric : kMetrics) {
+        if (metric.showKey && key == metric.showKey) return &metric;
+    }
+    return nullptr;
+}
+
+bool formatMetric(char* out, size_t size, const MetricDescriptor& metric, const MetricSnapshot& values) {
+    double value = values[metric.id] * metric.scale;
+    if (metric.hideZero && std::fabs(value) < 0.05) {
+        return false;
+    }
+    int length = snprintf(out, size, "%s: ", metric.label);
+    if (length < 0 || static_cast<size_t>(length) >= size) return true;
+    length += snprintf(out + length, size - length, metric.format, value);
+    if (metric.of == MetricId::Count || static_cast<size_t>(length) >= size) return true;
+
+    // The total is shown in the same format, so both sides share a unit.
+    const MetricDescriptor& total = metricDescriptor(metric.of);
+    double totalValue = values[metric.of] * total.scale;
+    length += snprintf(out + length, size - length, " / ");
+    if (static_cast<size_t>(length) >= size) return true;
+    length += snprintf(out + length, size - length, total.format, totalValue);
+    if (static_cast<size_t>(length) >= size) return true;
+    snprintf(out + length, size - length, " (%.2f%%)", totalValue > 0 ? value / totalValue * 100.0 : 0.0);
+    return true;
+}
@@ -0,0 +1,133 @@
+#ifndef METRIC_REGISTRY_H
+#define METRIC_REGISTRY_H
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+// The single-value metrics every update produces. Tables (interrupts, NUMA nodes, probes, GPU
+// cards, ...) keep their own structs; these are the numbers that get one line each.
+// Adding one: an id here, a descriptor in kMetrics, and the line in SystemMonitor that sets it.
+enum class MetricId {
+    CpuUsage, CpuSteal, CpuGuest, CpuTemperature,
+    MemoryUsed, MemoryTotal, MemoryAvailable,
+    NetDown, NetUp, Ping,
+    GpuUsage, GpuMemoryUsed, GpuMemoryTotal, GpuTemperature,
+    Fps, AppCpu, AppMemory,
+    Count
+};
+
+constexpr size_t kMetricCount = static_cast<size_t>(MetricId::Count);
+
+// Sources that run on the collector pool, in registration order.
+enum class CollectorSource {
+    CpuTemperature, Gpu, CgroupCpu, Interrupts, PerfCounters, RunqueueLatency, Numa, CompressedMemory, Tcp,
+    PacketDrops, GpuProcesses, CustomMetrics, Count
+};
+
+// Raw counters are differenced into rates before they get here, so there is no counter kind.
+enum class MetricKind {
+    Gauge, // a level: CPU %, a temperature, memory in use
+    Rate,  // per second, already differenced
+};
+
+// Where the overlay draws it. GpuCards ones get a line per card from the GPU block, which has
+// more to show (clock, driver, power); the snapshot holds the first card. Hidden ones are still
+// in every snapshot (spike captures record them), they just have no line of their own.
+enum class MetricPlace { Overlay, Debug, GpuCards, Hidden };
+
+struct MetricDescriptor {
+    MetricId id;
+    const char* name;    // "cpu_usage"
+    const char* label;   // what the line starts with
+    const char* unit;    // of the stored value, before scale
+    MetricKind kind;
+    const char* format;  // printf for the one double, after scale
+    double scale;
+    MetricPlace place;
+    const char* showKey; // config.ini toggle, nullptr for none
+    bool shownByDefault;
+    CollectorSource source = CollectorSource::Count; // pool source that fills it in, Count for the core update
+    MetricId of = MetricId::Count;  // drawn as "value / of (percent)"
+    bool hideZero = false;          // no line while it rounds to 0, e.g. steal time on bare metal
+};
+
+inline constexpr MetricDescriptor kMetrics[] = {
+    {MetricId::CpuUsage, "cpu_usage", "CPU", "%", MetricKind::Gauge, "%.2f%%", 1.0, MetricPlace::Overlay,
+     "show_cpu_usage", true},
+    {MetricId::CpuSteal, "cpu_steal", "CPU Steal", "%", MetricKind::Gauge, "%.1f%%", 1.0, MetricPlace::Overlay,
+     "show_cpu_steal", true, CollectorSource::Count, MetricId::Count, true},
+    {MetricId::CpuGuest, "cpu_guest", "CPU Guest", "%", MetricKind::Gauge, "%.1f%%", 1.0, MetricPlace::Overlay,
+     "show_cpu_guest", true, CollectorSource::Count, MetricId::Count, true},
+    {MetricId::CpuTemperature, "cpu_temp", "CPU Temp", "C", MetricKind::Gauge, "%.0f C", 1.0,
+     MetricPlace::Overlay, "show_cpu_temp", true, CollectorSource::CpuTemperature},
+    {MetricId::MemoryUsed, "memory_used", "Mem", "KB", MetricKind::Gauge, "%.0f MB", 1.0 / 1024,
+     MetricPlace::Overlay, "show_memory_stats", true, CollectorSource::Count, MetricId::MemoryTotal},
+    {MetricId::MemoryTotal, "memory_total", "Mem Total", "KB", MetricKind::Gauge, "%.0f MB", 1.0 / 1024,
+     MetricPlace::Hidden, nullptr, false},
+    {MetricId::MemoryAvailable, "memory_available", "Mem Available", "KB", MetricKind::Gauge, "%.0f MB",
+     1.0 / 1024, MetricPlace::Hidden, nullptr, false},
+    {MetricId::NetDown, "net_down", "Net Down", "B/s", MetricKind::Rate, "%.2f KB/s", 1.0 / 1024,
+     MetricPlace::Overlay, "show_net_down", true},
+    {MetricId::NetUp, "net_up", "Net Up", "B/s", MetricKind::Rate, "%.2f KB/s", 1.0 / 1024, MetricPlace::Overlay,
+     "show_net_up", true},
+    {MetricId::Ping, "ping", "Ping", "ms", MetricKind::Gauge, "%.2f ms", 1.0, MetricPlace::Overlay, "show_ping",
+     true},
+    {MetricId::GpuUsage, "gpu_usage", "GPU Usage", "%", MetricKind::Gauge, "%.0f%%", 1.0, MetricPlace::GpuCards,
+     "show_gpu_usage", true, CollectorSource::Gpu},
+    {MetricId::GpuMemoryUsed, "gpu_memory_used", "GPU Mem", "MB", MetricKind::Gauge, "%.0f MB", 1.0,
+     MetricPlace::GpuCards, "show_gpu_mem", true, CollectorSource::Gpu, MetricId::GpuMemoryTotal},
+    {MetricId::GpuMemoryTotal, "gpu_memory_total", "GPU Mem Total", "MB", MetricKind::Gauge, "%.0f MB", 1.0,
+     MetricPlace::Hidden, nullptr, false, CollectorSource::Gpu},
+    {MetricId::GpuTemperature, "gpu_temp", "GPU Temp", "C", MetricKind::Gauge, "%.0f C", 1.0,
+     MetricPlace::GpuCards, "show_gpu_temp", true, CollectorSource::Gpu},
+    {MetricId::Fps, "fps", "FPS", "frames/s", MetricKind::Rate, "%.2f", 1.0, MetricPlace::Overlay, "show_fps",
+     true},
+    {MetricId::AppCpu, "app_cpu", "App CPU", "%", MetricKind::Gauge, "%.2f%%", 1.0, MetricPlace::Debug,
+     "show_app_cpu", true},
+    {MetricId::AppMemory, "app_memory", "App Mem", "KB", MetricKind::Gauge, "%.0f KB", 1.0, MetricPlace::Debug,
+     "show_app_mem", true},
+};
+
+constexpr bool metricsInOrder() {
+    for (size_t i = 0; i < std::size(kMetrics); ++i) {
+        if (static_cast<size_t>(kMetrics[i].id) != i) return false;
+    }
+    return std::size(kMetrics) == kMetricCount;
+}
+static_assert(metricsInOrder(), "kMetrics needs one descriptor per MetricId, in MetricId order");
+
+constexpr const MetricDescriptor& metricDescriptor(MetricId id) {
+    return kMetrics[static_cast<size_t>(id)];
+}
+
+// Every metric's value from one update, indexed by id. Plain doubles, so copying one is a memcpy.
+struct MetricSnapshot {
+    double values[kMetricCount] = {};
+
+    double& operator[](MetricId id) { return values[static_cast<size_t>(id)]; }
+    double operator[](MetricId id) const { return values[static_cast<size_t>(id)]; }
+};
+static_assert(std::is_trivially_copyable_v<MetricSnapshot>, "snapshots are copied with memcpy");
+
+// Which lines are switched on, indexed by id like the snapshot.
+using MetricVisibility = std::array<bool, kMetricCount>;
+
+constexpr MetricVisibility defaultMetricVisibility() {
+    MetricVisibility shown{};
+    for (const MetricDescriptor& metric : kMetrics) {
+        shown[static_cast<size_t>(metric.id)] = metric.shownByDefault;
+    }
+    return shown;
+}
+
+// The metric whose config toggle is key, or nullptr.
+const MetricDescriptor* findMetricByShowKey(const std::string& key);
+
+// "Label: value", with " / of (percent)" for metrics that have one. Returns false for a hideZero
+// metric that rounds to 0.
+bool formatMetric(char* out, size_t size, const MetricDescriptor& metric, const MetricSnapshot& values);
+
+#endif
@@ -0,0 +1,85 @@
+#include "NumaMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+
+NumaMonitor::NumaMonitor(const std::string& nodeRoot) {
+    // Nodes don't come and go at runtime, so list them once and keep their files open.
+    DIR* dir = opendir(nodeRoot.c_str());
+    if (dir) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            std::string name = ent->d_name;
+            if (name.rfind("node", 0) != 0 || name.size() == 4 || name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                continue;
+            }
+            Node node;
+            node.id = atoi(name.c_str() + 4);
+            node.meminfo.open(nodeRoot + "/" + name + "/meminfo");
+            node.numastat.open(nodeRoot + "/" + name + "/numastat");
+            nodes.push_back(std::move(node));
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+    stats.nodes.resize(nodes.size());
+    lastSample = std::chrono::steady_clock::now();
+}
+
+void NumaMonitor::update() {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+
+    double totalHit = 0.0, totalMiss = 0.0, totalLocal = 0.0, totalOther = 0.0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Node& node = nodes[i];
+        NumaNodeStats& out = stats.nodes[i];
+        out.node = node.id;
+
+        const KeyField memFields[] = {
+            {"MemTotal", &out.totalMemory},
+            {"MemFree", &out.freeMemory},
+        };
+        if (node.meminfo.read()) {
+            parseKeyTable(node.meminfo.view(), memFields, 2, 2);
+            out.usedMemory = out.totalMemory - out.freeMemory;
+        }
+
+        long long current[6] = {};
+        const KeyField statFields[] = {
+            {"numa_hit", &current[0]},
+            {"numa_miss", &current[1]},
+            {"numa_foreign", &current[2]},
+            {"interleave_hit", &current[3]},
+            {"local_node", &current[4]},
+            {"other_node", &current[5]},
+        };
+        if (!node.numastat.read() || parseKeyTable(node.numastat.view(), statFields, 6) == 0) {
+            node.hasPrev = false;
+            continue;
+        }
+
+        if (node.hasPrev && elapsed.count() > 0) {
+            double rates[6];
+            for (int k = 0; k < 6; ++k) {
+                rates[k] = std::max(0LL, current[k] - node.counters[k]) / elapsed.count();
+            }
+            out.hitRate = rates[0];
+            out.missRate = rates[1];
+            out.foreignRate = rates[2];
+            out.interleaveRate = rates[3];
+            out.localRate = rates[4];
+            out.otherRate = rates[5];
+            totalHit += rates[0];
+            totalMiss += rates[1];
+            totalLocal += rates[4];
+            totalOther += rates[5];
+        }
+        std::copy(current, current + 6, node.counters);
+        node.hasPrev = true;
+    }
+
+    stats.remotePercent = totalLocal + totalOther > 0 ? totalOther / (totalLocal + totalOther) * 100.0 : 0.0;
+    stats.missPercent = totalHit + totalMiss > 0 ? totalMiss / (totalHit + totalMiss) * 100.0 : 0.0;
+}
@@ -0,0 +1,50 @@
+#ifndef NUMA_MONITOR_H
+#define NUMA_MONITOR_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct NumaNodeStats {
+    int node = 0;
+    long long totalMemory = 0; // KB
+    long long freeMemory = 0;  // KB
+    long long usedMemory = 0;  // KB
+
+    double hitRate = 0.0;        // pages/s allocated here as intended
+    double missRate = 0.0;       // pages/s allocated here although another node was preferred
+    double foreignRate = 0.0;    // pages/s meant for here but placed on another node
+    double interleaveRate = 0.0; // interleave policy pages/s that landed here as intended
+    double localRate = 0.0;      // pages/s allocated here by a task running on this node
+    double otherRate = 0.0;      // pages/s allocated here by a task running on another node
+};
+
+struct NumaStats {
+    std::vector<NumaNodeStats> nodes;
+    double remotePercent = 0.0; // share of allocations served by a node other than the requester's
+    double missPercent = 0.0;   // share of allocations that didn't get their preferred node
+};
+
+class NumaMonitor {
+public:
+    // Per-node memory and numastat allocation rates from /sys/devices/system/node/node*.
+    explicit NumaMonitor(const std::string& nodeRoot = "/sys/devices/system/node");
+    void update();
+    const NumaStats& getStats() const { return stats; }
+
+private:
+    struct Node {
+        int id;
+        ProcFile meminfo;
+        ProcFile numastat;
+        long long counters[6] = {}; // numa_hit, numa_miss, numa_foreign, interleave_hit, local_node, other_node
+        bool hasPrev = false;
+    };
+
+    std::vector<Node> nodes;
+    std::chrono::steady_clock::time_point lastSample;
+    NumaStats stats;
+};
+
+#endif
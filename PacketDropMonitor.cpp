@@ -0,0 +1,179 @@
+#include "PacketDropMonitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+
+namespace {
+
+const char* const kNicCounterFiles[] = {
+    "rx_dropped",
+    "rx_missed_errors",
+    "rx_fifo_errors",
+    "tx_errors",
+};
+
+double counterRate(unsigned long long current, unsigned long long previous, double elapsed) {
+    return current >= previous ? (current - previous) / elapsed : 0.0;
+}
+
+} // namespace
+
+PacketDropMonitor::PacketDropMonitor(const std::string& netRoot)
+    : netRoot(netRoot), softnetHasPrev(false), updatesSinceRescan(0) {
+    softnetFile.open("/proc/net/softnet_stat");
+    rescanInterfaces();
+    lastSample = std::chrono::steady_clock::now();
+}
+
+void PacketDropMonitor::rescanInterfaces() {
+    // Interfaces come and go (VPNs, containers), so re-list them now and then and keep fds for the rest.
+    updatesSinceRescan = 0;
+    // The names go into strings kept from the last scan, so an unchanged list costs no allocations.
+    size_t count = 0;
+    DIR* dir = opendir(netRoot.c_str());
+    if (dir) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            const char* name = ent->d_name;
+            if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0 && strcmp(name, "lo") != 0) {
+                if (count == scannedNames.size()) {
+                    scannedNames.emplace_back();
+                }
+                scannedNames[count++].assign(name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(scannedNames.begin(), scannedNames.begin() + count);
+
+    bool same = count == nics.size();
+    for (size_t i = 0; same && i < count; ++i) {
+        same = scannedNames[i] == nics[i].name;
+    }
+    if (same) {
+        return;
+    }
+
+    std::vector<Nic> rescanned;
+    for (size_t n = 0; n < count; ++n) {
+        const std::string& name = scannedNames[n];
+        auto existing = std::find_if(nics.begin(), nics.end(), [&](const Nic& nic) { return nic.name == name; });
+        if (existing != nics.end()) {
+            rescanned.push_back(std::move(*existing));
+            continue;
+        }
+        Nic nic;
+        nic.name = name;
+        for (int i = 0; i < kNicCounters; ++i) {
+            nic.files[i].open(netRoot + "/" + name + "/statistics/" + kNicCounterFiles[i]);
+        }
+        rescanned.push_back(std::move(nic));
+    }
+    nics = std::move(rescanned);
+    nicReads.clear();
+    for (Nic& nic : nics) {
+        for (ProcFile& file : nic.files) {
+            nicReads.add(file);
+        }
+    }
+
+    stats.interfaces.resize(nics.size());
+    for (size_t i = 0; i < nics.size(); ++i) {
+        stats.interfaces[i] = NicDropStats();
+        stats.interfaces[i].name = nics[i].name;
+    }
+}
+
+void PacketDropMonitor::updateSoftnet(double elapsed) {
+    // One line per online CPU of hex columns: processed, dropped, time_squeeze, ..., and on newer
+    // kernels the CPU number in column 13.
+    stats.processedRate = 0.0;
+    stats.droppedRate = 0.0;
+    stats.timeSqueezeRate = 0.0;
+    if (!softnetFile.read()) {
+        softnetHasPrev = false;
+        stats.cpus.clear();
+        return;
+    }
+
+    const char* p = softnetFile.data();
+    const char* end = p + softnetFile.size();
+    size_t line = 0;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+
+        unsigned long long columns[13] = {};
+        int count = 0;
+        char* next = nullptr;
+        const char* q = p;
+        while (count < 13 && q < lineEnd) {
+            columns[count] = strtoull(q, &next, 16);
+            if (next == q) break;
+            q = next;
+            ++count;
+        }
+        if (count >= 3) {
+            if (softnetCounters.size() < (line + 1) * 3) {
+                softnetCounters.resize((line + 1) * 3);
+                softnetHasPrev = false;
+            }
+            if (stats.cpus.size() < line + 1) {
+                stats.cpus.resize(line + 1);
+            }
+            SoftnetCpuStats& cpu = stats.cpus[line];
+            cpu.cpu = count >= 13 ? static_cast<int>(columns[12]) : static_cast<int>(line);
+            unsigned long long* previous = softnetCounters.data() + line * 3;
+            if (softnetHasPrev && elapsed > 0) {
+                cpu.processedRate = counterRate(columns[0], previous[0], elapsed);
+                cpu.droppedRate = counterRate(columns[1], previous[1], elapsed);
+                cpu.timeSqueezeRate = counterRate(columns[2], previous[2], elapsed);
+                stats.processedRate += cpu.processedRate;
+                stats.droppedRate += cpu.droppedRate;
+                stats.timeSqueezeRate += cpu.timeSqueezeRate;
+            }
+            std::copy(columns, columns + 3, previous);
+            ++line;
+        }
+        p = lineEnd + 1;
+    }
+    if (stats.cpus.size() != line) {
+        stats.cpus.resize(line);
+        softnetCounters.resize(line * 3);
+    }
+    softnetHasPrev = true;
+}
+
+void PacketDropMonitor::updateNics(double elapsed) {
+    nicReads.read();
+    for (size_t i = 0; i < nics.size(); ++i) {
+        Nic& nic = nics[i];
+        NicDropStats& out = stats.interfaces[i];
+        unsigned long long current[kNicCounters] = {};
+        for (int k = 0; k < kNicCounters; ++k) {
+            if (nic.files[k].size() > 0) {
+                current[k] = strtoull(nic.files[k].data(), nullptr, 10);
+            }
+        }
+        if (nic.hasPrev && elapsed > 0) {
+            out.rxDroppedRate = counterRate(current[0], nic.counters[0], elapsed);
+            out.rxMissedRate = counterRate(current[1], nic.counters[1], elapsed);
+            out.rxFifoRate = counterRate(current[2], nic.counters[2], elapsed);
+            out.txErrorsRate = counterRate(current[3], nic.counters[3], elapsed);
+        }
+        std::copy(current, current + kNicCounters, nic.counters);
+        nic.hasPrev = true;
+    }
+}
+
+void PacketDropMonitor::update() {
+    if (++updatesSinceRescan >= kRescanInterval) {
+        rescanInterfaces();
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+    updateSoftnet(elapsed.count());
+    updateNics(elapsed.count());
+}
@@ -0,0 +1,69 @@
+#ifndef PACKET_DROP_MONITOR_H
+#define PACKET_DROP_MONITOR_H
+
+#include "ProcFile.h"
+#include "ProcFileBatch.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct SoftnetCpuStats {
+    int cpu = 0;
+    double processedRate = 0.0;
+    double droppedRate = 0.0;     // backlog queue full
+    double timeSqueezeRate = 0.0; // net_rx_action ran out of budget with work left
+};
+
+struct NicDropStats {
+    std::string name;
+    double rxDroppedRate = 0.0;
+    double rxMissedRate = 0.0;
+    double rxFifoRate = 0.0;
+    double txErrorsRate = 0.0;
+    bool hasDrops() const { return rxDroppedRate > 0 || rxMissedRate > 0 || rxFifoRate > 0 || txErrorsRate > 0; }
+};
+
+struct PacketDropStats {
+    std::vector<SoftnetCpuStats> cpus;
+    double processedRate = 0.0;
+    double droppedRate = 0.0;
+    double timeSqueezeRate = 0.0;
+    std::vector<NicDropStats> interfaces;
+    bool hasDrops() const { return droppedRate > 0 || timeSqueezeRate > 0; }
+};
+
+class PacketDropMonitor {
+public:
+    // Per-CPU softnet_stat and per-NIC drop/error counters, turned into rates.
+    explicit PacketDropMonitor(const std::string& netRoot = "/sys/class/net");
+    void update();
+    const PacketDropStats& getStats() const { return stats; }
+
+private:
+    static constexpr int kNicCounters = 4;
+    static constexpr int kRescanInterval = 10; // updates between interface rescans
+
+    struct Nic {
+        std::string name;
+        ProcFile files[kNicCounters];
+        unsigned long long counters[kNicCounters] = {};
+        bool hasPrev = false;
+    };
+
+    std::string netRoot;
+    ProcFile softnetFile;
+    std::vector<unsigned long long> softnetCounters; // 3 per CPU line
+    bool softnetHasPrev;
+    std::vector<Nic> nics;
+    std::vector<std::string> scannedNames; // reused by rescanInterfaces(), may hold stale extras
+    ProcFileBatch nicReads; // every counter file of every NIC, one batch per update
+    int updatesSinceRescan;
+    std::chrono::steady_clock::time_point lastSample;
+    PacketDropStats stats;
+
+    void rescanInterfaces();
+    void updateSoftnet(double elapsed);
+    void updateNics(double elapsed);
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "PerfCounterMonitor.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const uint64_t kSoftwareEvents[] = {
+    PERF_COUNT_SW_CONTEXT_SWITCHES,
+    PERF_COUNT_SW_CPU_MIGRATIONS,
+    PERF_COUNT_SW_PAGE_FAULTS,
+    PERF_COUNT_SW_PAGE_FAULTS_MAJ,
+};
+
+const uint64_t kHardwareEvents[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+
+long perfEventOpen(perf_event_attr* attr, pid_t pid, int cpu, int groupFd, unsigned long flags) {
+    return syscall(SYS_perf_event_open, attr, pid, cpu, groupFd, flags);
+}
+
+} // namespace
+
+PerfCounterMonitor::PerfCounterMonitor() : opened(false) {}
+
+PerfCounterMonitor::~PerfCounterMonitor() {
+    closeCounters();
+}
+
+int PerfCounterMonitor::readParanoidLevel() {
+    std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+    int level = 2;
+    file >> level;
+    return level;
+}
+
+void PerfCounterMonitor::raiseFileLimit(int cpuCount) {
+    // 7 fds per CPU is ~1800 on a 256-CPU host, well past the usual soft limit of 1024.
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return;
+    }
+    rlim_t wanted = limit.rlim_cur + static_cast<rlim_t>(cpuCount) * (std::size(kSoftwareEvents) + std::size(kHardwareEvents));
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max == RLIM_INFINITY ? wanted : std::min(wanted, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int PerfCounterMonitor::openGroup(Group& group, int cpu, uint32_t type, const uint64_t* configs, int count) {
+    // Returns 0 on success or the errno of the first event that couldn't be opened.
+    for (int i = 0; i < count; ++i) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = (i == 0);
+        int leader = group.fds.empty() ? -1 : group.fds[0];
+        int fd = perfEventOpen(&attr, -1, cpu, leader, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0) {
+            int err = errno;
+            for (int open : group.fds) ::close(open);
+            group.fds.clear();
+            return err;
+        }
+        group.fds.push_back(fd);
+    }
+    ioctl(group.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return 0;
+}
+
+void PerfCounterMonitor::openCounters() {
+    opened = true;
+    stats = PerfCounterStats();
+    int cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+    raiseFileLimit(cpuCount);
+
+    int softwareError = 0;
+    int onlineCpus = 0;
+    for (int cpu = 0; cpu < cpuCount; ++cpu) {
+        Group group;
+        int err = openGroup(group, cpu, PERF_TYPE_SOFTWARE, kSoftwareEvents, 4);
+        if (err == 0) {
+            softwareGroups.push_back(std::move(group));
+        } else if (err == EMFILE || err == ENFILE) {
+            // Out of fds even after raising the limit: count what did open and say so below.
+            softwareError = err;
+        } else if (err != ENODEV) { // ENODEV is just an offline CPU
+            softwareError = err;
+            break;
+        }
+        if (err != ENODEV) onlineCpus++;
+    }
+    if ((softwareError != 0 && softwareError != EMFILE && softwareError != ENFILE) || softwareGroups.empty()) {
+        closeCounters();
+        opened = true;
+        if (softwareError == EACCES || softwareError == EPERM) {
+            stats.status = "blocked by perf_event_paranoid=" + std::to_string(readParanoidLevel()) +
+                           " (needs <= 0 or CAP_PERFMON)";
+        } else {
+            stats.status = std::string("perf_event_open failed: ") + strerror(softwareError);
+        }
+        return;
+    }
+    stats.softwareAvailable = true;
+
+    // VMs usually have no virtual PMU, and hybrid CPUs may refuse some cores. Those are skipped,
+    // but the status says when IPC only covers part of the machine.
+    int hardwareError = 0;
+    for (int cpu = 0; cpu < cpuCount; ++cpu) {
+        Group group;
+        int err = openGroup(group, cpu, PERF_TYPE_HARDWARE, kHardwareEvents, 3);
+        if (err == 0) {
+            hardwareGroups.push_back(std::move(group));
+        } else if (err != ENODEV) {
+            hardwareError = err;
+        }
+    }
+    stats.hardwareAvailable = !hardwareGroups.empty();
+    int softwareCpus = static_cast<int>(softwareGroups.size());
+    int hardwareCpus = static_cast<int>(hardwareGroups.size());
+    if (softwareCpus < onlineCpus) {
+        stats.status = "counting " + std::to_string(softwareCpus) + " of " + std::to_string(onlineCpus) +
+                       " CPUs: " + strerror(softwareError);
+    } else if (!stats.hardwareAvailable && (hardwareError == EMFILE || hardwareError == ENFILE)) {
+        stats.status = std::string("IPC unavailable: ") + strerror(hardwareError);
+    } else if (!stats.hardwareAvailable) {
+        stats.status = "no hardware PMU, IPC unavailable";
+    } else if (hardwareCpus < softwareCpus) {
+        stats.status = "IPC from " + std::to_string(hardwareCpus) + " of " + std::to_string(softwareCpus) +
+                       " CPUs: " + strerror(hardwareError);
+    }
+    lastSample = std::chrono::steady_clock::now();
+}
+
+void PerfCounterMonitor::close() {
+    if (opened) {
+        closeCounters();
+    }
+}
+
+void PerfCounterMonitor::closeCounters() {
+    for (auto* groups : {&softwareGroups, &hardwareGroups}) {
+        for (Group& group : *groups) {
+            for (int fd : group.fds) ::close(fd);
+        }
+        groups->clear();
+    }
+    opened = false;
+}
+
+bool PerfCounterMonitor::readGroup(Group& group, int count, double* deltas) {
+    // Layout for PERF_FORMAT_GROUP with both time fields: nr, time_enabled, time_running, value[nr].
+    uint64_t buffer[3 + kMaxGroupEvents];
+    ssize_t expected = sizeof(uint64_t) * (3 + count);
+    if (read(group.fds[0], buffer, sizeof(buffer)) < expected || buffer[0] != static_cast<uint64_t>(count)) {
+        return false;
+    }
+    uint64_t enabled = buffer[1];
+    uint64_t running = buffer[2];
+    if (group.hasPrev) {
+        // Scale by enabled/running so multiplexed hardware counters still give whole-interval numbers.
+        uint64_t enabledDiff = enabled - group.prevEnabled;
+        uint64_t runningDiff = running - group.prevRunning;
+        double scale = runningDiff > 0 ? static_cast<double>(enabledDiff) / runningDiff : 0.0;
+        for (int i = 0; i < count; ++i) {
+            deltas[i] += (buffer[3 + i] - group.prevValues[i]) * scale;
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        group.prevValues[i] = buffer[3 + i];
+    }
+    group.prevEnabled = enabled;
+    group.prevRunning = running;
+    bool hadPrev = group.hasPrev;
+    group.hasPrev = true;
+    return hadPrev;
+}
+
+void PerfCounterMonitor::update() {
+    if (!opened) {
+        openCounters();
+    }
+    if (!stats.softwareAvailable) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+
+    double software[4] = {};
+    bool haveSoftware = false;
+    for (Group& group : softwareGroups) {
+        haveSoftware |= readGroup(group, 4, software);
+    }
+    double hardware[3] = {};
+    bool haveHardware = false;
+    for (Group& group : hardwareGroups) {
+        haveHardware |= readGroup(group, 3, hardware);
+    }
+
+    if (elapsed.count() <= 0) {
+        return;
+    }
+    if (haveSoftware) {
+        stats.contextSwitchesPerSec = software[0] / elapsed.count();
+        stats.migrationsPerSec = software[1] / elapsed.count();
+        stats.pageFaultsPerSec = software[2] / elapsed.count();
+        stats.majorFaultsPerSec = software[3] / elapsed.count();
+    }
+    if (haveHardware) {
+        stats.instructionsPerCycle = hardware[0] > 0 ? hardware[1] / hardware[0] : 0.0;
+        stats.cacheMissesPerSec = hardware[2] / elapsed.count();
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef PERF_COUNTER_MONITOR_H
+#define PERF_COUNTER_MONITOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PerfCounterStats {
+    bool softwareAvailable = false;
+    bool hardwareAvailable = false;
+    std::string status; // why counters are missing, empty when everything opened
+
+    double contextSwitchesPerSec = 0.0;
+    double migrationsPerSec = 0.0;
+    double pageFaultsPerSec = 0.0;
+    double majorFaultsPerSec = 0.0;
+
+    double instructionsPerCycle = 0.0;
+    double cacheMissesPerSec = 0.0;
+};
+
+class PerfCounterMonitor {
+public:
+    // System-wide per-CPU perf_event counters. Each CPU gets one software group and, when a PMU
+    // exists, one hardware group, and every group is read with a single PERF_FORMAT_GROUP read().
+    PerfCounterMonitor();
+    ~PerfCounterMonitor();
+    PerfCounterMonitor(const PerfCounterMonitor&) = delete;
+    PerfCounterMonitor& operator=(const PerfCounterMonitor&) = delete;
+
+    void update();
+    // Gives the PMU counters and fds back while the collector is switched off; the next update()
+    // opens them again. Only while update() isn't running.
+    void close();
+    const PerfCounterStats& getStats() const { return stats; }
+
+private:
+    static constexpr int kMaxGroupEvents = 4;
+
+    struct Group {
+        std::vector<int> fds; // fds[0] is the group leader
+        uint64_t prevValues[kMaxGroupEvents] = {};
+        uint64_t prevEnabled = 0;
+        uint64_t prevRunning = 0;
+        bool hasPrev = false;
+    };
+
+    bool opened;
+    std::vector<Group> softwareGroups;
+    std::vector<Group> hardwareGroups;
+    std::chrono::steady_clock::time_point lastSample;
+    PerfCounterStats stats;
+
+    void openCounters();
+    void closeCounters();
+    static int openGroup(Group& group, int cpu, uint32_t type, const uint64_t* configs, int count);
+    static bool readGroup(Group& group, int count, double* deltas);
+    static int readParanoidLevel();
+    static void raiseFileLimit(int cpuCount);
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "PressureTrigger.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+PressureTrigger::PressureTrigger(const std::string& procRoot, int stallUs, int windowUs) : fireCount(0), notified(false) {
+    char trigger[64];
+    snprintf(trigger, sizeof(trigger), "some %d %d", stallUs, windowUs);
+    for (const char* resource : {"cpu", "memory", "io"}) {
+        int fd = open((procRoot + "/pressure/" + resource).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        // The trigger lives as long as the fd; the write fails without PSI or the permission for it.
+        if (write(fd, trigger, strlen(trigger) + 1) < 0) {
+            close(fd);
+            continue;
+        }
+        fds.push_back(fd);
+    }
+}
+
+PressureTrigger::~PressureTrigger() {
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+void PressureTrigger::notify() {
+    notified = true;
+}
+
+bool PressureTrigger::check() {
+    bool fired = notified;
+    notified = false;
+    for (int fd : fds) {
+        pollfd entry = {fd, POLLPRI, 0};
+        if (poll(&entry, 1, 0) > 0 && (entry.revents & POLLPRI)) {
+            fired = true;
+        }
+    }
+    if (fired) {
+        fireCount++;
+    }
+    return fired;
+}
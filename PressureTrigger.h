@@ -0,0 +1,32 @@
+#ifndef PRESSURE_TRIGGER_H
+#define PRESSURE_TRIGGER_H
+
+#include <string>
+#include <vector>
+
+class PressureTrigger {
+public:
+    // Kernel PSI triggers on /proc/pressure/{cpu,memory,io}: the kernel raises POLLPRI when tasks
+    // stalled for more than stallUs within windowUs, so a stall is noticed without reading the
+    // averages. Unprivileged triggers need the window to be a multiple of 2 s.
+    explicit PressureTrigger(const std::string& procRoot = "/proc", int stallUs = 300000, int windowUs = 2000000);
+    ~PressureTrigger();
+    PressureTrigger(const PressureTrigger&) = delete;
+    PressureTrigger& operator=(const PressureTrigger&) = delete;
+
+    // Non-blocking; true if any resource fired since the last call.
+    bool check();
+    // For callers polling getFds() themselves: poll/epoll consumes the POLLPRI, so they report
+    // it here and the next check() returns true.
+    void notify();
+    bool isAvailable() const { return !fds.empty(); }
+    const std::vector<int>& getFds() const { return fds; }
+    int getFireCount() const { return fireCount; }
+
+private:
+    std::vector<int> fds;
+    int fireCount;
+    bool notified;
+};
+
+#endif
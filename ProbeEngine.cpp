@@ -0,0 +1,310 @@
+#include "ProbeEngine.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace {
+
+constexpr auto kResolveInterval = std::chrono::seconds(60);
+constexpr auto kFirstResolveRetry = std::chrono::seconds(1); // doubles per failure up to kResolveInterval
+
+double percentileOf(const double* samples, int count, double fraction) {
+    if (count == 0) {
+        return 0.0;
+    }
+    double sorted[ProbeEngine::kWindow];
+    std::copy(samples, samples + count, sorted);
+    std::sort(sorted, sorted + count);
+    int index = std::min(count - 1, static_cast<int>(fraction * count));
+    return sorted[index];
+}
+
+double millisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+bool ProbeTarget::parse(const std::string& spec, ProbeTarget& out) {
+    out = ProbeTarget();
+    std::string rest = spec;
+    rest.erase(0, rest.find_first_not_of(" \t"));
+    rest.erase(rest.find_last_not_of(" \t") + 1);
+    if (rest.rfind("http://", 0) == 0) {
+        out.http = true;
+        out.port = "80";
+        rest = rest.substr(7);
+        size_t slash = rest.find('/');
+        if (slash != std::string::npos) {
+            out.path = rest.substr(slash);
+            rest = rest.substr(0, slash);
+        }
+    }
+
+    size_t colon;
+    if (!rest.empty() && rest[0] == '[') {
+        size_t close = rest.find(']');
+        if (close == std::string::npos) return false;
+        out.host = rest.substr(1, close - 1);
+        colon = rest.find(':', close);
+    } else {
+        colon = rest.rfind(':');
+        out.host = rest.substr(0, colon);
+    }
+    if (colon != std::string::npos) {
+        out.port = rest.substr(colon + 1);
+    }
+    return !out.host.empty() && !out.port.empty();
+}
+
+std::string ProbeTarget::label() const {
+    std::string label = host.find(':') != std::string::npos ? "[" + host + "]:" + port : host + ":" + port;
+    return http ? "http://" + label + path : label;
+}
+
+ProbeEngine::ProbeEngine() : interval(5000), timeout(1000) {}
+
+ProbeEngine::~ProbeEngine() {
+    stop();
+}
+
+void ProbeEngine::start(const std::vector<ProbeTarget>& newTargets, int intervalMs, int timeoutMs) {
+    stop();
+    if (newTargets.empty()) {
+        return;
+    }
+    interval = std::chrono::milliseconds(std::max(100, intervalMs));
+    timeout = std::chrono::milliseconds(std::max(10, timeoutMs));
+
+    targets.clear();
+    targets.resize(newTargets.size());
+    sockets.assign(newTargets.size(), -1);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.assign(newTargets.size(), ProbeStats());
+        for (size_t i = 0; i < newTargets.size(); ++i) {
+            targets[i].spec = newTargets[i];
+            stats[i].label = newTargets[i].label();
+            stats[i].http = newTargets[i].http;
+            if (newTargets[i].http) {
+                targets[i].request = "GET " + newTargets[i].path + " HTTP/1.1\r\nHost: " + newTargets[i].host +
+                                     "\r\nUser-Agent: StatsBy0113\r\nConnection: close\r\n\r\n";
+            }
+        }
+    }
+
+    if (!reactor.isAvailable()) {
+        return;
+    }
+    for (size_t i = 0; i < targets.size(); ++i) {
+        reactor.spawn(probeLoop(i));
+    }
+    worker = std::thread([this] { reactor.run(); });
+}
+
+void ProbeEngine::stop() {
+    if (worker.joinable()) {
+        reactor.stop();
+        worker.join();
+    }
+    reactor.clear();
+    for (int& fd : sockets) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void ProbeEngine::copyStats(std::vector<ProbeStats>& out) const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    out = stats;
+}
+
+ProbeEngine::Lookup::~Lookup() {
+    if (doneFd >= 0) {
+        close(doneFd);
+    }
+}
+
+bool ProbeEngine::startLookup(Target& target) {
+    auto lookup = std::make_shared<Lookup>();
+    lookup->host = target.spec.host;
+    lookup->port = target.spec.port;
+    lookup->doneFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (lookup->doneFd < 0) {
+        return false;
+    }
+    try {
+        std::thread([lookup] {
+            addrinfo hints;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* result = nullptr;
+            if (getaddrinfo(lookup->host.c_str(), lookup->port.c_str(), &hints, &result) == 0 && result) {
+                memcpy(&lookup->address, result->ai_addr, result->ai_addrlen);
+                lookup->addressLength = result->ai_addrlen;
+            }
+            if (result) freeaddrinfo(result);
+            lookup->done.store(true, std::memory_order_release);
+            uint64_t one = 1;
+            ssize_t ignored = write(lookup->doneFd, &one, sizeof(one));
+            (void)ignored;
+        }).detach();
+    } catch (const std::system_error&) {
+        return false;
+    }
+    target.lookup = std::move(lookup);
+    return true;
+}
+
+void ProbeEngine::finishLookup(Target& target) {
+    // Keeps the old address when a refresh fails, and retries sooner than the usual minute.
+    auto now = Clock::now();
+    if (target.lookup && target.lookup->addressLength > 0) {
+        target.address = target.lookup->address;
+        target.addressLength = target.lookup->addressLength;
+        target.resolveFailures = 0;
+        target.nextResolve = now + kResolveInterval;
+    } else {
+        int shift = std::min(target.resolveFailures, 6);
+        target.resolveFailures++;
+        target.nextResolve = now + std::min<Clock::duration>(kFirstResolveRetry * (1 << shift), kResolveInterval);
+    }
+    target.lookup.reset();
+}
+
+Task<> ProbeEngine::probeLoop(size_t index) {
+    while (true) {
+        auto started = Clock::now();
+        co_await probe(index);
+        co_await reactor.sleepUntil(started + interval);
+    }
+}
+
+Task<> ProbeEngine::probe(size_t index) {
+    Target& target = targets[index];
+    if (!target.lookup && Clock::now() >= target.nextResolve && !startLookup(target)) {
+        finishLookup(target);
+    }
+    if (target.lookup && target.addressLength == 0) {
+        // Nothing to connect to yet, so wait for the first answer, but no longer than a probe.
+        bool answered = co_await reactor.readable(target.lookup->doneFd, Clock::now() + timeout);
+        (void)answered;
+    }
+    if (target.lookup && target.lookup->done.load(std::memory_order_acquire)) {
+        finishLookup(target);
+    }
+    if (target.addressLength == 0) {
+        finish(index, false, target.lookup ? "resolving" : "resolve failed", 0.0, 0.0);
+        co_return;
+    }
+
+    int fd = socket(target.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        finish(index, false, strerror(errno), 0.0, 0.0);
+        co_return;
+    }
+    sockets[index] = fd;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    auto started = Clock::now();
+    auto deadline = started + timeout;
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&target.address), target.addressLength) < 0 &&
+        errno != EINPROGRESS) {
+        finish(index, false, strerror(errno), 0.0, 0.0);
+        co_return;
+    }
+    bool connected = co_await reactor.writable(fd, deadline);
+    if (!connected) {
+        finish(index, false, "timeout", 0.0, 0.0);
+        co_return;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error != 0) {
+        finish(index, false, strerror(error), 0.0, 0.0);
+        co_return;
+    }
+    auto requestSent = Clock::now();
+    double connectMs = millisecondsBetween(started, requestSent);
+    if (!target.spec.http) {
+        finish(index, true, nullptr, connectMs, 0.0);
+        co_return;
+    }
+
+    // started..requestSent is the handshake, requestSent..first byte is the TTFB.
+    if (send(fd, target.request.data(), target.request.size(), MSG_NOSIGNAL) < 0) {
+        finish(index, false, strerror(errno), connectMs, 0.0);
+        co_return;
+    }
+    while (true) {
+        bool ready = co_await reactor.readable(fd, deadline);
+        if (!ready) {
+            break;
+        }
+        char firstBytes[64];
+        ssize_t received = recv(fd, firstBytes, sizeof(firstBytes), 0);
+        if (received > 0) {
+            finish(index, true, nullptr, connectMs, millisecondsBetween(requestSent, Clock::now()));
+            co_return;
+        }
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            finish(index, false, received == 0 ? "closed before response" : strerror(errno), connectMs, 0.0);
+            co_return;
+        }
+    }
+    finish(index, false, "timeout", 0.0, 0.0);
+}
+
+void ProbeEngine::finish(size_t index, bool ok, const char* error, double connectMs, double ttfbMs) {
+    Target& target = targets[index];
+    if (sockets[index] >= 0) {
+        close(sockets[index]);
+        sockets[index] = -1;
+    }
+
+    if (ok) {
+        target.connectSamples[target.nextConnect] = connectMs;
+        target.nextConnect = (target.nextConnect + 1) % kWindow;
+        target.connectCount = std::min(target.connectCount + 1, kWindow);
+        if (target.spec.http) {
+            target.ttfbSamples[target.nextTtfb] = ttfbMs;
+            target.nextTtfb = (target.nextTtfb + 1) % kWindow;
+            target.ttfbCount = std::min(target.ttfbCount + 1, kWindow);
+        }
+    }
+
+    double p50 = percentileOf(target.connectSamples, target.connectCount, 0.50);
+    double p95 = percentileOf(target.connectSamples, target.connectCount, 0.95);
+    double p99 = percentileOf(target.connectSamples, target.connectCount, 0.99);
+    double ttfb50 = percentileOf(target.ttfbSamples, target.ttfbCount, 0.50);
+    double ttfb99 = percentileOf(target.ttfbSamples, target.ttfbCount, 0.99);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    ProbeStats& out = stats[index];
+    out.ok = ok;
+    if (ok) {
+        out.lastError.clear();
+        out.lastConnectMs = connectMs;
+        out.lastTtfbMs = ttfbMs;
+    } else {
+        out.lastError = error ? error : "failed";
+        out.failures++;
+    }
+    out.p50ConnectMs = p50;
+    out.p95ConnectMs = p95;
+    out.p99ConnectMs = p99;
+    out.p50TtfbMs = ttfb50;
+    out.p99TtfbMs = ttfb99;
+    out.samples = target.connectCount;
+}
@@ -0,0 +1,111 @@
+#ifndef PROBE_ENGINE_H
+#define PROBE_ENGINE_H
+
+#include "Reactor.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+struct ProbeTarget {
+    std::string host;
+    std::string port;
+    bool http = false;      // also send a GET and time the first response byte
+    std::string path = "/";
+
+    // Accepts "host:port", "[v6addr]:port" or "http://host[:port][/path]".
+    static bool parse(const std::string& spec, ProbeTarget& out);
+    std::string label() const;
+};
+
+struct ProbeStats {
+    std::string label;
+    bool http = false;
+    bool ok = false;             // last probe succeeded
+    std::string lastError;
+    double lastConnectMs = 0.0;
+    double p50ConnectMs = 0.0;
+    double p95ConnectMs = 0.0;
+    double p99ConnectMs = 0.0;
+    double lastTtfbMs = 0.0;     // request sent -> first response byte, HTTP targets only
+    double p50TtfbMs = 0.0;
+    double p99TtfbMs = 0.0;
+    int samples = 0;             // successful probes in the rolling window
+    int failures = 0;            // failed probes since start
+};
+
+class ProbeEngine {
+public:
+    // Measures TCP handshake latency (and optionally HTTP time-to-first-byte) against a list of
+    // targets. Each target is a coroutine on one reactor thread, so every probe runs
+    // concurrently with non-blocking sockets and its own deadline. Host names are looked up on
+    // short-lived threads, since getaddrinfo can block for seconds.
+    static constexpr int kWindow = 64; // samples kept per target for the rolling percentiles
+
+    ProbeEngine();
+    ~ProbeEngine();
+    ProbeEngine(const ProbeEngine&) = delete;
+    ProbeEngine& operator=(const ProbeEngine&) = delete;
+
+    void start(const std::vector<ProbeTarget>& targets, int intervalMs, int timeoutMs);
+    void stop();
+    bool isRunning() const { return worker.joinable(); }
+
+    // Copies the latest per-target results, in the order the targets were given.
+    void copyStats(std::vector<ProbeStats>& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // One getaddrinfo on a thread of its own, so a dead DNS server can't hold up the reactor.
+    // Shared with that thread, which may outlive the engine; it stores the answer, sets done and
+    // signals doneFd.
+    struct Lookup {
+        std::string host;
+        std::string port;
+        int doneFd = -1;
+        std::atomic<bool> done{false};
+        sockaddr_storage address;
+        socklen_t addressLength = 0; // 0 when resolution failed
+
+        ~Lookup();
+    };
+
+    struct Target {
+        ProbeTarget spec;
+        sockaddr_storage address;
+        socklen_t addressLength = 0;
+        std::shared_ptr<Lookup> lookup; // in flight
+        Clock::time_point nextResolve;  // a minute after a success, backing off after failures
+        int resolveFailures = 0;
+        std::string request;
+        double connectSamples[kWindow] = {};
+        double ttfbSamples[kWindow] = {};
+        int connectCount = 0;
+        int ttfbCount = 0;
+        int nextConnect = 0;
+        int nextTtfb = 0;
+    };
+
+    std::vector<Target> targets;
+    std::vector<int> sockets; // the probe in flight per target, closed by stop() if a task is dropped
+    std::chrono::milliseconds interval;
+    std::chrono::milliseconds timeout;
+    Reactor reactor;
+    std::thread worker;
+
+    mutable std::mutex statsMutex;
+    std::vector<ProbeStats> stats;
+
+    Task<> probeLoop(size_t index);
+    Task<> probe(size_t index);
+    void finish(size_t index, bool ok, const char* error, double connectMs, double ttfbMs);
+    bool startLookup(Target& target);
+    void finishLookup(Target& target);
+};
+
+#endif
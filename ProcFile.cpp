@@ -0,0 +1,121 @@
+#include "ProcFile.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+ProcFile::ProcFile(const std::string& path) {
+    open(path);
+}
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+ProcFile::ProcFile(ProcFile&& other) noexcept
+    : fd(other.fd), buffer(std::move(other.buffer)), length(other.length) {
+    other.fd = -1;
+    other.length = 0;
+}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd = other.fd;
+        buffer = std::move(other.buffer);
+        length = other.length;
+        other.fd = -1;
+        other.length = 0;
+    }
+    return *this;
+}
+
+bool ProcFile::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (buffer.empty()) {
+        buffer.resize(4096 + kPadding);
+    }
+    return fd >= 0;
+}
+
+void ProcFile::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    length = 0;
+}
+
+bool ProcFile::read() {
+    // procfs regenerates the whole file on every read from offset 0, so one pread loop gives a consistent snapshot.
+    length = 0;
+    if (fd < 0) {
+        return false;
+    }
+    while (true) {
+        if (buffer.size() - length <= kPadding) {
+            buffer.resize(buffer.size() * 2);
+        }
+        ssize_t n = pread(fd, buffer.data() + length, buffer.size() - length - kPadding, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            length = 0;
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        length += n;
+    }
+    memset(buffer.data() + length, 0, kPadding);
+    return true;
+}
+
+void ProcFile::assign(const char* data, size_t size) {
+    if (buffer.size() < size + kPadding) {
+        buffer.resize(size + kPadding);
+    }
+    memcpy(buffer.data(), data, size);
+    memset(buffer.data() + size, 0, kPadding);
+    length = size;
+}
+
+size_t parseKeyTable(std::string_view text, const KeyField* fields, size_t count, int skipTokens) {
+    size_t found = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end && found < count) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+
+        const char* key = p;
+        for (int i = 0; i <= skipTokens; ++i) {
+            while (key < lineEnd && (*key == ' ' || *key == '\t')) ++key;
+            if (i == skipTokens) break;
+            while (key < lineEnd && *key != ' ' && *key != '\t') ++key;
+        }
+        const char* keyEnd = key;
+        while (keyEnd < lineEnd && *keyEnd != ':' && *keyEnd != ' ' && *keyEnd != '\t') ++keyEnd;
+        std::string_view name(key, keyEnd - key);
+
+        for (size_t i = 0; i < count; ++i) {
+            if (name == fields[i].key) {
+                const char* digits = keyEnd;
+                while (digits < lineEnd && (*digits == ':' || *digits == ' ' || *digits == '\t')) ++digits;
+                long long value = 0;
+                bool negative = digits < lineEnd && *digits == '-';
+                if (negative) ++digits;
+                while (digits < lineEnd && *digits >= '0' && *digits <= '9') {
+                    value = value * 10 + (*digits - '0');
+                    ++digits;
+                }
+                *fields[i].value = negative ? -value : value;
+                ++found;
+                break;
+            }
+        }
+        p = lineEnd + 1;
+    }
+    return found;
+}
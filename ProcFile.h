@@ -0,0 +1,55 @@
+#ifndef PROC_FILE_H
+#define PROC_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ProcFile {
+public:
+    // Keeps a /proc or /sys file open and re-reads it with pread into a buffer that is reused every tick.
+    // The buffer always has some zero padding after the data so scanners can over-read a little.
+    static constexpr size_t kPadding = 64;
+
+    ProcFile() = default;
+    explicit ProcFile(const std::string& path);
+    ~ProcFile();
+
+    ProcFile(ProcFile&& other) noexcept;
+    ProcFile& operator=(ProcFile&& other) noexcept;
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    int getFd() const { return fd; }
+
+    bool read();
+
+    const char* data() const { return buffer.data(); }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(buffer.data(), length); }
+
+private:
+    friend class ProcFileBatch;
+
+    int fd = -1;
+    std::vector<char> buffer;
+    size_t length = 0;
+
+    // For ProcFileBatch, which reads into buffers of its own.
+    void assign(const char* data, size_t size);
+};
+
+struct KeyField {
+    const char* key;   // without the trailing ':'
+    long long* value;
+};
+
+// Fills fields from "Key: value" or "Key value" lines, like /proc/meminfo or numastat.
+// skipTokens drops leading tokens first, e.g. 2 for the "Node 0" prefix in per-node meminfo.
+// Returns how many fields were found.
+size_t parseKeyTable(std::string_view text, const KeyField* fields, size_t count, int skipTokens = 0);
+
+#endif
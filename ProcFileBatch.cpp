@@ -0,0 +1,301 @@
+#include "ProcFileBatch.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define STATSBY_HAVE_IO_URING 1
+#endif
+
+namespace {
+
+std::atomic<bool> uringAllowed{false}; // io_uring_reads, off by default
+std::atomic<long long> filesRead{0};
+std::atomic<long long> syscalls{0};
+std::atomic<int> rings{0};
+
+} // namespace
+
+#ifdef STATSBY_HAVE_IO_URING
+
+// No liburing: the three syscalls and the mmap'd rings are all this needs.
+struct ProcFileBatch::Ring {
+    int fd = -1;
+    unsigned entries = 0;
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    bool fixedFiles = false;   // files registered, sqe.fd is an index into them
+    bool fixedBuffers = false; // the arena registered, reads are READ_FIXED
+    const char* registeredArena = nullptr;
+    size_t registeredSize = 0;
+    bool counted = false;
+
+    ~Ring() {
+        if (counted) rings--;
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+        if (fd >= 0) close(fd);
+    }
+
+    bool setup(unsigned count) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, count, &params));
+        if (fd < 0) {
+            return false;
+        }
+        entries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = single ? sqRing
+                        : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        counted = true;
+        rings++;
+        return true;
+    }
+
+    int enter(unsigned submit, unsigned complete) {
+        return static_cast<int>(
+            syscall(__NR_io_uring_enter, fd, submit, complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+    }
+
+    // Registration can be refused (RLIMIT_MEMLOCK for the buffers, a restricted ring) while plain
+    // submissions still work, so each part falls back on its own.
+    void registerFiles(const std::vector<int>& fds) {
+        if (fixedFiles) {
+            syscall(__NR_io_uring_register, fd, IORING_UNREGISTER_FILES, nullptr, 0);
+            syscalls++;
+        }
+        fixedFiles = syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES, fds.data(), fds.size()) == 0;
+        syscalls++;
+    }
+
+    void registerBuffer(char* data, size_t size) {
+        if (fixedBuffers && data == registeredArena && size == registeredSize) {
+            return;
+        }
+        if (fixedBuffers) {
+            syscall(__NR_io_uring_register, fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+            syscalls++;
+        }
+        iovec buffer = {data, size};
+        fixedBuffers = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &buffer, 1) == 0;
+        syscalls++;
+        registeredArena = fixedBuffers ? data : nullptr;
+        registeredSize = fixedBuffers ? size : 0;
+    }
+};
+
+#else
+
+struct ProcFileBatch::Ring {};
+
+#endif
+
+ProcFileBatch::ProcFileBatch() : dirty(true), setupFailed(false) {}
+
+ProcFileBatch::~ProcFileBatch() = default;
+
+void ProcFileBatch::add(ProcFile& file) {
+    files.push_back(&file);
+    dirty = true;
+}
+
+void ProcFileBatch::clear() {
+    files.clear();
+    dirty = true;
+}
+
+void ProcFileBatch::setUringAllowed(bool allowed) {
+    uringAllowed = allowed;
+}
+
+bool ProcFileBatch::isUringAllowed() {
+    return uringAllowed;
+}
+
+int ProcFileBatch::getUringCount() {
+    return rings;
+}
+
+long long ProcFileBatch::getFilesRead() {
+    return filesRead;
+}
+
+long long ProcFileBatch::getSyscalls() {
+    return syscalls;
+}
+
+void ProcFileBatch::read() {
+    if (uringAllowed && !setupFailed && prepare()) {
+        readUring();
+    } else {
+        readPread();
+    }
+}
+
+void ProcFileBatch::readPread() {
+    long long opened = 0;
+    for (ProcFile* file : files) {
+        file->read();
+        opened += file->isOpen();
+    }
+    // read() stops on a zero-length pread, so small files take two.
+    filesRead += opened;
+    syscalls += opened * 2;
+}
+
+#ifdef STATSBY_HAVE_IO_URING
+
+bool ProcFileBatch::prepare() {
+    if (!dirty) {
+        return ring != nullptr;
+    }
+    openFiles.clear();
+    std::vector<int> fds;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (files[i]->isOpen()) {
+            openFiles.push_back(i);
+            fds.push_back(files[i]->getFd());
+        }
+    }
+    if (openFiles.empty()) {
+        return false;
+    }
+    if (ring && ring->entries < openFiles.size()) {
+        ring.reset();
+    }
+    if (!ring) {
+        ring = std::make_unique<Ring>();
+        if (!ring->setup(static_cast<unsigned>(openFiles.size()))) {
+            ring.reset();
+            setupFailed = true;
+            return false;
+        }
+    }
+    ring->registerFiles(fds);
+    if (arena.size() < openFiles.size() * kSlotSize) {
+        arena.resize(openFiles.size() * kSlotSize);
+    }
+    ring->registerBuffer(arena.data(), arena.size());
+    dirty = false;
+    return true;
+}
+
+void ProcFileBatch::readUring() {
+    Ring& r = *ring;
+    unsigned count = static_cast<unsigned>(openFiles.size());
+    unsigned tail = *r.sqTail;
+    for (unsigned slot = 0; slot < count; ++slot) {
+        unsigned index = tail & *r.sqMask;
+        io_uring_sqe& sqe = r.sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = r.fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.flags = r.fixedFiles ? IOSQE_FIXED_FILE : 0;
+        sqe.fd = r.fixedFiles ? static_cast<int>(slot) : files[openFiles[slot]]->getFd();
+        sqe.addr = reinterpret_cast<uintptr_t>(arena.data() + slot * kSlotSize);
+        sqe.len = kSlotSize;
+        sqe.off = 0;
+        sqe.buf_index = 0;
+        sqe.user_data = slot;
+        r.sqArray[index] = index;
+        ++tail;
+    }
+    __atomic_store_n(r.sqTail, tail, __ATOMIC_RELEASE);
+
+    unsigned toSubmit = count;
+    unsigned done = 0;
+    while (done < count) {
+        int submitted = r.enter(toSubmit, count - done);
+        syscalls++;
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            // Whatever is still in flight dies with the ring; the arena outlives it.
+            ring.reset();
+            setupFailed = true;
+            readPread();
+            return;
+        }
+        toSubmit -= std::min<unsigned>(toSubmit, submitted);
+
+        unsigned head = *r.cqHead;
+        unsigned cqTail = __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != cqTail; ++head, ++done) {
+            const io_uring_cqe& cqe = r.cqes[head & *r.cqMask];
+            unsigned slot = static_cast<unsigned>(cqe.user_data);
+            ProcFile& file = *files[openFiles[slot]];
+            if (cqe.res < 0) {
+                file.length = 0;
+            } else if (static_cast<size_t>(cqe.res) >= kSlotSize) {
+                file.read(); // might be longer than one slot
+                syscalls += 2;
+            } else {
+                file.assign(arena.data() + slot * kSlotSize, cqe.res);
+            }
+        }
+        __atomic_store_n(r.cqHead, head, __ATOMIC_RELEASE);
+    }
+    for (ProcFile* file : files) {
+        if (!file->isOpen()) file->length = 0;
+    }
+    filesRead += count;
+}
+
+#else
+
+bool ProcFileBatch::prepare() {
+    return false;
+}
+
+void ProcFileBatch::readUring() {}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PROC_FILE_BATCH_H
+#define PROC_FILE_BATCH_H
+
+#include "ProcFile.h"
+#include <memory>
+#include <vector>
+
+class ProcFileBatch {
+public:
+    // Reads a fixed set of small ProcFiles together. With io_uring, one tick's reads go in as a
+    // single submission of fixed-buffer reads on registered files and are reaped by the same
+    // io_uring_enter. Without it (old kernel, kernel.io_uring_disabled, a seccomp filter) every
+    // file is pread as usual. Meant for sysfs attributes and other files that come back whole from
+    // one read; anything that fills its kSlotSize slot is re-read with ProcFile::read().
+    static constexpr size_t kSlotSize = 4096;
+
+    ProcFileBatch();
+    ~ProcFileBatch();
+    ProcFileBatch(const ProcFileBatch&) = delete;
+    ProcFileBatch& operator=(const ProcFileBatch&) = delete;
+
+    // The ring holds on to the files as they were when first read, so clear() and add them again
+    // whenever one is reopened or moved.
+    void add(ProcFile& file);
+    void clear();
+    size_t size() const { return files.size(); }
+
+    // Leaves every file as its own read() would have; closed or failed ones end up empty.
+    void read();
+    bool isUsingUring() const { return ring != nullptr; }
+
+    // Process-wide: the config switch, and running totals for the debug window.
+    static void setUringAllowed(bool allowed);
+    static bool isUringAllowed();
+    static int getUringCount(); // batches that currently have a ring
+    static long long getFilesRead();
+    static long long getSyscalls();
+
+private:
+    struct Ring;
+
+    std::vector<ProcFile*> files;
+    std::vector<size_t> openFiles; // indices into files, in submission order
+    std::vector<char> arena;       // one kSlotSize slot per open file
+    std::unique_ptr<Ring> ring;
+    bool dirty;
+    bool setupFailed;
+
+    bool prepare();
+    void readUring();
+    void readPread();
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "ProcTableScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PROC_SCANNER_X86 1
+#endif
+
+namespace {
+
+inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline bool isSpace(char c) {
+    return static_cast<unsigned char>(c) <= ' ';
+}
+
+#ifdef PROC_SCANNER_X86
+// Bit i is set when block[i] is whitespace (any byte <= ' ').
+uint64_t whitespaceMaskSse2(const char* block) {
+    const __m128i space = _mm_set1_epi8(' ');
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        __m128i ws = _mm_cmpeq_epi8(_mm_max_epu8(v, space), space);
+        mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ws))) << (i * 16);
+    }
+    return mask;
+}
+
+__attribute__((target("avx2"))) uint64_t whitespaceMaskAvx2(const char* block) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    uint32_t loMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(lo, space), space));
+    uint32_t hiMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(hi, space), space));
+    return static_cast<uint64_t>(loMask) | (static_cast<uint64_t>(hiMask) << 32);
+}
+#endif
+
+// Bitmask of token starts in one 64-byte block. Bytes past end count as whitespace.
+inline uint64_t tokenStarts(uint64_t ws, size_t available, uint64_t& carry) {
+    if (available < 64) {
+        ws |= ~0ULL << available;
+    }
+    uint64_t starts = ~ws & ((ws << 1) | carry);
+    carry = ws >> 63;
+    return starts;
+}
+
+} // namespace
+
+ProcTableScanner::ProcTableScanner() : isa(Isa::Scalar), whitespaceMask(nullptr) {
+#ifdef PROC_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        isa = Isa::Avx2;
+        whitespaceMask = whitespaceMaskAvx2;
+    } else {
+        isa = Isa::Sse2;
+        whitespaceMask = whitespaceMaskSse2;
+    }
+#endif
+}
+
+ProcTableScanner::ProcTableScanner(Isa forcedIsa) : ProcTableScanner() {
+    // Only ever steps down from what the CPU supports, so forcing Avx2 on an old box is harmless.
+    if (forcedIsa == Isa::Scalar) {
+        isa = Isa::Scalar;
+        whitespaceMask = nullptr;
+    }
+#ifdef PROC_SCANNER_X86
+    else if (forcedIsa == Isa::Sse2) {
+        isa = Isa::Sse2;
+        whitespaceMask = whitespaceMaskSse2;
+    }
+#endif
+}
+
+const char* ProcTableScanner::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "AVX2";
+        case Isa::Sse2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+size_t ProcTableScanner::parseRow(const char* begin, const char* end, unsigned long long* out, size_t maxValues,
+                                  const char** rest) const {
+    size_t count = 0;
+    if (maxValues == 0) {
+        *rest = begin;
+        return 0;
+    }
+
+    if (!whitespaceMask) {
+        // Scalar baseline: walk byte by byte.
+        const char* p = begin;
+        while (p < end) {
+            while (p < end && isSpace(*p)) ++p;
+            if (p == end) break;
+            const char* token = p;
+            unsigned long long value = 0;
+            while (p < end && isDigit(*p)) {
+                value = value * 10 + (*p - '0');
+                ++p;
+            }
+            if (p == token || (p < end && !isSpace(*p))) {
+                *rest = token;
+                return count;
+            }
+            out[count++] = value;
+            if (count == maxValues) {
+                *rest = p;
+                return count;
+            }
+        }
+        *rest = end;
+        return count;
+    }
+
+    // Vector path: classify 64 bytes at once, then jump straight to each token start.
+    uint64_t carry = 1;
+    for (const char* block = begin; block < end; block += 64) {
+        uint64_t starts = tokenStarts(whitespaceMask(block), end - block, carry);
+        while (starts) {
+            const char* token = block + __builtin_ctzll(starts);
+            starts &= starts - 1;
+            const char* p = token;
+            unsigned long long value = 0;
+            while (isDigit(*p)) {
+                value = value * 10 + (*p - '0');
+                ++p;
+            }
+            if (p == token || (p < end && !isSpace(*p))) {
+                *rest = token;
+                return count;
+            }
+            out[count++] = value;
+            if (count == maxValues) {
+                *rest = p;
+                return count;
+            }
+        }
+    }
+    *rest = end;
+    return count;
+}
+
+size_t ProcTableScanner::countTokens(const char* begin, const char* end) const {
+    size_t count = 0;
+    if (!whitespaceMask) {
+        bool inToken = false;
+        for (const char* p = begin; p < end; ++p) {
+            bool space = isSpace(*p);
+            if (!space && !inToken) ++count;
+            inToken = !space;
+        }
+        return count;
+    }
+
+    uint64_t carry = 1;
+    for (const char* block = begin; block < end; block += 64) {
+        count += __builtin_popcountll(tokenStarts(whitespaceMask(block), end - block, carry));
+    }
+    return count;
+}
@@ -0,0 +1,34 @@
+#ifndef PROC_TABLE_SCANNER_H
+#define PROC_TABLE_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+
+class ProcTableScanner {
+public:
+    // Tokenizes the wide whitespace-separated rows of /proc/interrupts and friends.
+    // Whitespace is found 64 bytes at a time with SSE2 or AVX2, with a plain byte loop as fallback.
+    enum class Isa { Scalar, Sse2, Avx2 };
+
+    ProcTableScanner();
+    explicit ProcTableScanner(Isa forcedIsa);
+
+    Isa getIsa() const { return isa; }
+    static const char* isaName(Isa isa);
+
+    // Parses up to maxValues unsigned integer columns from [begin, end). Stops at the first
+    // token that isn't a number and points rest at it (or at end). Input must be readable up
+    // to 64 bytes past end, which ProcFile's padding guarantees.
+    size_t parseRow(const char* begin, const char* end, unsigned long long* out, size_t maxValues,
+                    const char** rest) const;
+
+    // Counts whitespace-separated tokens in [begin, end). Used for the CPU header line.
+    size_t countTokens(const char* begin, const char* end) const;
+
+private:
+    using MaskFn = uint64_t (*)(const char* block);
+    Isa isa;
+    MaskFn whitespaceMask;
+};
+
+#endif
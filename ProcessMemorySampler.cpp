@@ -0,0 +1,124 @@
+#include "ProcessMemorySampler.h"
+#include <algorithm>
+
+ProcessMemorySampler::ProcessMemorySampler(const std::string& procRoot, double budgetUs) : procRoot(procRoot) {
+    stats.budgetUs = budgetUs;
+    lastSample = Clock::now();
+}
+
+void ProcessMemorySampler::setPids(const std::vector<int>& pids) {
+    bool same = pids.size() == processes.size();
+    for (size_t i = 0; same && i < pids.size(); ++i) {
+        same = pids[i] == processes[i].pid;
+    }
+    if (same) {
+        return;
+    }
+
+    std::vector<Process> kept;
+    std::vector<ProcessMemoryStats> keptStats;
+    for (int pid : pids) {
+        auto existing = std::find_if(processes.begin(), processes.end(), [&](const Process& p) { return p.pid == pid; });
+        if (existing != processes.end()) {
+            keptStats.push_back(stats.processes[existing - processes.begin()]);
+            kept.push_back(std::move(*existing));
+            continue;
+        }
+        Process process;
+        process.pid = pid;
+        std::string pidPath = procRoot + "/" + std::to_string(pid);
+        process.smapsRollup.open(pidPath + "/smaps_rollup");
+        process.io.open(pidPath + "/io");
+        process.nextRollup = Clock::now();
+        kept.push_back(std::move(process));
+        keptStats.emplace_back();
+        keptStats.back().pid = pid;
+    }
+    processes = std::move(kept);
+    stats.processes = std::move(keptStats);
+}
+
+const ProcessMemoryStats* ProcessMemorySampler::find(int pid) const {
+    for (const ProcessMemoryStats& process : stats.processes) {
+        if (process.pid == pid) return &process;
+    }
+    return nullptr;
+}
+
+void ProcessMemorySampler::readRollup(Process& process, ProcessMemoryStats& out, Clock::time_point now) {
+    auto started = Clock::now();
+    long long rss = 0, pss = 0, privateClean = 0, privateDirty = 0, swap = 0;
+    KeyField fields[] = {
+        {"Rss", &rss}, {"Pss", &pss}, {"Private_Clean", &privateClean}, {"Private_Dirty", &privateDirty},
+        {"Swap", &swap},
+    };
+    bool ok = process.smapsRollup.read() && parseKeyTable(process.smapsRollup.view(), fields, 5) > 0;
+    double costUs = std::chrono::duration<double, std::micro>(Clock::now() - started).count();
+    stats.tickCostUs += costUs;
+
+    out.rollupCostUs = costUs;
+    if (ok) {
+        out.valid = true;
+        out.rssKb = rss;
+        out.pssKb = pss;
+        out.ussKb = privateClean + privateDirty;
+        out.swapKb = swap;
+        process.lastRollup = now;
+    }
+    // Big address spaces cost more to walk, so they get sampled less often.
+    int interval = static_cast<int>(costUs * kCostRatio / 1000.0);
+    out.rollupIntervalMs = std::min(kMaxIntervalMs, std::max(kMinIntervalMs, interval));
+    process.nextRollup = now + std::chrono::milliseconds(out.rollupIntervalMs);
+}
+
+void ProcessMemorySampler::update() {
+    auto now = Clock::now();
+    std::chrono::duration<double> elapsedSeconds = now - lastSample;
+    double elapsed = elapsedSeconds.count();
+    lastSample = now;
+
+    // /proc/[pid]/io is just a few counters, so it is read every update.
+    for (size_t i = 0; i < processes.size(); ++i) {
+        Process& process = processes[i];
+        ProcessMemoryStats& out = stats.processes[i];
+        long long readBytes = 0, writeBytes = 0;
+        KeyField fields[] = {{"read_bytes", &readBytes}, {"write_bytes", &writeBytes}};
+        if (!process.io.read() || parseKeyTable(process.io.view(), fields, 2) != 2) {
+            process.hasPrevIo = false;
+            continue;
+        }
+        if (process.hasPrevIo && elapsed > 0) {
+            out.readBytesPerSec = readBytes >= process.prevReadBytes ? (readBytes - process.prevReadBytes) / elapsed : 0.0;
+            out.writeBytesPerSec =
+                writeBytes >= process.prevWriteBytes ? (writeBytes - process.prevWriteBytes) / elapsed : 0.0;
+        }
+        process.prevReadBytes = readBytes;
+        process.prevWriteBytes = writeBytes;
+        process.hasPrevIo = true;
+    }
+
+    // Most overdue first, until the budget is spent. The first read always goes ahead so a single
+    // process that costs more than the whole budget still gets sampled.
+    due.clear();
+    for (size_t i = 0; i < processes.size(); ++i) {
+        if (processes[i].nextRollup <= now) due.push_back(i);
+    }
+    std::sort(due.begin(), due.end(),
+              [&](size_t a, size_t b) { return processes[a].nextRollup < processes[b].nextRollup; });
+    stats.tickCostUs = 0.0;
+    stats.deferred = 0;
+    for (size_t index : due) {
+        if (stats.tickCostUs > 0.0 && stats.tickCostUs >= stats.budgetUs) {
+            stats.deferred++;
+            continue;
+        }
+        readRollup(processes[index], stats.processes[index], now);
+    }
+
+    for (size_t i = 0; i < processes.size(); ++i) {
+        if (stats.processes[i].valid) {
+            std::chrono::duration<double> age = now - processes[i].lastRollup;
+            stats.processes[i].rollupAgeSec = age.count();
+        }
+    }
+}
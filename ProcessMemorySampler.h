@@ -0,0 +1,67 @@
+#ifndef PROCESS_MEMORY_SAMPLER_H
+#define PROCESS_MEMORY_SAMPLER_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct ProcessMemoryStats {
+    int pid = 0;
+    bool valid = false;            // smaps_rollup has been read at least once
+    long long rssKb = 0;
+    long long pssKb = 0;           // shared pages split between the processes mapping them
+    long long ussKb = 0;           // Private_Clean + Private_Dirty, freed if the process exits
+    long long swapKb = 0;
+    double readBytesPerSec = 0.0;  // storage I/O from /proc/[pid]/io, refreshed every update
+    double writeBytesPerSec = 0.0;
+    double rollupCostUs = 0.0;     // last smaps_rollup read
+    int rollupIntervalMs = 0;      // current adaptive interval
+    double rollupAgeSec = 0.0;     // how old the smaps_rollup numbers are
+};
+
+struct ProcessMemorySamplerStats {
+    std::vector<ProcessMemoryStats> processes;
+    double tickCostUs = 0.0;       // smaps_rollup time spent in the last update
+    double budgetUs = 0.0;
+    int deferred = 0;              // due reads pushed to a later update by the budget
+};
+
+class ProcessMemorySampler {
+public:
+    // smaps_rollup walks every VMA under the mmap lock, so it is read on a per-process schedule
+    // proportional to its own cost, and an update never spends more than budgetUs on it.
+    explicit ProcessMemorySampler(const std::string& procRoot = "/proc", double budgetUs = 2000.0);
+
+    void setPids(const std::vector<int>& pids);
+    void update();
+    const ProcessMemorySamplerStats& getStats() const { return stats; }
+    const ProcessMemoryStats* find(int pid) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kCostRatio = 1000;       // aim for at most 0.1% of wall time per process
+    static constexpr int kMinIntervalMs = 1000;
+    static constexpr int kMaxIntervalMs = 30000;
+
+    struct Process {
+        int pid = 0;
+        ProcFile smapsRollup;
+        ProcFile io;
+        long long prevReadBytes = 0;
+        long long prevWriteBytes = 0;
+        bool hasPrevIo = false;
+        Clock::time_point lastRollup;
+        Clock::time_point nextRollup;
+    };
+
+    std::string procRoot;
+    std::vector<Process> processes; // same order as stats.processes
+    std::vector<size_t> due;        // scratch for update(), kept for its capacity
+    Clock::time_point lastSample;
+    ProcessMemorySamplerStats stats;
+
+    void readRollup(Process& process, ProcessMemoryStats& out, Clock::time_point now);
+};
+
+#endif
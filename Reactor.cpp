@@ -0,0 +1,168 @@
+#include "Reactor.h"
+#include "Subprocess.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+bool Reactor::Wait::await_suspend(std::coroutine_handle<> waiting) {
+    handle = waiting;
+    if (fd >= 0) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.ptr = this;
+        if (epoll_ctl(reactor.epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            // EPERM is epoll refusing a regular file, which never blocks anyway.
+            ready = errno == EPERM;
+            return false;
+        }
+    }
+    auto& waits = reactor.waits;
+    waits.insert(std::upper_bound(waits.begin(), waits.end(), deadline,
+                                  [](Clock::time_point when, const Wait* other) { return when < other->deadline; }),
+                 this);
+    return true;
+}
+
+Reactor::Reactor() : stopping(false) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        if (epollFd >= 0) close(epollFd);
+        epollFd = -1;
+        return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr; // Waits use their own address
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+Reactor::~Reactor() {
+    clear();
+    if (epollFd >= 0) close(epollFd);
+    if (wakeFd >= 0) close(wakeFd);
+}
+
+Reactor::Wait Reactor::readable(int fd, Clock::time_point deadline) {
+    return Wait(*this, fd, EPOLLIN, deadline);
+}
+
+Reactor::Wait Reactor::writable(int fd, Clock::time_point deadline) {
+    return Wait(*this, fd, EPOLLOUT, deadline);
+}
+
+void Reactor::spawn(Task<> task) {
+    pending.push_back(task.release());
+}
+
+void Reactor::clear() {
+    // The Waits live in the frames that are about to go, so unhook them first.
+    for (Wait* wait : waits) {
+        if (wait->fd >= 0) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, wait->fd, nullptr);
+        }
+    }
+    waits.clear();
+    // Destroying a top-level frame also destroys the Tasks it was awaiting.
+    for (std::coroutine_handle<> task : tasks) task.destroy();
+    for (std::coroutine_handle<> task : pending) task.destroy();
+    tasks.clear();
+    pending.clear();
+    stopping = false;
+}
+
+void Reactor::finish(Wait& wait, bool ready) {
+    if (wait.fd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, wait.fd, nullptr);
+    }
+    waits.erase(std::find(waits.begin(), waits.end(), &wait));
+    wait.ready = ready;
+}
+
+void Reactor::runFor(int timeoutMs) {
+    // Tasks spawned by a task that just started are picked up by the same loop.
+    while (!pending.empty()) {
+        std::vector<std::coroutine_handle<>> starting;
+        starting.swap(pending);
+        for (std::coroutine_handle<> task : starting) {
+            tasks.push_back(task);
+            task.resume();
+        }
+    }
+
+    int waitMs = timeoutMs;
+    if (!waits.empty() && waits.front()->deadline != Clock::time_point::max()) {
+        auto until = std::chrono::ceil<std::chrono::milliseconds>(waits.front()->deadline - Clock::now());
+        int untilMs = static_cast<int>(std::max<long long>(0, until.count()));
+        waitMs = waitMs < 0 ? untilMs : std::min(waitMs, untilMs);
+    }
+    epoll_event events[64];
+    int count = epoll_wait(epollFd, events, 64, waitMs);
+    for (int i = 0; i < count; ++i) {
+        Wait* wait = static_cast<Wait*>(events[i].data.ptr);
+        if (!wait) {
+            uint64_t drained;
+            ssize_t ignored = read(wakeFd, &drained, sizeof(drained));
+            (void)ignored;
+            continue;
+        }
+        finish(*wait, true);
+        wait->handle.resume();
+    }
+
+    auto now = Clock::now();
+    while (!waits.empty() && waits.front()->deadline <= now) {
+        Wait* wait = waits.front();
+        finish(*wait, false);
+        wait->handle.resume();
+    }
+
+    tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                               [](std::coroutine_handle<> task) {
+                                   if (!task.done()) return false;
+                                   task.destroy();
+                                   return true;
+                               }),
+                tasks.end());
+}
+
+void Reactor::run() {
+    while (isAvailable() && !stopping) {
+        runFor(-1);
+    }
+}
+
+void Reactor::stop() {
+    stopping = true;
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+Task<bool> Reactor::complete(Subprocess& process, Clock::time_point deadline) {
+    while (process.outputFd() >= 0) {
+        bool ready = co_await readable(process.outputFd(), deadline);
+        if (!ready) {
+            process.stop();
+            co_return false;
+        }
+        process.readAvailable();
+    }
+    // stdout can close before the exit; without a pidfd there is nothing to wait on, so check
+    // back every few ms.
+    while (!process.hasExited()) {
+        if (Clock::now() >= deadline) {
+            process.stop();
+            co_return false;
+        }
+        if (process.getPidFd() >= 0) {
+            co_await readable(process.getPidFd(), deadline);
+        } else {
+            co_await sleepUntil(std::min(deadline, Clock::now() + std::chrono::milliseconds(10)));
+        }
+    }
+    process.stop(); // reaps it, and kills anything it left running in its process group
+    co_return true;
+}
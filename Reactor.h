@@ -0,0 +1,87 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "Task.h"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <vector>
+
+class Subprocess;
+
+class Reactor {
+public:
+    // Single-threaded epoll loop for coroutine collectors: tasks co_await fd readiness, timers
+    // and subprocess exit, and any number of them share whichever thread calls run()/runFor().
+    // Only stop() may be called from another thread.
+    using Clock = std::chrono::steady_clock;
+
+    class Wait {
+    public:
+        // Sleeps with no fd are ready at once when the time has already passed.
+        bool await_ready() const noexcept { return fd < 0 && deadline <= Clock::now(); }
+        bool await_suspend(std::coroutine_handle<> handle);
+        // True when the fd became ready, false when the deadline came first (always for sleeps).
+        bool await_resume() const noexcept { return ready; }
+
+    private:
+        friend class Reactor;
+        Wait(Reactor& reactor, int fd, uint32_t events, Clock::time_point deadline)
+            : reactor(reactor), fd(fd), events(events), deadline(deadline) {}
+
+        Reactor& reactor;
+        int fd;
+        uint32_t events;
+        Clock::time_point deadline;
+        std::coroutine_handle<> handle;
+        bool ready = false;
+    };
+
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    bool isAvailable() const { return epollFd >= 0; }
+
+    // Takes the task over; it starts on the next dispatch, on the reactor's thread.
+    void spawn(Task<> task);
+    // Destroys every task wherever it is suspended. Not from inside a task, and not while
+    // another thread is in run().
+    void clear();
+    size_t getTaskCount() const { return pending.size() + tasks.size(); }
+
+    // Dispatches until stop().
+    void run();
+    // Dispatches what is ready, waiting at most timeoutMs for something to be; 0 never blocks.
+    void runFor(int timeoutMs);
+    void stop();
+
+    // One waiter per fd at a time. Fds epoll can't watch (regular files) count as ready.
+    // Keep co_await out of if/while conditions and bind the result first: GCC 12 miscompiles
+    // the condition form into a coroutine that never starts.
+    Wait readable(int fd, Clock::time_point deadline = Clock::time_point::max());
+    Wait writable(int fd, Clock::time_point deadline = Clock::time_point::max());
+    Wait sleepUntil(Clock::time_point when) { return Wait(*this, -1, 0, when); }
+    Wait sleepFor(Clock::duration duration) { return sleepUntil(Clock::now() + duration); }
+
+    // Reads the started process's stdout until EOF, waits for it to exit and reaps it. At the
+    // deadline it is killed instead and the result is false.
+    Task<bool> complete(Subprocess& process, Clock::time_point deadline);
+
+private:
+    int epollFd;
+    int wakeFd;
+    std::atomic<bool> stopping;
+    std::vector<std::coroutine_handle<>> pending; // spawned, not started yet
+    std::vector<std::coroutine_handle<>> tasks;
+    // Every suspended Wait by deadline; those without one sit at time_point::max(). A sorted
+    // vector rather than a map: there are only ever a handful, and it keeps its capacity, so
+    // awaiting doesn't allocate once the loop has warmed up.
+    std::vector<Wait*> waits;
+
+    void finish(Wait& wait, bool ready);
+};
+
+#endif
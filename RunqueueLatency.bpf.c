@@ -0,0 +1,95 @@
+// Kernel side of the run-queue latency collector. Built only with -DSTATSBY_ENABLE_BPF=ON.
+// Records when a task becomes runnable and, when it is switched in, adds the wait to a
+// log2(microseconds) histogram in a per-CPU array so each CPU gets its own histogram for free.
+#include "vmlinux.h"
+#include <bpf/bpf_core_read.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+
+#define MAX_SLOTS 26
+#define TASK_RUNNING 0
+
+struct {
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(max_entries, 10240);
+    __type(key, u32);
+    __type(value, u64);
+} start SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, MAX_SLOTS);
+    __type(key, u32);
+    __type(value, u64);
+} hists SEC(".maps");
+
+// Kernels before 5.14 call the field "state" instead of "__state".
+struct task_struct___pre_5_14 {
+    volatile long int state;
+} __attribute__((preserve_access_index));
+
+static __always_inline long task_state(struct task_struct *task) {
+    struct task_struct___pre_5_14 *old = (void *)task;
+    if (bpf_core_field_exists(old->state))
+        return BPF_CORE_READ(old, state);
+    return BPF_CORE_READ(task, __state);
+}
+
+static __always_inline u32 log2_slot(u64 v) {
+    u32 r = 0, shift;
+    shift = (v > 0xFFFFFFFF) << 5; v >>= shift; r |= shift;
+    shift = (v > 0xFFFF) << 4; v >>= shift; r |= shift;
+    shift = (v > 0xFF) << 3; v >>= shift; r |= shift;
+    shift = (v > 0xF) << 2; v >>= shift; r |= shift;
+    shift = (v > 0x3) << 1; v >>= shift; r |= shift;
+    r |= (v >> 1);
+    return r < MAX_SLOTS ? r : MAX_SLOTS - 1;
+}
+
+static __always_inline void mark_runnable(struct task_struct *task) {
+    u32 pid = BPF_CORE_READ(task, pid);
+    u64 ts;
+    if (pid == 0)
+        return;
+    ts = bpf_ktime_get_ns();
+    bpf_map_update_elem(&start, &pid, &ts, BPF_ANY);
+}
+
+SEC("tp_btf/sched_wakeup")
+int BPF_PROG(handle_sched_wakeup, struct task_struct *p) {
+    mark_runnable(p);
+    return 0;
+}
+
+SEC("tp_btf/sched_wakeup_new")
+int BPF_PROG(handle_sched_wakeup_new, struct task_struct *p) {
+    mark_runnable(p);
+    return 0;
+}
+
+SEC("tp_btf/sched_switch")
+int BPF_PROG(handle_sched_switch, bool preempt, struct task_struct *prev, struct task_struct *next) {
+    u32 pid;
+    u64 *tsp, delta;
+    u32 slot;
+    u64 *count;
+
+    // A preempted task goes straight back on the run queue.
+    if (task_state(prev) == TASK_RUNNING)
+        mark_runnable(prev);
+
+    pid = BPF_CORE_READ(next, pid);
+    tsp = bpf_map_lookup_elem(&start, &pid);
+    if (!tsp)
+        return 0;
+    delta = (bpf_ktime_get_ns() - *tsp) / 1000;
+    bpf_map_delete_elem(&start, &pid);
+
+    slot = log2_slot(delta);
+    count = bpf_map_lookup_elem(&hists, &slot);
+    if (count)
+        *count += 1;
+    return 0;
+}
+
+char LICENSE[] SEC("license") = "GPL";
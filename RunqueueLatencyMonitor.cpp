@@ -0,0 +1,133 @@
+#include "RunqueueLatencyMonitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef STATSBY_HAVE_BPF
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include "runqlat.skel.h"
+#endif
+
+RunqueueLatencyMonitor::RunqueueLatencyMonitor() : attempted(false), skeleton(nullptr) {}
+
+RunqueueLatencyMonitor::~RunqueueLatencyMonitor() {
+    detach();
+}
+
+void RunqueueLatencyMonitor::detach() {
+    if (!attempted) {
+        return;
+    }
+#ifdef STATSBY_HAVE_BPF
+    if (skeleton) {
+        runqlat__destroy(skeleton);
+        skeleton = nullptr;
+    }
+#endif
+    attempted = false;
+    stats = RunqueueLatencyStats();
+}
+
+double RunqueueLatencyMonitor::percentile(const uint64_t* slots, uint64_t count, double fraction) {
+    // Returns the upper edge of the bucket that holds the requested fraction, in microseconds.
+    if (count == 0) {
+        return 0.0;
+    }
+    uint64_t target = static_cast<uint64_t>(count * fraction);
+    uint64_t seen = 0;
+    for (int i = 0; i < RunqueueLatencyStats::kSlots; ++i) {
+        seen += slots[i];
+        if (seen > target) {
+            return static_cast<double>(1ULL << (i + 1));
+        }
+    }
+    return static_cast<double>(1ULL << RunqueueLatencyStats::kSlots);
+}
+
+void RunqueueLatencyMonitor::attach() {
+    attempted = true;
+#ifdef STATSBY_HAVE_BPF
+    skeleton = runqlat__open_and_load();
+    if (!skeleton) {
+        stats.status = std::string("BPF load failed: ") + strerror(errno) + " (needs root or CAP_BPF+CAP_PERFMON)";
+        return;
+    }
+    int err = runqlat__attach(skeleton);
+    if (err) {
+        stats.status = std::string("BPF attach failed: ") + strerror(-err);
+        runqlat__destroy(skeleton);
+        skeleton = nullptr;
+        return;
+    }
+    int possibleCpus = libbpf_num_possible_cpus();
+    if (possibleCpus <= 0) {
+        stats.status = "could not count possible CPUs";
+        runqlat__destroy(skeleton);
+        skeleton = nullptr;
+        return;
+    }
+    stats.cpuCount = possibleCpus;
+    stats.perCpu.assign(possibleCpus * RunqueueLatencyStats::kSlots, 0);
+    cumulative.assign(possibleCpus * RunqueueLatencyStats::kSlots, 0);
+    readBuffer.resize(possibleCpus);
+    stats.available = true;
+    stats.status.clear();
+    lastSample = std::chrono::steady_clock::now();
+#else
+    stats.status = "not built with STATSBY_ENABLE_BPF";
+#endif
+}
+
+void RunqueueLatencyMonitor::update() {
+    if (!attempted) {
+        attach();
+    }
+    if (!stats.available) {
+        return;
+    }
+#ifdef STATSBY_HAVE_BPF
+    const int slots = RunqueueLatencyStats::kSlots;
+    int mapFd = bpf_map__fd(skeleton->maps.hists);
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+
+    std::fill(std::begin(stats.total), std::end(stats.total), 0);
+    for (int slot = 0; slot < slots; ++slot) {
+        // A per-CPU array lookup hands back one value per possible CPU.
+        uint32_t key = slot;
+        if (bpf_map_lookup_elem(mapFd, &key, readBuffer.data()) != 0) {
+            continue;
+        }
+        for (int cpu = 0; cpu < stats.cpuCount; ++cpu) {
+            size_t i = cpu * slots + slot;
+            uint64_t value = readBuffer[cpu];
+            stats.perCpu[i] = value - cumulative[i];
+            cumulative[i] = value;
+            stats.total[slot] += stats.perCpu[i];
+        }
+    }
+
+    stats.samples = 0;
+    for (int slot = 0; slot < slots; ++slot) {
+        stats.samples += stats.total[slot];
+    }
+    stats.wakeupsPerSec = elapsed.count() > 0 ? stats.samples / elapsed.count() : 0.0;
+    stats.p50Us = percentile(stats.total, stats.samples, 0.50);
+    stats.p99Us = percentile(stats.total, stats.samples, 0.99);
+
+    stats.worstCpu = -1;
+    stats.worstCpuP99Us = 0.0;
+    for (int cpu = 0; cpu < stats.cpuCount; ++cpu) {
+        const uint64_t* row = stats.perCpu.data() + cpu * slots;
+        uint64_t count = 0;
+        for (int slot = 0; slot < slots; ++slot) count += row[slot];
+        double p99 = percentile(row, count, 0.99);
+        if (count > 0 && p99 > stats.worstCpuP99Us) {
+            stats.worstCpu = cpu;
+            stats.worstCpuP99Us = p99;
+        }
+    }
+#endif
+}
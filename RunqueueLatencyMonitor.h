@@ -0,0 +1,60 @@
+#ifndef RUNQUEUE_LATENCY_MONITOR_H
+#define RUNQUEUE_LATENCY_MONITOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct runqlat; // generated BPF skeleton, only defined when built with STATSBY_ENABLE_BPF
+
+struct RunqueueLatencyStats {
+    // Slot i counts wakeups that waited [2^i, 2^(i+1)) microseconds, slot 0 also holds < 1 us.
+    static constexpr int kSlots = 26;
+
+    bool available = false;
+    std::string status;
+
+    int cpuCount = 0;
+    std::vector<uint64_t> perCpu;   // cpuCount x kSlots, counts since the last tick
+    uint64_t total[kSlots] = {};    // summed over CPUs
+    uint64_t samples = 0;
+    double wakeupsPerSec = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    int worstCpu = -1;              // CPU with the highest p99 this tick
+    double worstCpuP99Us = 0.0;
+
+    uint64_t count(int cpu, int slot) const { return perCpu[cpu * kSlots + slot]; }
+};
+
+class RunqueueLatencyMonitor {
+public:
+    // Run-queue latency histograms from sched_wakeup/sched_switch tracepoints via libbpf.
+    // Without STATSBY_ENABLE_BPF this compiles to a stub that reports itself unavailable.
+    RunqueueLatencyMonitor();
+    ~RunqueueLatencyMonitor();
+    RunqueueLatencyMonitor(const RunqueueLatencyMonitor&) = delete;
+    RunqueueLatencyMonitor& operator=(const RunqueueLatencyMonitor&) = delete;
+
+    void update();
+    // Unhooks the programs from the scheduler tracepoints, which otherwise cost every context
+    // switch while the collector is off. The next update() attaches again. Only while update()
+    // isn't running.
+    void detach();
+    const RunqueueLatencyStats& getStats() const { return stats; }
+
+    static double percentile(const uint64_t* slots, uint64_t count, double fraction);
+
+private:
+    bool attempted;
+    runqlat* skeleton;
+    std::vector<uint64_t> cumulative;   // possible CPUs x kSlots, last raw read
+    std::vector<uint64_t> readBuffer;   // one value per possible CPU for a single slot
+    std::chrono::steady_clock::time_point lastSample;
+    RunqueueLatencyStats stats;
+
+    void attach();
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include "SpikeCaptureMonitor.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+
+namespace {
+
+bool isNumeric(const char* name) {
+    if (*name == '\0') return false;
+    for (const char* p = name; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+    }
+    return true;
+}
+
+std::string formatReason(const char* what, double value, double threshold) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "%s %.0f%% > %.0f%%", what, value, threshold);
+    return buffer;
+}
+
+} // namespace
+
+SpikeCaptureMonitor::SpikeCaptureMonitor(const std::string& procRoot, const std::string& cgroupRoot)
+    : procRoot(procRoot), cgroupRoot(cgroupRoot), cpuThreshold(90.0), memoryThreshold(10.0), ioThreshold(20.0),
+      memoryPressure(0.0), ioPressure(0.0), wasOver(false), triggerCount(0), capturing(false), next(0), count(0) {
+    memoryPressureFile.open(procRoot + "/pressure/memory");
+    ioPressureFile.open(procRoot + "/pressure/io");
+    ring.resize(8);
+    ticksPerSecond = sysconf(_SC_CLK_TCK);
+    pageKb = sysconf(_SC_PAGESIZE) / 1024;
+}
+
+void SpikeCaptureMonitor::setThresholds(double cpuPercent, double memoryPressure, double ioPressure) {
+    cpuThreshold = cpuPercent;
+    memoryThreshold = memoryPressure;
+    ioThreshold = ioPressure;
+}
+
+void SpikeCaptureMonitor::setHistorySize(int snapshots) {
+    size_t size = static_cast<size_t>(std::max(1, snapshots));
+    if (size == ring.size()) {
+        return;
+    }
+    // Keep the newest ones that still fit.
+    std::vector<SpikeSnapshot> resized(size);
+    size_t kept = std::min(count, size);
+    for (size_t i = 0; i < kept; ++i) {
+        resized[kept - 1 - i] = std::move(ring[(next + ring.size() - 1 - i) % ring.size()]);
+    }
+    ring = std::move(resized);
+    count = kept;
+    next = kept % size;
+}
+
+const SpikeSnapshot& SpikeCaptureMonitor::getCapture(size_t newest) const {
+    return ring[(next + ring.size() - 1 - newest) % ring.size()];
+}
+
+double SpikeCaptureMonitor::readPressure(ProcFile& file) {
+    // "some avg10=1.23 avg60=... total=..." on the first line.
+    if (!file.read()) {
+        return 0.0;
+    }
+    const char* avg10 = strstr(file.data(), "avg10=");
+    return avg10 ? strtod(avg10 + 6, nullptr) : 0.0;
+}
+
+void SpikeCaptureMonitor::update(const MetricSnapshot& metrics) {
+    double cpuUsage = metrics[MetricId::CpuUsage];
+    memoryPressure = readPressure(memoryPressureFile);
+    ioPressure = readPressure(ioPressureFile);
+
+    if (capturing) {
+        finish();
+        return;
+    }
+
+    std::string reason;
+    if (cpuThreshold > 0 && cpuUsage > cpuThreshold) {
+        reason = formatReason("CPU", cpuUsage, cpuThreshold);
+    } else if (memoryThreshold > 0 && memoryPressure > memoryThreshold) {
+        reason = formatReason("Memory PSI", memoryPressure, memoryThreshold);
+    } else if (ioThreshold > 0 && ioPressure > ioThreshold) {
+        reason = formatReason("I/O PSI", ioPressure, ioThreshold);
+    }
+
+    // Only on the way up, and not more than once per cooldown while a spike drags on.
+    bool over = !reason.empty();
+    auto now = Clock::now();
+    bool cooledDown = triggerCount == 0 || now - lastTrigger >= std::chrono::seconds(kCooldownSeconds);
+    if (over && !wasOver && cooledDown) {
+        lastTrigger = now;
+        triggerCount++;
+        begin(reason, metrics);
+    }
+    wasOver = over;
+}
+
+void SpikeCaptureMonitor::begin(const std::string& reason, const MetricSnapshot& metrics) {
+    capturing = true;
+    captureStart = Clock::now();
+    pending = SpikeSnapshot();
+    pending.reason = reason;
+    pending.when = std::time(nullptr);
+    pending.cpuPercent = metrics[MetricId::CpuUsage];
+    pending.metrics = metrics;
+    pending.memoryPressure = memoryPressure;
+    pending.ioPressure = ioPressure;
+
+    scanProcesses(baseProcesses, nullptr);
+    scanCores(baseCoreIds, baseCoreBusy, baseCoreTotal);
+    scanCgroups(baseCgroups);
+    interruptMonitor.update();
+}
+
+void SpikeCaptureMonitor::finish() {
+    capturing = false;
+    std::chrono::duration<double> window = Clock::now() - captureStart;
+    double elapsed = window.count();
+    pending.windowSec = elapsed;
+    if (elapsed <= 0) {
+        return;
+    }
+
+    std::vector<ProcessSample> processes;
+    scanProcesses(processes, &pending.topProcesses);
+    for (size_t i = 0; i < processes.size(); ++i) {
+        auto base = std::lower_bound(baseProcesses.begin(), baseProcesses.end(), processes[i].pid,
+                                     [](const ProcessSample& s, int pid) { return s.pid < pid; });
+        unsigned long long previous = base != baseProcesses.end() && base->pid == processes[i].pid ? base->ticks : 0;
+        unsigned long long delta = processes[i].ticks >= previous ? processes[i].ticks - previous : 0;
+        pending.topProcesses[i].cpuPercent = delta * 100.0 / ticksPerSecond / elapsed;
+    }
+    size_t topCount = std::min(kTopProcesses, pending.topProcesses.size());
+    std::partial_sort(pending.topProcesses.begin(), pending.topProcesses.begin() + topCount,
+                      pending.topProcesses.end(),
+                      [](const SpikeProcess& a, const SpikeProcess& b) { return a.cpuPercent > b.cpuPercent; });
+    pending.topProcesses.resize(topCount);
+
+    // Paired by CPU number, both lists ascending: a CPU that went offline or came online in
+    // between is left out rather than shifting the rest.
+    std::vector<int> ids;
+    std::vector<unsigned long long> busy, total;
+    scanCores(ids, busy, total);
+    pending.coreUsage.clear();
+    pending.coreIds.clear();
+    for (size_t i = 0, b = 0; i < ids.size() && b < baseCoreIds.size();) {
+        if (ids[i] != baseCoreIds[b]) {
+            ids[i] < baseCoreIds[b] ? ++i : ++b;
+            continue;
+        }
+        double usage = 0.0;
+        if (total[i] > baseCoreTotal[b] && busy[i] >= baseCoreBusy[b]) {
+            usage = (busy[i] - baseCoreBusy[b]) * 100.0 / (total[i] - baseCoreTotal[b]);
+        }
+        pending.coreUsage.push_back(usage);
+        pending.coreIds.push_back(ids[i]);
+        ++i;
+        ++b;
+    }
+
+    std::vector<CgroupSample> cgroups;
+    scanCgroups(cgroups);
+    for (const CgroupSample& sample : cgroups) {
+        auto base = std::find_if(baseCgroups.begin(), baseCgroups.end(),
+                                 [&](const CgroupSample& b) { return b.path == sample.path; });
+        if (base == baseCgroups.end() || sample.usageUsec < base->usageUsec) continue;
+        SpikeCgroup cgroup;
+        cgroup.path = sample.path;
+        cgroup.cpuPercent = (sample.usageUsec - base->usageUsec) / 1e4 / elapsed;
+        ProcFile memory(cgroupRoot + "/" + sample.path + "/memory.current");
+        if (memory.read()) {
+            cgroup.memoryKb = strtoll(memory.data(), nullptr, 10) / 1024;
+        }
+        pending.cgroups.push_back(std::move(cgroup));
+    }
+    std::sort(pending.cgroups.begin(), pending.cgroups.end(),
+              [](const SpikeCgroup& a, const SpikeCgroup& b) { return a.cpuPercent > b.cpuPercent; });
+    if (pending.cgroups.size() > kTopCgroups) {
+        pending.cgroups.resize(kTopCgroups);
+    }
+
+    interruptMonitor.update();
+    topIrqs(interruptMonitor.getInterrupts(), pending.interrupts);
+    topIrqs(interruptMonitor.getSoftirqs(), pending.softirqs);
+
+    ring[next] = std::move(pending);
+    next = (next + 1) % ring.size();
+    count = std::min(count + 1, ring.size());
+}
+
+void SpikeCaptureMonitor::scanProcesses(std::vector<ProcessSample>& out, std::vector<SpikeProcess>* details) {
+    // The expensive part: one stat read per process. Only ever runs on the two capture updates.
+    out.clear();
+    if (details) details->clear();
+    DIR* dir = opendir(procRoot.c_str());
+    if (!dir) {
+        return;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (!isNumeric(ent->d_name)) continue;
+        ProcFile stat(procRoot + "/" + ent->d_name + "/stat");
+        if (!stat.read()) continue;
+        const char* nameStart = strchr(stat.data(), '(');
+        const char* nameEnd = strrchr(stat.data(), ')');
+        if (!nameStart || !nameEnd || nameEnd < nameStart) continue;
+
+        // Fields after the command name: state is 1st, utime 12th, stime 13th, rss 22nd.
+        unsigned long long fields[22] = {};
+        const char* p = nameEnd + 2;
+        for (int i = 0; i < 22 && *p; ++i) {
+            char* end = nullptr;
+            fields[i] = i == 0 ? 0 : strtoull(p, &end, 10);
+            const char* space = strchr(p, ' ');
+            if (!space) break;
+            p = space + 1;
+        }
+        ProcessSample sample;
+        sample.pid = atoi(ent->d_name);
+        sample.ticks = fields[11] + fields[12];
+        out.push_back(sample);
+        if (details) {
+            SpikeProcess process;
+            process.pid = sample.pid;
+            process.name.assign(nameStart + 1, nameEnd);
+            process.rssKb = static_cast<long long>(fields[21]) * pageKb;
+            details->push_back(std::move(process));
+        }
+    }
+    closedir(dir);
+
+    if (!details) {
+        std::sort(out.begin(), out.end(), [](const ProcessSample& a, const ProcessSample& b) { return a.pid < b.pid; });
+    }
+}
+
+void SpikeCaptureMonitor::scanCores(std::vector<int>& ids, std::vector<unsigned long long>& busy,
+                                    std::vector<unsigned long long>& total) {
+    ids.clear();
+    busy.clear();
+    total.clear();
+    ProcFile stat(procRoot + "/stat");
+    if (!stat.read()) {
+        return;
+    }
+    const char* p = stat.data();
+    while ((p = strstr(p, "\ncpu")) != nullptr) {
+        p += 4;
+        if (*p < '0' || *p > '9') break;
+        char* q = nullptr;
+        ids.push_back(static_cast<int>(strtoul(p, &q, 10)));
+        unsigned long long values[8] = {};
+        for (int i = 0; i < 8; ++i) {
+            values[i] = strtoull(q, &q, 10);
+        }
+        unsigned long long sum = 0;
+        for (unsigned long long v : values) sum += v;
+        total.push_back(sum);
+        busy.push_back(sum - values[3] - values[4]); // minus idle and iowait
+    }
+}
+
+void SpikeCaptureMonitor::scanCgroups(std::vector<CgroupSample>& out) {
+    // Top-level cgroups and their direct children, e.g. system.slice/docker.service.
+    out.clear();
+    std::vector<std::string> dirs;
+    DIR* root = opendir(cgroupRoot.c_str());
+    if (!root) {
+        return;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(root)) != NULL) {
+        if (ent->d_type == DT_DIR && ent->d_name[0] != '.') {
+            dirs.push_back(ent->d_name);
+        }
+    }
+    closedir(root);
+    size_t topLevel = dirs.size();
+    for (size_t i = 0; i < topLevel; ++i) {
+        DIR* child = opendir((cgroupRoot + "/" + dirs[i]).c_str());
+        if (!child) continue;
+        while ((ent = readdir(child)) != NULL) {
+            if (ent->d_type == DT_DIR && ent->d_name[0] != '.') {
+                dirs.push_back(dirs[i] + "/" + ent->d_name);
+            }
+        }
+        closedir(child);
+    }
+
+    for (const std::string& dir : dirs) {
+        ProcFile cpuStat(cgroupRoot + "/" + dir + "/cpu.stat");
+        long long usage = 0;
+        KeyField fields[] = {{"usage_usec", &usage}};
+        if (cpuStat.read() && parseKeyTable(cpuStat.view(), fields, 1) == 1) {
+            out.push_back({dir, static_cast<unsigned long long>(usage)});
+        }
+    }
+}
+
+void SpikeCaptureMonitor::topIrqs(const InterruptTable& table, std::vector<SpikeIrq>& out) {
+    out.clear();
+    std::vector<size_t> rows(table.rowRates.size());
+    for (size_t i = 0; i < rows.size(); ++i) rows[i] = i;
+    size_t shown = std::min(kTopIrqs, rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + shown, rows.end(),
+                      [&](size_t a, size_t b) { return table.rowRates[a] > table.rowRates[b]; });
+    for (size_t i = 0; i < shown; ++i) {
+        SpikeIrq irq;
+        irq.name = table.names[rows[i]];
+        irq.description = rows[i] < table.descriptions.size() ? table.descriptions[rows[i]] : "";
+        irq.rate = table.rowRates[rows[i]];
+        out.push_back(std::move(irq));
+    }
+}
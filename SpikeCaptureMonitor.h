@@ -0,0 +1,120 @@
+#ifndef SPIKE_CAPTURE_MONITOR_H
+#define SPIKE_CAPTURE_MONITOR_H
+
+#include "InterruptMonitor.h"
+#include "MetricRegistry.h"
+#include "ProcFile.h"
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+struct SpikeProcess {
+    int pid = 0;
+    std::string name;
+    double cpuPercent = 0.0;  // 100 = one core
+    long long rssKb = 0;
+};
+
+struct SpikeCgroup {
+    std::string path;         // relative to the cgroup root, e.g. "system.slice/docker.service"
+    double cpuPercent = 0.0;
+    long long memoryKb = 0;
+};
+
+struct SpikeIrq {
+    std::string name;
+    std::string description;
+    double rate = 0.0;
+};
+
+struct SpikeSnapshot {
+    std::string reason;       // e.g. "CPU 97% > 90%"
+    std::time_t when = 0;
+    double windowSec = 0.0;   // detail below is measured over this window, starting at the trigger
+    double cpuPercent = 0.0;
+    double memoryPressure = 0.0;
+    double ioPressure = 0.0;
+    MetricSnapshot metrics;   // every registered metric as of the trigger update
+    std::vector<SpikeProcess> topProcesses;
+    std::vector<double> coreUsage;
+    std::vector<int> coreIds; // CPU number of each coreUsage entry; gaps where CPUs are offline
+    std::vector<SpikeCgroup> cgroups;
+    std::vector<SpikeIrq> interrupts;
+    std::vector<SpikeIrq> softirqs;
+};
+
+class SpikeCaptureMonitor {
+public:
+    // Watches cheap signals (total CPU, memory and I/O PSI) every update. When one crosses its threshold,
+    // it takes a detailed snapshot: the trigger update records the baseline and the next update completes
+    // it. The last few snapshots are kept in a ring.
+    explicit SpikeCaptureMonitor(const std::string& procRoot = "/proc", const std::string& cgroupRoot = "/sys/fs/cgroup");
+
+    void setThresholds(double cpuPercent, double memoryPressure, double ioPressure);
+    void setHistorySize(int snapshots);
+    void update(const MetricSnapshot& metrics);
+
+    double getMemoryPressure() const { return memoryPressure; }
+    double getIoPressure() const { return ioPressure; }
+    bool isCapturing() const { return capturing; }
+    int getTriggerCount() const { return triggerCount; }
+    size_t getCaptureCount() const { return count; }
+    const SpikeSnapshot& getCapture(size_t newest) const; // 0 is the most recent
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kCooldownSeconds = 30;
+    static constexpr size_t kTopProcesses = 10;
+    static constexpr size_t kTopCgroups = 8;
+    static constexpr size_t kTopIrqs = 5;
+
+    struct ProcessSample {
+        int pid;
+        unsigned long long ticks;
+    };
+    struct CgroupSample {
+        std::string path;
+        unsigned long long usageUsec;
+    };
+
+    std::string procRoot;
+    std::string cgroupRoot;
+    double cpuThreshold;
+    double memoryThreshold;
+    double ioThreshold;
+    ProcFile memoryPressureFile;
+    ProcFile ioPressureFile;
+    double memoryPressure;
+    double ioPressure;
+    bool wasOver;
+    int triggerCount;
+    Clock::time_point lastTrigger;
+
+    // Baseline taken on the trigger update.
+    bool capturing;
+    Clock::time_point captureStart;
+    SpikeSnapshot pending;
+    std::vector<ProcessSample> baseProcesses;
+    std::vector<int> baseCoreIds;
+    std::vector<unsigned long long> baseCoreBusy;
+    std::vector<unsigned long long> baseCoreTotal;
+    std::vector<CgroupSample> baseCgroups;
+    InterruptMonitor interruptMonitor;
+
+    std::vector<SpikeSnapshot> ring;
+    size_t next;
+    size_t count;
+    long ticksPerSecond;
+    long pageKb;
+
+    double readPressure(ProcFile& file);
+    void begin(const std::string& reason, const MetricSnapshot& metrics);
+    void finish();
+    void scanProcesses(std::vector<ProcessSample>& out, std::vector<SpikeProcess>* details);
+    void scanCores(std::vector<int>& ids, std::vector<unsigned long long>& busy, std::vector<unsigned long long>& total);
+    void scanCgroups(std::vector<CgroupSample>& out);
+    void topIrqs(const InterruptTable& table, std::vector<SpikeIrq>& out);
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "Subprocess.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+namespace {
+
+constexpr int kExitGraceMs = 100; // for a child that closed its stdout to finish exiting
+
+int openPidFd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+} // namespace
+
+Subprocess::Subprocess(size_t chunkSize)
+    : chunkSize(chunkSize), length(0), pid(-1), pidFd(-1), outFd(-1), status(-1), timedOutFlag(false),
+      outputEnded(false) {}
+
+Subprocess::~Subprocess() {
+    stop();
+}
+
+bool Subprocess::start(const std::vector<std::string>& argv) {
+    stop();
+    length = 0;
+    status = -1;
+    timedOutFlag = false;
+    outputEnded = false;
+    errorText.clear();
+    if (argv.empty()) {
+        errorText = "no command";
+        return false;
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        errorText = strerror(errno);
+        return false;
+    }
+    // Only our end is non-blocking; the child gets an ordinary blocking stdout.
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    // Start the child with a clean signal mask and default SIGPIPE whatever this process uses.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    // Its own process group, so a kill also reaches whatever a wrapper script started.
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    args.clear();
+    for (const std::string& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    // glibc implements this with clone(CLONE_VM | CLONE_VFORK), so nothing is copied for the exec.
+    int rc = posix_spawnp(&pid, args[0], &actions, &attr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+    if (rc != 0) {
+        close(fds[0]);
+        pid = -1;
+        errorText = argv[0] + ": " + strerror(rc);
+        return false;
+    }
+    outFd = fds[0];
+    pidFd = openPidFd(pid);
+    return true;
+}
+
+bool Subprocess::readAvailable() {
+    while (outFd >= 0) {
+        if (buffer.size() < length + chunkSize) {
+            buffer.resize(length + chunkSize);
+        }
+        ssize_t n = read(outFd, buffer.data() + length, chunkSize);
+        if (n > 0) {
+            length += static_cast<size_t>(n);
+        } else if (n == 0) {
+            outputEnded = true;
+            closeOutput();
+            return false;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN) {
+            return true;
+        } else {
+            closeOutput();
+            return false;
+        }
+    }
+    return false;
+}
+
+void Subprocess::consume(size_t count) {
+    count = std::min(count, length);
+    memmove(buffer.data(), buffer.data() + count, length - count);
+    length -= count;
+}
+
+void Subprocess::closeOutput() {
+    if (outFd >= 0) {
+        close(outFd);
+        outFd = -1;
+    }
+}
+
+bool Subprocess::hasExited() {
+    if (pidFd >= 0) {
+        pollfd fd = {pidFd, POLLIN, 0};
+        return poll(&fd, 1, 0) > 0;
+    }
+    siginfo_t info;
+    info.si_pid = 0;
+    return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0;
+}
+
+void Subprocess::waitForExit(int timeoutMs) {
+    if (pidFd >= 0) {
+        pollfd fd = {pidFd, POLLIN, 0};
+        while (poll(&fd, 1, timeoutMs) < 0 && errno == EINTR) {}
+        return;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!hasExited() && std::chrono::steady_clock::now() < deadline) {
+        usleep(1000);
+    }
+}
+
+void Subprocess::reap() {
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    int rc = -1;
+    if (pidFd >= 0) {
+        while ((rc = waitid(static_cast<idtype_t>(P_PIDFD), pidFd, &info, WEXITED)) != 0 && errno == EINTR) {}
+    }
+    // P_PIDFD needs 5.4; pidfd_open alone arrived in 5.3.
+    if (rc != 0) {
+        while ((rc = waitid(P_PID, pid, &info, WEXITED)) != 0 && errno == EINTR) {}
+    }
+    if (rc == 0) {
+        status = info.si_code == CLD_EXITED ? info.si_status : -info.si_status;
+    }
+    if (pidFd >= 0) {
+        close(pidFd);
+        pidFd = -1;
+    }
+    pid = -1;
+}
+
+void Subprocess::stop() {
+    closeOutput();
+    if (pid > 0) {
+        if (outputEnded && !hasExited()) {
+            waitForExit(kExitGraceMs);
+        }
+        // An exited leader keeps the group id alive until it is reaped, so this still reaches leftovers.
+        if (kill(-pid, SIGKILL) != 0 && !hasExited()) {
+            kill(pid, SIGKILL);
+        }
+        reap();
+    }
+}
+
+bool Subprocess::run(const std::vector<std::string>& argv, int timeoutMs) {
+    if (!start(argv)) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    bool exited = false;
+    while (outFd >= 0 || !exited) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            timedOutFlag = true;
+            errorText = argv[0] + ": timed out";
+            break;
+        }
+        // Without a pidfd there is nothing to poll for exit, so check back every few ms.
+        pollfd fds[2] = {{outFd, POLLIN, 0}, {exited ? -1 : pidFd, POLLIN, 0}};
+        int waitMs = static_cast<int>(remaining.count());
+        if (pidFd < 0 && outFd < 0) {
+            waitMs = std::min(waitMs, 10);
+        }
+        if (poll(fds, 2, waitMs) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[0].revents) {
+            readAvailable();
+        }
+        if (!exited) {
+            exited = fds[1].revents ? true : (pidFd < 0 && hasExited());
+        }
+    }
+    stop();
+    return !timedOutFlag && status == 0;
+}
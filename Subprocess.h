@@ -0,0 +1,63 @@
+#ifndef SUBPROCESS_H
+#define SUBPROCESS_H
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+class Subprocess {
+public:
+    // Runs a program with posix_spawn (no shell) in its own process group, collecting its stdout
+    // through a non-blocking pipe into a buffer that is kept between runs. A child that outlives
+    // its timeout gets SIGKILL. Exit is noticed and reaped through a pidfd where the kernel has
+    // them (5.3+).
+    explicit Subprocess(size_t chunkSize = 64 * 1024);
+    ~Subprocess();
+    Subprocess(const Subprocess&) = delete;
+    Subprocess& operator=(const Subprocess&) = delete;
+
+    // One-shot: start, read until EOF and exit or until timeoutMs, then reap. Returns true when
+    // the program ran to completion with exit status 0.
+    bool run(const std::vector<std::string>& argv, int timeoutMs);
+
+    // For long-running children: start(), then readAvailable() whenever outputFd() polls readable.
+    // readAvailable() appends to output() and returns false once the child closed its stdout.
+    bool start(const std::vector<std::string>& argv);
+    bool readAvailable();
+    // SIGKILLs the child's process group, so whatever a wrapper script started goes too, then
+    // reaps the child. One that already closed its stdout is on its way out, so it gets a moment
+    // to exit by itself first and keeps its own exit status.
+    void stop();
+    bool hasExited(); // without reaping, so stop() still collects the status
+    bool isRunning() const { return pid > 0; }
+    int outputFd() const { return outFd; }
+    int getPidFd() const { return pidFd; }
+
+    std::string_view output() const { return std::string_view(buffer.data(), length); }
+    void consume(size_t count); // drop the first count bytes of output()
+    void clearOutput() { length = 0; }
+
+    bool timedOut() const { return timedOutFlag; }
+    int exitStatus() const { return status; }   // exit code, or -signal when killed, -1 before exit
+    const std::string& error() const { return errorText; }
+
+private:
+    size_t chunkSize;
+    std::vector<char> buffer;
+    size_t length;
+    pid_t pid;
+    int pidFd;
+    int outFd;
+    int status;
+    bool timedOutFlag;
+    bool outputEnded; // read() saw EOF: the child closed its stdout
+    std::string errorText;
+    std::vector<char*> args; // kept between starts, so a repeated command doesn't reallocate it
+
+    void closeOutput();
+    void waitForExit(int timeoutMs);
+    void reap();
+};
+
+#endif
@@ -9,67 +9,131 @@
 #include <algorithm>
 #include <memory>
 #include <dirent.h> 
-
-
-std::string exec(const char* cmd) {
-    // Runs a shell command and returns its output. Useful for getting system info.
-    std::array<char, 128> buffer;
-    std::string result;
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
-    if (!pipe) {
-        
-        return ""; 
-    }
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
-    }
-    return result;
-}
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 SystemMonitor::SystemMonitor()
-    : cpuUsage(0.0),
-      cpuTemperature(0),
-      totalMemory(0),
-      usedMemory(0),
-      availableMemory(0),
-      downloadSpeed(0.0),
-      uploadSpeed(0.0),
-      pingLatency(0.0),
-      gpuUsage(0.0),
-      gpuMemoryUsed(0),
-      gpuMemoryTotal(0),
-      gpuTemperature(0),
-      fps(0.0),
-      processCpuUsage(0.0),
-      processMemoryUsage(0),
+    : cpuTicksElapsed(0),
+      cgroupCpuEnabled(false),
+      collectedCpuTemperature(0),
       prevProcessCpuUserTime(0),
       prevProcessCpuKernelTime(0),
-      prevProcessCpuTotalTime(0)
+      prevProcessCpuTotalTime(0),
+      prevRxBytes(0),
+      prevTxBytes(0),
+      interruptStatsEnabled(false),
+      perfCountersEnabled(false),
+      runqueueLatencyEnabled(false),
+      numaStatsEnabled(false),
+      compressedMemoryEnabled(false),
+      tcpStatsEnabled(false),
+      packetDropStatsEnabled(false),
+      gpuProcessStatsEnabled(false),
+      customMetricsEnabled(false),
+      spikeCaptureEnabled(false),
+      burstOnTrigger(false),
+      kernelEventsEnabled(false),
+      seenSpikeTriggers(0),
+      samplingMinMs(0),
+      samplingMaxMs(0)
 {
     lastUpdateTime = std::chrono::steady_clock::now();
+    meminfoFile.open("/proc/meminfo");
+    statFile.open("/proc/stat");
+    netDevFile.open("/proc/net/dev");
+    selfStatFile.open("/proc/self/stat");
+    selfStatusFile.open("/proc/self/status");
     
     updateCpuStats();
     updateNetworkStats();
     updateProcessCpuStats(); 
-    lastPingUpdateTime = std::chrono::steady_clock::now();
-    lastGpuUpdateTime = std::chrono::steady_clock::now();
+    gpuBackends = probeGpuBackends();
+
+    // Anything that can block in the kernel or on another program runs on the pool, so a slow one
+    // costs its own line going stale instead of a late frame for everything.
+    // The last argument is the headline value each one's sampling interval adapts to, in units
+    // where 1 is a change worth noticing.
+    addCollector(CollectorSource::CpuTemperature, "CPU temperature", 50,
+                 [this] { updateCpuTemperature(); },
+                 [this] { metrics[MetricId::CpuTemperature] = collectedCpuTemperature; },
+                 [this] { return metrics[MetricId::CpuTemperature]; });
+    addCollector(CollectorSource::Gpu, "GPU", 500,
+                 [this] { updateGpuStats(); }, [this] { publishGpuStats(); },
+                 [this] { return metrics[MetricId::GpuUsage] / 10.0; });
+    addCollector(CollectorSource::CgroupCpu, "Cgroup CPU", 50,
+                 [this] { cgroupCpuMonitor.update(); }, [this] { cgroupCpuStats = cgroupCpuMonitor.getStats(); },
+                 [this] { return cgroupCpuStats.quotaPercent / 10.0; });
+    addCollector(CollectorSource::Interrupts, "Interrupts", 50,
+                 [this] { interruptMonitor.update(); },
+                 [this] {
+                     interruptTable = interruptMonitor.getInterrupts();
+                     softirqTable = interruptMonitor.getSoftirqs();
+                 },
+                 [this] { return (interruptTable.totalRate + softirqTable.totalRate) / 1000.0; });
+    addCollector(CollectorSource::PerfCounters, "Perf counters", 50,
+                 [this] { perfCounterMonitor.update(); }, [this] { perfCounterStats = perfCounterMonitor.getStats(); },
+                 [this] { return perfCounterStats.contextSwitchesPerSec / 1000.0; });
+    addCollector(CollectorSource::RunqueueLatency, "Runqueue latency", 100,
+                 [this] { runqueueLatencyMonitor.update(); },
+                 [this] { runqueueLatencyStats = runqueueLatencyMonitor.getStats(); },
+                 [this] { return runqueueLatencyStats.p99Us / 100.0; });
+    addCollector(CollectorSource::Numa, "NUMA", 50,
+                 [this] { numaMonitor.update(); }, [this] { numaStats = numaMonitor.getStats(); },
+                 [this] { return numaStats.remotePercent; });
+    addCollector(CollectorSource::CompressedMemory, "Compressed memory", 50,
+                 [this] { compressedMemoryMonitor.update(); },
+                 [this] { compressedMemoryStats = compressedMemoryMonitor.getStats(); },
+                 [this] {
+                     return (compressedMemoryStats.zramOriginalBytes + compressedMemoryStats.zswapStoredBytes) /
+                            (64.0 * 1024 * 1024);
+                 });
+    addCollector(CollectorSource::Tcp, "TCP", 100,
+                 [this] { tcpMonitor.update(); }, [this] { tcpStats = tcpMonitor.getStats(); },
+                 [this] { return tcpStats.retransSegsRate + tcpStats.inErrsRate; });
+    addCollector(CollectorSource::PacketDrops, "Packet drops", 50,
+                 [this] { packetDropMonitor.update(); }, [this] { packetDropStats = packetDropMonitor.getStats(); },
+                 [this] { return packetDropStats.processedRate / 1000.0 + packetDropStats.droppedRate; });
+    addCollector(CollectorSource::GpuProcesses, "GPU processes", 100,
+                 [this] { gpuProcessMonitor.update(); }, [this] { gpuProcessTable = gpuProcessMonitor.getStats(); },
+                 [this] {
+                     double busy = 0.0;
+                     for (const GpuProcessStats& process : gpuProcessTable.processes) busy += process.busyPercent;
+                     return busy / 10.0;
+                 });
+    // Each custom metric keeps its own interval, so this one just runs every tick.
+    addCollector(CollectorSource::CustomMetrics, "Custom metrics", 50,
+                 [this] { customMetricMonitor.update(); },
+                 [this] { customMetricStats = customMetricMonitor.getStats(); }, nullptr);
+}
+
+void SystemMonitor::addCollector(CollectorSource source, const char* name, int deadlineMs,
+                                 std::function<void()> collect, std::function<void()> publish,
+                                 std::function<double()> signal) {
+    int id = collectorPool.addSource(name, std::chrono::milliseconds(deadlineMs), std::move(collect), std::move(publish),
+                                     std::move(signal));
+    // Ids come back in registration order, which has to match CollectorSource.
+    assert(id == static_cast<int>(source));
+    (void)id;
+    (void)source;
 }
 
-CpuStats SystemMonitor::parseCpuStats(const std::string& line) {
-    std::istringstream iss(line);
-    std::string cpuLabel;
+CpuStats SystemMonitor::parseCpuStats(const char* line) {
+    // "cpu  user nice system idle iowait irq softirq steal guest guest_nice"
     CpuStats stats{};
-    iss >> cpuLabel >> stats.user >> stats.nice >> stats.system >> stats.idle
-        >> stats.iowait >> stats.irq >> stats.softirq >> stats.steal
-        >> stats.guest >> stats.guest_nice;
+    char* p = const_cast<char*>(line);
+    while (*p && *p != ' ') ++p;
+    long long* fields[] = {&stats.user, &stats.nice, &stats.system, &stats.idle, &stats.iowait,
+                           &stats.irq, &stats.softirq, &stats.steal, &stats.guest, &stats.guest_nice};
+    for (long long* field : fields) {
+        *field = strtoll(p, &p, 10);
+    }
     return stats;
 }
 
 void SystemMonitor::updateCpuStats() {
-    std::ifstream file("/proc/stat");
-    std::string line;
-    if (std::getline(file, line)) {
-        CpuStats currentCpuStats = parseCpuStats(line);
+    if (statFile.read()) {
+        CpuStats currentCpuStats = parseCpuStats(statFile.data());
 
         long long prevIdle = prevCpuStats.idle + prevCpuStats.iowait;
         long long currentIdle = currentCpuStats.idle + currentCpuStats.iowait;
@@ -82,176 +146,160 @@ void SystemMonitor::updateCpuStats() {
 
         long long totalDiff = currentTotal - prevTotal;
         long long idleDiff = currentIdle - prevIdle;
+        // Guest time is counted in user as well; the process share below divides by all of it.
+        cpuTicksElapsed = totalDiff + (currentCpuStats.guest + currentCpuStats.guest_nice) -
+                          (prevCpuStats.guest + prevCpuStats.guest_nice);
 
+        // Steal: the hypervisor ran someone else while we had work. Guest: time spent running our
+        // own guests, already part of user.
         if (totalDiff > 0) {
-            cpuUsage = (double)(totalDiff - idleDiff) / totalDiff * 100.0;
+            metrics[MetricId::CpuUsage] = (double)(totalDiff - idleDiff) / totalDiff * 100.0;
+            metrics[MetricId::CpuSteal] = (double)(currentCpuStats.steal - prevCpuStats.steal) / totalDiff * 100.0;
+            metrics[MetricId::CpuGuest] = (double)(currentCpuStats.guest + currentCpuStats.guest_nice -
+                                                   prevCpuStats.guest - prevCpuStats.guest_nice) / totalDiff * 100.0;
         } else {
-            cpuUsage = 0.0;
+            metrics[MetricId::CpuUsage] = 0.0;
+            metrics[MetricId::CpuSteal] = 0.0;
+            metrics[MetricId::CpuGuest] = 0.0;
         }
         prevCpuStats = currentCpuStats;
     }
 }
 
 void SystemMonitor::updateCpuTemperature() {
-    cpuTemperature = 0; 
-    DIR *dir;
-    struct dirent *ent;
-    if ((dir = opendir("/sys/class/thermal/")) != NULL) {
-        while ((ent = readdir(dir)) != NULL) {
-            std::string entry_name = ent->d_name;
-            if (entry_name.rfind("thermal_zone", 0) == 0) { 
-                std::string temp_path = std::string("/sys/class/thermal/") + entry_name + "/temp";
-                std::ifstream temp_file(temp_path);
-                if (temp_file.is_open()) {
-                    int temp_milli_celsius;
-                    temp_file >> temp_milli_celsius;
-                    cpuTemperature = temp_milli_celsius / 1000; 
-                    temp_file.close();
-                    
-                    closedir(dir);
-                    return;
+    collectedCpuTemperature = 0; 
+    // Find the first thermal zone once and keep its temp file open; look again only if it goes away.
+    if (!temperatureFile.isOpen()) {
+        DIR *dir;
+        struct dirent *ent;
+        if ((dir = opendir("/sys/class/thermal/")) != NULL) {
+            while ((ent = readdir(dir)) != NULL) {
+                if (strncmp(ent->d_name, "thermal_zone", 12) == 0 &&
+                    temperatureFile.open(std::string("/sys/class/thermal/") + ent->d_name + "/temp")) {
+                    break;
                 }
             }
+            closedir(dir);
         }
-        closedir(dir);
+    }
+    if (temperatureFile.read()) {
+        collectedCpuTemperature = static_cast<int>(strtol(temperatureFile.data(), nullptr, 10) / 1000);
+    } else {
+        temperatureFile.close();
     }
 }
 
 void SystemMonitor::updateMemoryStats() {
-    std::ifstream file("/proc/meminfo");
-    std::string line;
-    totalMemory = 0;
-    usedMemory = 0;
-    availableMemory = 0;
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        long long value;
-        std::string unit;
-        iss >> key >> value >> unit;
-
-        if (key == "MemTotal:") {
-            totalMemory = value; 
-        } else if (key == "MemAvailable:") {
-            availableMemory = value; 
-        }
+    long long totalMemory = 0;
+    long long availableMemory = 0;
+    const KeyField fields[] = {
+        {"MemTotal", &totalMemory},
+        {"MemAvailable", &availableMemory},
+    };
+    if (meminfoFile.read()) {
+        parseKeyTable(meminfoFile.view(), fields, 2);
     }
-    usedMemory = totalMemory - availableMemory;
+    metrics[MetricId::MemoryTotal] = static_cast<double>(totalMemory);
+    metrics[MetricId::MemoryAvailable] = static_cast<double>(availableMemory);
+    metrics[MetricId::MemoryUsed] = static_cast<double>(totalMemory - availableMemory);
 }
 
 void SystemMonitor::updateNetworkStats() {
-    std::ifstream file("/proc/net/dev");
-    std::string line;
-    std::getline(file, line); 
-    std::getline(file, line); 
-
+    // Two header lines, then "  eth0: rx_bytes packets errs drop fifo frame compressed multicast tx_bytes ...".
     long long currentRxBytes = 0;
     long long currentTxBytes = 0;
-
-    std::map<std::string, NetworkInterfaceStats> currentNetworkStats;
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string interfaceName;
-        iss >> interfaceName; 
-        interfaceName.pop_back(); 
-
-        NetworkInterfaceStats stats;
-        
-        
-        iss >> stats.rx_bytes; 
-        for (int i = 0; i < 7; ++i) { std::string dummy; iss >> dummy; } 
-        iss >> stats.tx_bytes; 
-
-        currentNetworkStats[interfaceName] = stats;
-
-        currentRxBytes += stats.rx_bytes;
-        currentTxBytes += stats.tx_bytes;
+    if (netDevFile.read()) {
+        const char* p = netDevFile.data();
+        const char* end = p + netDevFile.size();
+        for (int skip = 0; skip < 2 && p < end; ++skip) {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+            p = lineEnd ? lineEnd + 1 : end;
+        }
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!lineEnd) lineEnd = end;
+            const char* colon = static_cast<const char*>(memchr(p, ':', lineEnd - p));
+            if (colon) {
+                char* field = const_cast<char*>(colon + 1);
+                currentRxBytes += strtoll(field, &field, 10);
+                for (int i = 0; i < 7; ++i) strtoll(field, &field, 10);
+                currentTxBytes += strtoll(field, &field, 10);
+            }
+            p = lineEnd + 1;
+        }
     }
 
     auto currentTime = std::chrono::steady_clock::now();
     std::chrono::duration<double> elapsedSeconds = currentTime - lastUpdateTime;
 
     if (elapsedSeconds.count() > 0) {
-        long long prevRxBytes = 0;
-        long long prevTxBytes = 0;
+        metrics[MetricId::NetDown] = (currentRxBytes - prevRxBytes) / elapsedSeconds.count();
+        metrics[MetricId::NetUp] = (currentTxBytes - prevTxBytes) / elapsedSeconds.count();
+    }
 
-        for (const auto& pair : prevNetworkStats) {
-            prevRxBytes += pair.second.rx_bytes;
-            prevTxBytes += pair.second.tx_bytes;
-        }
+    prevRxBytes = currentRxBytes;
+    prevTxBytes = currentTxBytes;
+}
 
-        downloadSpeed = (currentRxBytes - prevRxBytes) / elapsedSeconds.count();
-        uploadSpeed = (currentTxBytes - prevTxBytes) / elapsedSeconds.count();
+void SystemMonitor::setProbeTargets(const std::string& targetList, int intervalMs, int timeoutMs) {
+    // Comma-separated list, see ProbeTarget::parse for the accepted forms.
+    std::vector<ProbeTarget> targets;
+    std::istringstream iss(targetList);
+    std::string spec;
+    while (std::getline(iss, spec, ',')) {
+        ProbeTarget target;
+        if (ProbeTarget::parse(spec, target)) {
+            targets.push_back(target);
+        } else if (spec.find_first_not_of(" \t") != std::string::npos) {
+            std::cerr << "Ignoring invalid probe target: " << spec << std::endl;
+        }
     }
-
-    prevNetworkStats = currentNetworkStats;
+    probeEngine.start(targets, intervalMs, timeoutMs);
 }
 
 void SystemMonitor::updatePingStats() {
-    auto currentTime = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsedSeconds = currentTime - lastPingUpdateTime;
+    // The probes run on their own epoll thread, so this only picks up the latest results.
+    // The first target doubles as the overlay's "Ping" number.
+    probeEngine.copyStats(probeStats);
+    metrics[MetricId::Ping] = 0.0;
+    if (!probeStats.empty() && probeStats[0].ok) {
+        metrics[MetricId::Ping] = probeStats[0].lastConnectMs;
+    }
+}
 
-    if (elapsedSeconds.count() < 5.0) { 
+void SystemMonitor::setKernelEventsEnabled(bool enabled) {
+    // The kmsg reader is a thread, so only start or stop it when the setting actually changes.
+    if (enabled == kernelEventsEnabled) {
         return;
     }
-
-    
-    std::string pingOutput = exec("ping -c 1 -W 1 8.8.8.8");
-    lastPingUpdateTime = currentTime;
-    std::istringstream iss(pingOutput);
-    std::string line;
-    pingLatency = 0.0; 
-
-    while (std::getline(iss, line)) {
-        if (line.find("time=") != std::string::npos) {
-            size_t timePos = line.find("time=") + 5; 
-            size_t msPos = line.find(" ms", timePos);
-            if (msPos != std::string::npos) {
-                std::string timeStr = line.substr(timePos, msPos - timePos);
-                try {
-                    pingLatency = std::stod(timeStr);
-                } catch (const std::exception& e) {
-                    
-                    std::cerr << "Error parsing ping time: " << e.what() << std::endl;
-                }
-            }
-            break; 
-        }
+    kernelEventsEnabled = enabled;
+    if (enabled) {
+        kernelEventMonitor.start();
+    } else {
+        kernelEventMonitor.stop();
     }
 }
 
 void SystemMonitor::updateGpuStats() {
-    auto currentTime = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsedSeconds = currentTime - lastGpuUpdateTime;
-
-    if (elapsedSeconds.count() < 5.0) { 
-        return;
+    // Backends were picked once at startup; each refreshes its own cards at its own pace.
+    for (auto& backend : gpuBackends) {
+        backend->update();
     }
+}
 
-    
-    gpuUsage = 0.0;
-    gpuMemoryUsed = 0;
-    gpuMemoryTotal = 0;
-    gpuTemperature = 0;
-
-    
-    std::string nvidiaSmiOutput = exec("nvidia-smi --query-gpu=utilization.gpu,memory.used,memory.total,temperature.gpu --format=csv,noheader,nounits");
-    lastGpuUpdateTime = currentTime;
-    if (!nvidiaSmiOutput.empty()) {
-        std::istringstream iss(nvidiaSmiOutput);
-        std::string line;
-        if (std::getline(iss, line)) {
-            std::replace(line.begin(), line.end(), ',', ' '); 
-            std::istringstream lineStream(line);
-            lineStream >> gpuUsage >> gpuMemoryUsed >> gpuMemoryTotal >> gpuTemperature;
-        }
-    } else {
-        
-        
-        
+void SystemMonitor::publishGpuStats() {
+    gpuCards.clear();
+    for (auto& backend : gpuBackends) {
+        const std::vector<GpuCardStats>& cards = backend->getCards();
+        gpuCards.insert(gpuCards.end(), cards.begin(), cards.end());
     }
+
+    // The single-GPU metrics report the first card.
+    bool any = !gpuCards.empty();
+    metrics[MetricId::GpuUsage] = any ? gpuCards[0].usage : 0.0;
+    metrics[MetricId::GpuMemoryUsed] = any ? static_cast<double>(gpuCards[0].memoryUsed) : 0.0;
+    metrics[MetricId::GpuMemoryTotal] = any ? static_cast<double>(gpuCards[0].memoryTotal) : 0.0;
+    metrics[MetricId::GpuTemperature] = any ? gpuCards[0].temperature : 0.0;
 }
 
 long SystemMonitor::getSystemUptime() {
@@ -286,85 +334,154 @@ long SystemMonitor::getClockTicksPerSecond() {
 
 void SystemMonitor::updateProcessCpuStats() {
     // Calculates how much CPU this specific app is using. Really annoying.
-    std::ifstream file("/proc/self/stat");
-    std::string line;
-    if (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string dummy;
-        long utime, stime, cutime, cstime;
-
-        
-        for (int i = 0; i < 13; ++i) iss >> dummy;
-        iss >> utime >> stime >> cutime >> cstime;
-
-        long currentProcessCpuUserTime = utime + cutime;
-        long currentProcessCpuKernelTime = stime + cstime;
-        long currentProcessCpuTotalTime = currentProcessCpuUserTime + currentProcessCpuKernelTime;
-
-        if (prevProcessCpuTotalTime > 0) {
-            long long totalCpuTimeDiff = currentProcessCpuTotalTime - prevProcessCpuTotalTime;
-            long long totalSystemCpuTimeDiff = 0; 
-
-            
-            std::ifstream statFile("/proc/stat");
-            std::string statLine;
-            if (std::getline(statFile, statLine)) {
-                CpuStats currentSystemCpuStats = parseCpuStats(statLine);
-                long long currentSystemTotal = currentSystemCpuStats.user + currentSystemCpuStats.nice +
-                                               currentSystemCpuStats.system + currentSystemCpuStats.idle +
-                                               currentSystemCpuStats.iowait + currentSystemCpuStats.irq +
-                                               currentSystemCpuStats.softirq + currentSystemCpuStats.steal +
-                                               currentSystemCpuStats.guest + currentSystemCpuStats.guest_nice;
-
-                long long prevSystemTotal = prevCpuStats.user + prevCpuStats.nice +
-                                            prevCpuStats.system + prevCpuStats.idle +
-                                            prevCpuStats.iowait + prevCpuStats.irq +
-                                            prevCpuStats.softirq + prevCpuStats.steal +
-                                            prevCpuStats.guest + prevCpuStats.guest_nice;
-                totalSystemCpuTimeDiff = currentSystemTotal - prevSystemTotal;
-            }
-
-            if (totalSystemCpuTimeDiff > 0) {
-                processCpuUsage = (static_cast<double>(totalCpuTimeDiff) / totalSystemCpuTimeDiff) * 100.0;
-            } else {
-                processCpuUsage = 0.0;
-            }
-        } else {
-            processCpuUsage = 0.0;
-        }
-
-        prevProcessCpuUserTime = currentProcessCpuUserTime;
-        prevProcessCpuKernelTime = currentProcessCpuKernelTime;
-        prevProcessCpuTotalTime = currentProcessCpuTotalTime;
+    // utime, stime, cutime and cstime are fields 14-17; counting from after the ")" that ends the
+    // command name, which may itself contain spaces, they are the 12th to 15th.
+    if (!selfStatFile.read()) {
+        return;
+    }
+    const char* paren = strrchr(selfStatFile.data(), ')');
+    if (!paren) {
+        return;
+    }
+    char* field = const_cast<char*>(paren + 1);
+    for (int i = 0; i < 11; ++i) {
+        while (*field == ' ') ++field;
+        while (*field && *field != ' ') ++field;
+    }
+    long utime = strtol(field, &field, 10);
+    long stime = strtol(field, &field, 10);
+    long cutime = strtol(field, &field, 10);
+    long cstime = strtol(field, &field, 10);
+
+    long currentProcessCpuUserTime = utime + cutime;
+    long currentProcessCpuKernelTime = stime + cstime;
+    long currentProcessCpuTotalTime = currentProcessCpuUserTime + currentProcessCpuKernelTime;
+
+    // Over the same interval updateCpuStats just measured the whole machine for.
+    if (prevProcessCpuTotalTime > 0 && cpuTicksElapsed > 0) {
+        long long totalCpuTimeDiff = currentProcessCpuTotalTime - prevProcessCpuTotalTime;
+        metrics[MetricId::AppCpu] = (static_cast<double>(totalCpuTimeDiff) / cpuTicksElapsed) * 100.0;
+    } else {
+        metrics[MetricId::AppCpu] = 0.0;
     }
+
+    prevProcessCpuUserTime = currentProcessCpuUserTime;
+    prevProcessCpuKernelTime = currentProcessCpuKernelTime;
+    prevProcessCpuTotalTime = currentProcessCpuTotalTime;
 }
 
 void SystemMonitor::updateProcessMemoryStats() {
-    std::ifstream file("/proc/self/status");
-    std::string line;
-    processMemoryUsage = 0; 
-
-    while (std::getline(file, line)) {
-        if (line.rfind("VmRSS:", 0) == 0) { 
-            std::istringstream iss(line);
-            std::string key;
-            long long value;
-            std::string unit;
-            iss >> key >> value >> unit;
-            processMemoryUsage = value; 
-            break;
-        }
+    long long rss = 0;
+    const KeyField fields[] = {{"VmRSS", &rss}};
+    if (selfStatusFile.read()) {
+        parseKeyTable(selfStatusFile.view(), fields, 1);
     }
+    metrics[MetricId::AppMemory] = static_cast<double>(rss);
 }
 
 void SystemMonitor::update() {
-    updateCpuStats();
-    updateCpuTemperature(); 
-    updateMemoryStats();
-    updateNetworkStats();
-    updatePingStats();
-    updateGpuStats(); 
-    updateProcessCpuStats(); 
-    updateProcessMemoryStats(); 
+    updateAllocations.begin();
+    runUpdate();
+    updateAllocations.end();
+}
+
+void SystemMonitor::runUpdate() {
+    // The cgroup path and custom metrics can only change while their collectors are idle on the pool.
+    if (!collectorPool.isRunning(static_cast<int>(CollectorSource::CgroupCpu))) {
+        cgroupCpuMonitor.setCgroupPath(cgroupPath);
+    }
+    if (!collectorPool.isRunning(static_cast<int>(CollectorSource::CustomMetrics))) {
+        customMetricMonitor.setMetrics(customMetricSpecs);
+    }
+    // Switched off, the perf groups would keep holding PMU counters and fds, and the BPF programs
+    // would stay on sched_switch, so both are released.
+    if (!perfCountersEnabled && !collectorPool.isRunning(static_cast<int>(CollectorSource::PerfCounters))) {
+        perfCounterMonitor.close();
+    }
+    if (!runqueueLatencyEnabled && !collectorPool.isRunning(static_cast<int>(CollectorSource::RunqueueLatency))) {
+        runqueueLatencyMonitor.detach();
+    }
+    auto enable = [this](CollectorSource source, bool enabled) {
+        collectorPool.setEnabled(static_cast<int>(source), enabled);
+    };
+    enable(CollectorSource::CpuTemperature, true);
+    enable(CollectorSource::Gpu, !gpuBackends.empty());
+    enable(CollectorSource::CgroupCpu, cgroupCpuEnabled);
+    enable(CollectorSource::Interrupts, interruptStatsEnabled);
+    enable(CollectorSource::PerfCounters, perfCountersEnabled);
+    enable(CollectorSource::RunqueueLatency, runqueueLatencyEnabled);
+    enable(CollectorSource::Numa, numaStatsEnabled);
+    enable(CollectorSource::CompressedMemory, compressedMemoryEnabled);
+    enable(CollectorSource::Tcp, tcpStatsEnabled);
+    enable(CollectorSource::PacketDrops, packetDropStatsEnabled);
+    enable(CollectorSource::GpuProcesses, gpuProcessStatsEnabled);
+    enable(CollectorSource::CustomMetrics, customMetricsEnabled && !customMetricSpecs.empty());
+
+    // A stall the kernel reported, or a spike caught on the last update, puts everything back on
+    // the fast rate before this round is scheduled, and can start a burst capture.
+    bool pressureFired = pressureTrigger.check();
+    bool spiked = spikeCaptureMonitor.getTriggerCount() != seenSpikeTriggers;
+    if (pressureFired || spiked) {
+        seenSpikeTriggers = spikeCaptureMonitor.getTriggerCount();
+        snapSampling();
+        if (burstOnTrigger) {
+            burstCaptureMonitor.trigger(spiked ? "spike threshold" : "PSI trigger");
+        }
+    }
+    auto now = std::chrono::steady_clock::now();
+    collectorPool.startRound();
+
+    // The cheap /proc reads stay on this thread while the pool works.
+    bool coreDue = coreRate.isDue(now);
+    if (coreDue) {
+        coreRate.ran(now);
+        updateCpuStats();
+        updateMemoryStats();
+        updateNetworkStats();
+        updatePingStats();
+        updateProcessCpuStats(); 
+        updateProcessMemoryStats(); 
+        watchedProcessMonitor.update();
+    }
+    collectorPool.finishRound();
+    if (!coreDue) {
+        return;
+    }
+
+    // PSS/USS for the overlay itself and the watched process, if any.
+    sampledPids.assign(1, getpid());
+    if (watchedProcessMonitor.getStats().attached) {
+        sampledPids.push_back(watchedProcessMonitor.getStats().pid);
+    }
+    processMemorySampler.setPids(sampledPids);
+    processMemorySampler.update();
+    if (spikeCaptureEnabled) {
+        spikeCaptureMonitor.update(metrics);
+    }
+    if (kernelEventsEnabled) {
+        kernelEventMonitor.update();
+    }
+    coreRate.observe({metrics[MetricId::CpuUsage] / 10.0,
+                      (metrics[MetricId::NetDown] + metrics[MetricId::NetUp]) / (1024.0 * 1024.0),
+                      metrics[MetricId::MemoryUsed] / (256.0 * 1024.0)});
     lastUpdateTime = std::chrono::steady_clock::now();
 }
+
+void SystemMonitor::snapSampling() {
+    collectorPool.snapAll();
+    coreRate.snap();
+}
+
+std::chrono::steady_clock::time_point SystemMonitor::getNextUpdate() const {
+    return std::min(coreRate.getNextDue(), collectorPool.nextDue());
+}
+
+void SystemMonitor::setSamplingBounds(int minMs, int maxMs) {
+    if (minMs == samplingMinMs && maxMs == samplingMaxMs) {
+        return;
+    }
+    samplingMinMs = minMs;
+    samplingMaxMs = maxMs;
+    coreRate.setBounds(minMs, maxMs);
+    collectorPool.setIntervalBounds(minMs, maxMs);
+}
@@ -3,8 +3,29 @@
 
 #include <string>
 #include <vector>
-#include <map>
 #include <chrono>
+#include "ProcFile.h"
+#include "MetricRegistry.h"
+#include "InterruptMonitor.h"
+#include "PerfCounterMonitor.h"
+#include "RunqueueLatencyMonitor.h"
+#include "NumaMonitor.h"
+#include "CompressedMemoryMonitor.h"
+#include "TcpMonitor.h"
+#include "PacketDropMonitor.h"
+#include "ProbeEngine.h"
+#include "GpuBackend.h"
+#include "GpuProcessMonitor.h"
+#include "WatchedProcessMonitor.h"
+#include "ProcessMemorySampler.h"
+#include "SpikeCaptureMonitor.h"
+#include "BurstCaptureMonitor.h"
+#include "CgroupCpuMonitor.h"
+#include "KernelEventMonitor.h"
+#include "CustomMetricMonitor.h"
+#include "CollectorPool.h"
+#include "AdaptiveInterval.h"
+#include "PressureTrigger.h"
 
 struct CpuStats {
     long long user;
@@ -19,60 +40,164 @@ struct CpuStats {
     long long guest_nice;
 };
 
-struct NetworkInterfaceStats {
-    long long rx_bytes;
-    long long tx_bytes;
-};
-
 class SystemMonitor {
 public:
     // This class handles all the system stat gathering. Where the evil black magic happens.
     SystemMonitor();
     void update();
 
+    // The single-value metrics, see MetricRegistry.h. Tables have their own getters below.
+    const MetricSnapshot& getMetrics() const { return metrics; }
+    double getMetric(MetricId id) const { return metrics[id]; }
+    // True when the collector behind a metric missed its deadline and the value is from an earlier round.
+    bool isStale(MetricId id) const {
+        CollectorSource source = metricDescriptor(id).source;
+        return source != CollectorSource::Count && collectorPool.isStale(static_cast<int>(source));
+    }
+
+    
+    void setCgroupCpuEnabled(bool enabled) { cgroupCpuEnabled = enabled; }
+    void setCgroupPath(const std::string& path) { cgroupPath = path; }
+    const CgroupCpuStats& getCgroupCpuStats() const { return cgroupCpuStats; }
+
+    
+    void setProbeTargets(const std::string& targetList, int intervalMs, int timeoutMs);
+    const std::vector<ProbeStats>& getProbeStats() const { return probeStats; }
+
+    
+    const std::vector<GpuCardStats>& getGpuCards() const { return gpuCards; }
+
+    
+    void setFps(double fps) { metrics[MetricId::Fps] = fps; }
+
+    
+    const ProcessMemorySamplerStats& getProcessMemoryStats() const { return processMemorySampler.getStats(); }
+    const ProcessMemoryStats* findProcessMemory(int pid) const { return processMemorySampler.find(pid); }
+
+    
+    void setInterruptStatsEnabled(bool enabled) { interruptStatsEnabled = enabled; }
+    const InterruptTable& getInterruptTable() const { return interruptTable; }
+    const InterruptTable& getSoftirqTable() const { return softirqTable; }
+
     
-    double getCpuUsage() const { return cpuUsage; }
-    int getCpuTemperature() const { return cpuTemperature; }
+    void setPerfCountersEnabled(bool enabled) { perfCountersEnabled = enabled; }
+    const PerfCounterStats& getPerfCounterStats() const { return perfCounterStats; }
 
     
-    long long getTotalMemory() const { return totalMemory; }
-    long long getUsedMemory() const { return usedMemory; }
-    long long getAvailableMemory() const { return availableMemory; }
+    void setRunqueueLatencyEnabled(bool enabled) { runqueueLatencyEnabled = enabled; }
+    const RunqueueLatencyStats& getRunqueueLatencyStats() const { return runqueueLatencyStats; }
 
     
-    double getDownloadSpeed() const { return downloadSpeed; } 
-    double getUploadSpeed() const { return uploadSpeed; }     
-    double getPingLatency() const { return pingLatency; }     
+    void setNumaStatsEnabled(bool enabled) { numaStatsEnabled = enabled; }
+    const NumaStats& getNumaStats() const { return numaStats; }
 
     
-    double getGpuUsage() const { return gpuUsage; }
-    long long getGpuMemoryUsed() const { return gpuMemoryUsed; }
-    long long getGpuMemoryTotal() const { return gpuMemoryTotal; }
-    int getGpuTemperature() const { return gpuTemperature; }
+    void setCompressedMemoryEnabled(bool enabled) { compressedMemoryEnabled = enabled; }
+    const CompressedMemoryStats& getCompressedMemoryStats() const { return compressedMemoryStats; }
+    long long getUncompressedMemoryDemand() const {
+        return CompressedMemoryMonitor::getUncompressedDemand(compressedMemoryStats,
+                                                              static_cast<long long>(metrics[MetricId::MemoryUsed]));
+    }
 
     
-    double getFps() const { return fps; }
-    void setFps(double newFps) { fps = newFps; }
+    void setTcpStatsEnabled(bool enabled) { tcpStatsEnabled = enabled; }
+    const TcpStats& getTcpStats() const { return tcpStats; }
 
     
-    double getProcessCpuUsage() const { return processCpuUsage; }
-    long long getProcessMemoryUsage() const { return processMemoryUsage; }
+    void setPacketDropStatsEnabled(bool enabled) { packetDropStatsEnabled = enabled; }
+    const PacketDropStats& getPacketDropStats() const { return packetDropStats; }
+
+    void setGpuProcessStatsEnabled(bool enabled) { gpuProcessStatsEnabled = enabled; }
+    const GpuProcessTable& getGpuProcessStats() const { return gpuProcessTable; }
+
+    void setKernelEventsEnabled(bool enabled);
+    const KernelEventStats& getKernelEventStats() const { return kernelEventMonitor.getStats(); }
+
+    void setSpikeCaptureEnabled(bool enabled) { spikeCaptureEnabled = enabled; }
+    void setSpikeThresholds(double cpuPercent, double memoryPressure, double ioPressure, int history) {
+        spikeCaptureMonitor.setThresholds(cpuPercent, memoryPressure, ioPressure);
+        spikeCaptureMonitor.setHistorySize(history);
+    }
+    const SpikeCaptureMonitor& getSpikeCapture() const { return spikeCaptureMonitor; }
+
+    // 100 Hz CPU/runqueue/PSI capture for a few seconds. onTrigger also starts one whenever a
+    // spike capture or a PSI trigger fires.
+    void setBurstCapture(int seconds, int cpu, bool onTrigger) {
+        burstCaptureMonitor.setDuration(seconds);
+        burstCaptureMonitor.setCpu(cpu);
+        burstOnTrigger = onTrigger;
+    }
+    bool startBurstCapture(const std::string& reason) { return burstCaptureMonitor.start(reason); }
+    const BurstCaptureMonitor& getBurstCapture() const { return burstCaptureMonitor; }
+
+    // "custom_metric" lines from the config; see CustomMetricSpec::parse.
+    void setCustomMetrics(const std::vector<std::string>& specs) { customMetricSpecs = specs; }
+    void setCustomMetricsEnabled(bool enabled) { customMetricsEnabled = enabled; }
+    const std::vector<CustomMetricStats>& getCustomMetrics() const { return customMetricStats; }
+
+    void watchProcess(int pid) { watchedProcessMonitor.watchPid(pid); }
+    void watchProcessName(const std::string& name) { watchedProcessMonitor.watchName(name); }
+    bool isWatchingProcess() const { return watchedProcessMonitor.isWatching(); }
+    const WatchedProcessStats& getWatchedProcessStats() const { return watchedProcessMonitor.getStats(); }
+    // Readable once the watched process exits; changes on every attach. -1 when not attached.
+    int getWatchedPidFd() const { return watchedProcessMonitor.getPidFd(); }
+
+    // Sources sample between minMs and maxMs depending on how much their values move; update()
+    // only does work once getNextUpdate() has passed, so callers can sleep until then.
+    void setSamplingBounds(int minMs, int maxMs);
+    void snapSampling(); // everything due on the next update(), at the fastest rate
+    std::chrono::steady_clock::time_point getNextUpdate() const;
+    int getCoreIntervalMs() const { return coreRate.getIntervalMs(); }
+    int getPressureTriggerCount() const { return pressureTrigger.getFireCount(); }
+    bool hasPressureTriggers() const { return pressureTrigger.isAvailable(); }
+    // For a caller that waits on the PSI fds itself; reporting a fire snaps sampling back to the
+    // fast rate on the next update().
+    const std::vector<int>& getPressureFds() const { return pressureTrigger.getFds(); }
+    void notifyPressure() { pressureTrigger.notify(); }
+    // eventfd written from the kernel event thread as soon as something is logged, and when a burst
+    // capture completes, so the caller can update() right away instead of at the next interval.
+    void setNotifyFd(int fd) {
+        kernelEventMonitor.setNotifyFd(fd);
+        burstCaptureMonitor.setNotifyFd(fd);
+    }
+    // Readable when a pool source finishes after update() stopped waiting for it (a slow
+    // nvidia-smi, say); publishCollected() then copies its results out. True if anything changed.
+    int getCollectedFd() const { return collectorPool.getReadyFd(); }
+    bool publishCollected() { return collectorPool.publishFinished(); }
+
+    // Heap allocations made on the caller's thread by the last update(); only counted in
+    // STATSBY_ALLOC_GUARD builds. Collectors on the pool report theirs in CollectorStatus.
+    long long getUpdateAllocations() const { return updateAllocations.getLast(); }
+
+    // Per-source timings from the collector pool; a stale source is showing values from an earlier round.
+    const std::vector<CollectorStatus>& getCollectorStatus() const { return collectorPool.getStatus(); }
+    bool isStale(CollectorSource source) const { return collectorPool.isStale(static_cast<int>(source)); }
 
 private:
+    // Written by the update functions below and by collector publish steps, so it only ever
+    // changes on the caller's thread.
+    MetricSnapshot metrics;
+
     
     CpuStats prevCpuStats;
-    double cpuUsage;
-    int cpuTemperature;
+    long long cpuTicksElapsed; // jiffies across all CPUs over the last updateCpuStats interval
+    ProcFile statFile;
+    CgroupCpuMonitor cgroupCpuMonitor;
+    CgroupCpuStats cgroupCpuStats;
+    std::string cgroupPath;
+    bool cgroupCpuEnabled;
+    int collectedCpuTemperature; // written on a pool worker, copied into metrics when published
+    ProcFile temperatureFile;
     void updateCpuStats();
     void updateCpuTemperature();
-    CpuStats parseCpuStats(const std::string& line);
+    CpuStats parseCpuStats(const char* line);
 
     
     long long prevProcessCpuUserTime;
     long long prevProcessCpuKernelTime;
     long long prevProcessCpuTotalTime;
-    double processCpuUsage;
-    long long processMemoryUsage; 
+    ProcFile selfStatFile;
+    ProcFile selfStatusFile;
     void updateProcessCpuStats();
     void updateProcessMemoryStats();
     long getSystemUptime();
@@ -80,33 +205,108 @@ private:
     long getClockTicksPerSecond();
 
     
-    long long totalMemory;
-    long long usedMemory;
-    long long availableMemory;
+    ProcFile meminfoFile;
     void updateMemoryStats();
 
     
-    std::map<std::string, NetworkInterfaceStats> prevNetworkStats;
-    double downloadSpeed;
-    double uploadSpeed;
-    double pingLatency;
+    ProcFile netDevFile;
+    long long prevRxBytes;
+    long long prevTxBytes;
+    ProbeEngine probeEngine;
+    std::vector<ProbeStats> probeStats;
     void updateNetworkStats();
     void updatePingStats();
 
     
-    double gpuUsage;
-    long long gpuMemoryUsed;
-    long long gpuMemoryTotal;
-    int gpuTemperature;
+    std::vector<std::unique_ptr<GpuBackend>> gpuBackends;
+    std::vector<GpuCardStats> gpuCards;
     void updateGpuStats();
+    void publishGpuStats();
+
+    
+    InterruptMonitor interruptMonitor;
+    InterruptTable interruptTable;
+    InterruptTable softirqTable;
+    bool interruptStatsEnabled;
+
+    
+    PerfCounterMonitor perfCounterMonitor;
+    PerfCounterStats perfCounterStats;
+    bool perfCountersEnabled;
+
+    
+    RunqueueLatencyMonitor runqueueLatencyMonitor;
+    RunqueueLatencyStats runqueueLatencyStats;
+    bool runqueueLatencyEnabled;
+
+    
+    NumaMonitor numaMonitor;
+    NumaStats numaStats;
+    bool numaStatsEnabled;
+
+    
+    CompressedMemoryMonitor compressedMemoryMonitor;
+    CompressedMemoryStats compressedMemoryStats;
+    bool compressedMemoryEnabled;
+
+    
+    TcpMonitor tcpMonitor;
+    TcpStats tcpStats;
+    bool tcpStatsEnabled;
+
+    
+    PacketDropMonitor packetDropMonitor;
+    PacketDropStats packetDropStats;
+    bool packetDropStatsEnabled;
+
+    
+    GpuProcessMonitor gpuProcessMonitor;
+    GpuProcessTable gpuProcessTable;
+    bool gpuProcessStatsEnabled;
+
+    
+    WatchedProcessMonitor watchedProcessMonitor;
+
+    
+    CustomMetricMonitor customMetricMonitor;
+    std::vector<CustomMetricStats> customMetricStats;
+    std::vector<std::string> customMetricSpecs;
+    bool customMetricsEnabled;
+
+    
+    SpikeCaptureMonitor spikeCaptureMonitor;
+    bool spikeCaptureEnabled;
+
+    
+    BurstCaptureMonitor burstCaptureMonitor;
+    bool burstOnTrigger;
+
+    
+    KernelEventMonitor kernelEventMonitor;
+    bool kernelEventsEnabled;
+
+    
+    ProcessMemorySampler processMemorySampler;
+    std::vector<int> sampledPids;
 
     
     std::chrono::steady_clock::time_point lastUpdateTime;
-    std::chrono::steady_clock::time_point lastPingUpdateTime;
-    std::chrono::steady_clock::time_point lastGpuUpdateTime;
 
     
-    double fps;
+    // CPU, memory, network and everything else updated inline share one adaptive interval.
+    AdaptiveInterval coreRate;
+    PressureTrigger pressureTrigger;
+    int seenSpikeTriggers;
+    int samplingMinMs;
+    int samplingMaxMs;
+    AllocGuard updateAllocations{"SystemMonitor::update"};
+    void runUpdate();
+
+    
+    // Declared last so its workers are joined before any collector they use is destroyed.
+    CollectorPool collectorPool;
+    void addCollector(CollectorSource source, const char* name, int deadlineMs, std::function<void()> collect,
+                      std::function<void()> publish, std::function<double()> signal);
 };
 
 #endif 
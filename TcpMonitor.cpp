@@ -0,0 +1,192 @@
+#include "TcpMonitor.h"
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// /proc/net/snmp and /proc/net/netstat come as line pairs: "Tcp: Name1 Name2 ..." then "Tcp: 1 2 ...".
+size_t parseHeaderValueTable(std::string_view text, std::string_view prefix, const KeyField* fields, size_t count) {
+    size_t header = 0;
+    while (header < text.size()) {
+        if (text.compare(header, prefix.size(), prefix) == 0) break;
+        size_t next = text.find('\n', header);
+        if (next == std::string_view::npos) return 0;
+        header = next + 1;
+    }
+    size_t headerEnd = text.find('\n', header);
+    if (headerEnd == std::string_view::npos) return 0;
+    size_t values = headerEnd + 1;
+    if (text.compare(values, prefix.size(), prefix) != 0) return 0;
+    size_t valuesEnd = text.find('\n', values);
+    if (valuesEnd == std::string_view::npos) valuesEnd = text.size();
+
+    size_t found = 0;
+    size_t n = header + prefix.size();
+    size_t v = values + prefix.size();
+    while (n < headerEnd && v < valuesEnd) {
+        while (n < headerEnd && text[n] == ' ') ++n;
+        while (v < valuesEnd && text[v] == ' ') ++v;
+        size_t nameEnd = text.find_first_of(" \n", n);
+        if (nameEnd == std::string_view::npos || nameEnd > headerEnd) nameEnd = headerEnd;
+        std::string_view name = text.substr(n, nameEnd - n);
+
+        bool negative = v < valuesEnd && text[v] == '-';
+        if (negative) ++v;
+        long long value = 0;
+        while (v < valuesEnd && text[v] >= '0' && text[v] <= '9') {
+            value = value * 10 + (text[v] - '0');
+            ++v;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (name == fields[i].key) {
+                *fields[i].value = negative ? -value : value;
+                ++found;
+                break;
+            }
+        }
+        n = nameEnd;
+    }
+    return found;
+}
+
+} // namespace
+
+TcpMonitor::TcpMonitor() : diagSocket(-1), hasPrev(false) {
+    snmpFile.open("/proc/net/snmp");
+    netstatFile.open("/proc/net/netstat");
+    diagSocket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    diagBuffer.resize(64 * 1024);
+    lastSample = std::chrono::steady_clock::now();
+}
+
+TcpMonitor::~TcpMonitor() {
+    if (diagSocket >= 0) {
+        close(diagSocket);
+    }
+}
+
+const char* TcpMonitor::stateName(int state) {
+    static const char* names[TcpStats::kStates] = {
+        "?", "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2", "TIME_WAIT",
+        "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING", "NEW_SYN_RECV",
+    };
+    return state >= 0 && state < TcpStats::kStates ? names[state] : "?";
+}
+
+void TcpMonitor::updateCounters() {
+    long long current[kCounters] = {};
+    const KeyField tcpFields[] = {
+        {"ActiveOpens", &current[0]},
+        {"PassiveOpens", &current[1]},
+        {"AttemptFails", &current[2]},
+        {"EstabResets", &current[3]},
+        {"InSegs", &current[4]},
+        {"OutSegs", &current[5]},
+        {"RetransSegs", &current[6]},
+        {"InErrs", &current[7]},
+        {"OutRsts", &current[8]},
+    };
+    const KeyField extFields[] = {
+        {"ListenOverflows", &current[9]},
+        {"ListenDrops", &current[10]},
+        {"TCPTimeouts", &current[11]},
+    };
+    bool ok = snmpFile.read() && parseHeaderValueTable(snmpFile.view(), "Tcp:", tcpFields, 9) > 0;
+    if (netstatFile.read()) {
+        parseHeaderValueTable(netstatFile.view(), "TcpExt:", extFields, 3);
+    }
+    if (!ok) {
+        hasPrev = false;
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastSample;
+    lastSample = now;
+    if (hasPrev && elapsed.count() > 0) {
+        double rates[kCounters];
+        for (int i = 0; i < kCounters; ++i) {
+            rates[i] = std::max(0LL, current[i] - counters[i]) / elapsed.count();
+        }
+        stats.activeOpensRate = rates[0];
+        stats.passiveOpensRate = rates[1];
+        stats.attemptFailsRate = rates[2];
+        stats.estabResetsRate = rates[3];
+        stats.inSegsRate = rates[4];
+        stats.outSegsRate = rates[5];
+        stats.retransSegsRate = rates[6];
+        stats.inErrsRate = rates[7];
+        stats.outRstsRate = rates[8];
+        stats.listenOverflowsRate = rates[9];
+        stats.listenDropsRate = rates[10];
+        stats.timeoutsRate = rates[11];
+        stats.retransPercent = stats.outSegsRate > 0 ? stats.retransSegsRate / stats.outSegsRate * 100.0 : 0.0;
+    }
+    std::copy(current, current + kCounters, counters);
+    hasPrev = true;
+}
+
+bool TcpMonitor::dumpFamily(int family) {
+    struct {
+        nlmsghdr header;
+        inet_diag_req_v2 request;
+    } message;
+    memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.request.sdiag_family = family;
+    message.request.sdiag_protocol = IPPROTO_TCP;
+    message.request.idiag_states = ~0U; // every state, no extensions, so each reply is just the fixed header
+
+    sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(diagSocket, &message, sizeof(message), 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    while (true) {
+        ssize_t received = recv(diagSocket, diagBuffer.data(), diagBuffer.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        int length = static_cast<int>(received);
+        for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(diagBuffer.data()); NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                return false;
+            }
+            const inet_diag_msg* socketInfo = static_cast<const inet_diag_msg*>(NLMSG_DATA(header));
+            if (socketInfo->idiag_state < TcpStats::kStates) {
+                stats.sockets[socketInfo->idiag_state]++;
+            }
+            stats.totalSockets++;
+        }
+    }
+}
+
+void TcpMonitor::updateSocketStates() {
+    std::fill(std::begin(stats.sockets), std::end(stats.sockets), 0);
+    stats.totalSockets = 0;
+    stats.socketCountsAvailable = diagSocket >= 0 && dumpFamily(AF_INET);
+    if (stats.socketCountsAvailable) {
+        dumpFamily(AF_INET6); // fine to fail on kernels built without IPv6
+    }
+}
+
+void TcpMonitor::update() {
+    updateCounters();
+    updateSocketStates();
+}
@@ -0,0 +1,62 @@
+#ifndef TCP_MONITOR_H
+#define TCP_MONITOR_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <vector>
+
+struct TcpStats {
+    // Per-second rates from /proc/net/snmp (Tcp:) and /proc/net/netstat (TcpExt:).
+    double activeOpensRate = 0.0;
+    double passiveOpensRate = 0.0;
+    double attemptFailsRate = 0.0;
+    double estabResetsRate = 0.0;
+    double inSegsRate = 0.0;
+    double outSegsRate = 0.0;
+    double retransSegsRate = 0.0;
+    double inErrsRate = 0.0;
+    double outRstsRate = 0.0;
+    double listenOverflowsRate = 0.0;
+    double listenDropsRate = 0.0;
+    double timeoutsRate = 0.0;
+    double retransPercent = 0.0; // retransmitted share of sent segments
+
+    // Socket counts by TCP state (indexed by the kernel's TCP_* state numbers), IPv4 + IPv6.
+    static constexpr int kStates = 13;
+    bool socketCountsAvailable = false;
+    int sockets[kStates] = {};
+    int totalSockets = 0;
+};
+
+class TcpMonitor {
+public:
+    // TCP stack health. Socket states come from one NETLINK_SOCK_DIAG dump per family instead of
+    // formatting and parsing /proc/net/tcp text.
+    TcpMonitor();
+    ~TcpMonitor();
+    TcpMonitor(const TcpMonitor&) = delete;
+    TcpMonitor& operator=(const TcpMonitor&) = delete;
+
+    void update();
+    const TcpStats& getStats() const { return stats; }
+
+    static const char* stateName(int state);
+
+private:
+    static constexpr int kCounters = 12;
+
+    ProcFile snmpFile;
+    ProcFile netstatFile;
+    int diagSocket;
+    std::vector<char> diagBuffer;
+    long long counters[kCounters] = {};
+    bool hasPrev;
+    std::chrono::steady_clock::time_point lastSample;
+    TcpStats stats;
+
+    void updateCounters();
+    void updateSocketStates();
+    bool dumpFamily(int family);
+};
+
+#endif
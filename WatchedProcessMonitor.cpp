@@ -0,0 +1,266 @@
+#include "WatchedProcessMonitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kCommLength = 15; // TASK_COMM_LEN - 1
+
+bool isNumeric(const char* name) {
+    if (*name == '\0') return false;
+    for (const char* p = name; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+    }
+    return true;
+}
+
+std::string readComm(const std::string& path) {
+    ProcFile comm(path);
+    if (!comm.read()) {
+        return "";
+    }
+    return std::string(comm.data(), strcspn(comm.data(), "\n"));
+}
+
+double counterRate(unsigned long long current, unsigned long long previous, double elapsed) {
+    return current >= previous && elapsed > 0 ? (current - previous) / elapsed : 0.0;
+}
+
+} // namespace
+
+WatchedProcessMonitor::WatchedProcessMonitor(const std::string& procRoot)
+    : procRoot(procRoot), watching(false), pidFd(-1), attachCount(0), prevCpuTicks(0), hasPrev(false) {
+    ticksPerSecond = sysconf(_SC_CLK_TCK);
+}
+
+WatchedProcessMonitor::~WatchedProcessMonitor() {
+    if (pidFd >= 0) {
+        close(pidFd);
+    }
+}
+
+void WatchedProcessMonitor::watchPid(int pid) {
+    targetName.clear();
+    watching = true;
+    if (!attach(pid)) {
+        detach("pid " + std::to_string(pid) + " not found");
+    }
+}
+
+void WatchedProcessMonitor::watchName(const std::string& name) {
+    targetName = name;
+    watching = true;
+    detach("waiting for " + name);
+    int pid = findByName();
+    if (pid > 0) {
+        attach(pid);
+    }
+}
+
+bool WatchedProcessMonitor::attach(int pid) {
+    std::string pidPath = procRoot + "/" + std::to_string(pid);
+    if (!statFile.open(pidPath + "/stat")) {
+        return false;
+    }
+    statusFile.open(pidPath + "/status");
+    taskPath = pidPath + "/task";
+    threads.clear();
+    hasPrev = false;
+
+    // Without a pidfd (pre-5.3 kernels) exit is detected by the /proc files going away instead.
+    if (pidFd >= 0) {
+        close(pidFd);
+    }
+#ifdef SYS_pidfd_open
+    pidFd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    pidFd = -1;
+#endif
+
+    stats = WatchedProcessStats();
+    stats.attached = true;
+    stats.pid = pid;
+    stats.name = readComm(pidPath + "/comm");
+    stats.attachCount = ++attachCount;
+    lastSample = std::chrono::steady_clock::now();
+    return true;
+}
+
+void WatchedProcessMonitor::detach(const std::string& reason) {
+    if (pidFd >= 0) {
+        close(pidFd);
+        pidFd = -1;
+    }
+    statFile.close();
+    statusFile.close();
+    threads.clear();
+
+    std::string name = stats.name;
+    stats = WatchedProcessStats();
+    stats.status = reason;
+    stats.attachCount = attachCount;
+    stats.name = targetName.empty() ? name : targetName;
+}
+
+bool WatchedProcessMonitor::hasExited() const {
+    if (pidFd >= 0) {
+        pollfd pfd = {pidFd, POLLIN, 0};
+        return poll(&pfd, 1, 0) > 0;
+    }
+    return kill(stats.pid, 0) != 0 && errno == ESRCH;
+}
+
+int WatchedProcessMonitor::findByName() const {
+    // comm is cut at 15 characters, so longer names are checked against argv[0] as well.
+    DIR* dir = opendir(procRoot.c_str());
+    if (!dir) {
+        return 0;
+    }
+    std::string shortName = targetName.substr(0, kCommLength);
+    int self = getpid();
+    int found = 0;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (!isNumeric(ent->d_name)) continue;
+        int pid = atoi(ent->d_name);
+        if (pid == self || (found && pid > found)) continue;
+        std::string pidPath = procRoot + "/" + ent->d_name;
+        // stat has both the comm and the state, so exited-but-unreaped zombies can be skipped.
+        ProcFile stat(pidPath + "/stat");
+        if (!stat.read()) continue;
+        const char* nameStart = strchr(stat.data(), '(');
+        const char* nameEnd = strrchr(stat.data(), ')');
+        if (!nameStart || !nameEnd || nameEnd < nameStart || nameEnd[1] == '\0' || nameEnd[2] == 'Z') continue;
+        if (std::string(nameStart + 1, nameEnd) != shortName) continue;
+        if (targetName.size() > kCommLength) {
+            ProcFile cmdline(pidPath + "/cmdline");
+            if (!cmdline.read()) continue;
+            const char* argv0 = cmdline.data();
+            const char* slash = strrchr(argv0, '/');
+            if (targetName != (slash ? slash + 1 : argv0)) continue;
+        }
+        found = pid; // lowest pid wins, which is usually the parent of a multi-process app
+    }
+    closedir(dir);
+    return found;
+}
+
+void WatchedProcessMonitor::updateThreads(double elapsed) {
+    tids.clear();
+    DIR* dir = opendir(taskPath.c_str());
+    if (dir) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            if (isNumeric(ent->d_name)) {
+                tids.push_back(atoi(ent->d_name));
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(tids.begin(), tids.end());
+
+    // Keep the open schedstat files of threads that are still around.
+    std::vector<Thread>& current = nextThreads;
+    current.clear();
+    auto existing = threads.begin();
+    for (int tid : tids) {
+        while (existing != threads.end() && existing->tid < tid) ++existing;
+        if (existing != threads.end() && existing->tid == tid) {
+            current.push_back(std::move(*existing));
+            continue;
+        }
+        Thread thread;
+        thread.tid = tid;
+        thread.name = readComm(taskPath + "/" + std::to_string(tid) + "/comm");
+        thread.schedstat.open(taskPath + "/" + std::to_string(tid) + "/schedstat");
+        current.push_back(std::move(thread));
+    }
+    threads.swap(current);
+
+    stats.threads.resize(threads.size());
+    stats.switchesPerSec = 0.0;
+    stats.runDelayMs = 0.0;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        Thread& thread = threads[i];
+        WatchedThreadStats& out = stats.threads[i];
+        out = WatchedThreadStats();
+        out.tid = thread.tid;
+        out.name = thread.name;
+        if (!thread.schedstat.read()) continue;
+
+        char* next = nullptr;
+        unsigned long long run = strtoull(thread.schedstat.data(), &next, 10);
+        unsigned long long wait = strtoull(next, &next, 10);
+        unsigned long long slices = strtoull(next, nullptr, 10);
+        if (thread.hasPrev) {
+            out.cpuPercent = counterRate(run, thread.prevRun, elapsed) / 1e7;  // ns/s -> % of a core
+            out.runDelayMs = counterRate(wait, thread.prevWait, elapsed) / 1e6;
+            out.switchesPerSec = counterRate(slices, thread.prevSlices, elapsed);
+            stats.switchesPerSec += out.switchesPerSec;
+            stats.runDelayMs += out.runDelayMs;
+        }
+        thread.prevRun = run;
+        thread.prevWait = wait;
+        thread.prevSlices = slices;
+        thread.hasPrev = true;
+    }
+    std::sort(stats.threads.begin(), stats.threads.end(), [](const WatchedThreadStats& a, const WatchedThreadStats& b) {
+        return a.cpuPercent > b.cpuPercent;
+    });
+}
+
+void WatchedProcessMonitor::update() {
+    if (!watching) {
+        return;
+    }
+    if (stats.attached && (hasExited() || !statFile.read())) {
+        detach(targetName.empty() ? "pid " + std::to_string(stats.pid) + " exited" : "waiting for " + targetName);
+    }
+    if (!stats.attached) {
+        int pid = targetName.empty() ? 0 : findByName();
+        if (pid <= 0 || !attach(pid) || !statFile.read()) {
+            return;
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsedSeconds = now - lastSample;
+    double elapsed = elapsedSeconds.count();
+    lastSample = now;
+
+    // utime and stime are the 12th and 13th fields after the ")" that ends the command name.
+    const char* p = strrchr(statFile.data(), ')');
+    unsigned long long cpuTicks = 0;
+    if (p) {
+        ++p;
+        for (int field = 0; field < 11 && *p; ++field) {
+            p = strchr(p + 1, ' ');
+            if (!p) break;
+        }
+        if (p) {
+            char* next = nullptr;
+            unsigned long long utime = strtoull(p, &next, 10);
+            cpuTicks = utime + strtoull(next, nullptr, 10);
+        }
+    }
+
+    long long rss = 0;
+    KeyField statusFields[] = {{"VmRSS", &rss}};
+    if (statusFile.read()) parseKeyTable(statusFile.view(), statusFields, 1);
+
+    stats.rssKb = rss;
+    if (hasPrev && elapsed > 0) {
+        stats.cpuPercent = counterRate(cpuTicks, prevCpuTicks, elapsed) * 100.0 / ticksPerSecond;
+    }
+    prevCpuTicks = cpuTicks;
+    hasPrev = true;
+
+    updateThreads(elapsed);
+}
@@ -0,0 +1,83 @@
+#ifndef WATCHED_PROCESS_MONITOR_H
+#define WATCHED_PROCESS_MONITOR_H
+
+#include "ProcFile.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct WatchedThreadStats {
+    int tid = 0;
+    std::string name;
+    double cpuPercent = 0.0;      // 100 = one core
+    double runDelayMs = 0.0;      // ms per second spent runnable but waiting for a CPU
+    double switchesPerSec = 0.0;  // times scheduled onto a CPU
+};
+
+struct WatchedProcessStats {
+    bool attached = false;
+    int pid = 0;
+    std::string name;
+    std::string status;           // why we are not attached, when we are not
+    int attachCount = 0;          // above 1 when a restarted instance was picked up by name
+    double cpuPercent = 0.0;      // whole process, 100 = one core
+    long long rssKb = 0;          // PSS/USS and I/O come from ProcessMemorySampler
+    double switchesPerSec = 0.0;
+    double runDelayMs = 0.0;      // summed over threads
+    std::vector<WatchedThreadStats> threads; // busiest first
+};
+
+class WatchedProcessMonitor {
+public:
+    // Follows one target process and its threads. Exit is noticed through a pidfd; when watching by
+    // name, the next process with that name is picked up automatically.
+    explicit WatchedProcessMonitor(const std::string& procRoot = "/proc");
+    ~WatchedProcessMonitor();
+    WatchedProcessMonitor(const WatchedProcessMonitor&) = delete;
+    WatchedProcessMonitor& operator=(const WatchedProcessMonitor&) = delete;
+
+    void watchPid(int pid);
+    void watchName(const std::string& name);
+    bool isWatching() const { return watching; }
+    int getPidFd() const { return pidFd; } // becomes readable when the target exits
+
+    void update();
+    const WatchedProcessStats& getStats() const { return stats; }
+
+private:
+    struct Thread {
+        int tid = 0;
+        std::string name;
+        ProcFile schedstat;   // run ns, wait ns, timeslices
+        unsigned long long prevRun = 0;
+        unsigned long long prevWait = 0;
+        unsigned long long prevSlices = 0;
+        bool hasPrev = false;
+    };
+
+    std::string procRoot;
+    std::string targetName;   // empty when watching a fixed pid
+    bool watching;
+    int pidFd;
+    int attachCount;
+    ProcFile statFile;
+    ProcFile statusFile;
+    std::vector<Thread> threads; // sorted by tid
+    // Reused by updateThreads so a steady thread list costs no allocations.
+    std::string taskPath;        // <procRoot>/<pid>/task, set on attach
+    std::vector<int> tids;
+    std::vector<Thread> nextThreads;
+    unsigned long long prevCpuTicks;
+    bool hasPrev;
+    long ticksPerSecond;
+    std::chrono::steady_clock::time_point lastSample;
+    WatchedProcessStats stats;
+
+    bool attach(int pid);
+    void detach(const std::string& reason);
+    bool hasExited() const;
+    int findByName() const;
+    void updateThreads(double elapsed);
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "ProcFile.h"
+#include "ProcFileBatch.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reads the same set of sysfs counters with ProcFileBatch, once per tick, with io_uring and with
+// plain pread, and prints syscalls and CPU time per tick for each.
+// Usage: proc_file_batch_bench [files] [ticks]. The files are NIC statistics, cpufreq, hwmon,
+// thermal and powercap attributes from this machine, repeated until there are enough of them.
+
+namespace {
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+void addMatching(std::vector<std::string>& paths, const char* directory, const char* inside,
+                 bool (*wanted)(const std::string& name)) {
+    std::error_code error;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory, error)) {
+        fs::path dir = entry.path() / inside;
+        std::error_code innerError;
+        for (const fs::directory_entry& file : fs::directory_iterator(dir, innerError)) {
+            if (wanted(file.path().filename().string())) {
+                paths.push_back(file.path().string());
+            }
+        }
+    }
+}
+
+std::vector<std::string> findCounters() {
+    std::vector<std::string> paths;
+    addMatching(paths, "/sys/class/net", "statistics", [](const std::string&) { return true; });
+    addMatching(paths, "/sys/devices/system/cpu", "cpufreq",
+                [](const std::string& name) { return name == "scaling_cur_freq"; });
+    addMatching(paths, "/sys/class/hwmon", "",
+                [](const std::string& name) { return name.find("_input") != std::string::npos; });
+    addMatching(paths, "/sys/class/thermal", "", [](const std::string& name) { return name == "temp"; });
+    addMatching(paths, "/sys/class/powercap", "", [](const std::string& name) { return name == "energy_uj"; });
+    return paths;
+}
+
+double cpuSeconds() {
+    // RUSAGE_SELF covers every thread, io_uring's io-wq workers included.
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct Result {
+    bool usedUring = false;
+    double syscallsPerTick = 0.0;
+    double cpuUsPerTick = 0.0;
+    double wallUsPerTick = 0.0;
+};
+
+Result run(std::vector<std::unique_ptr<ProcFile>>& files, bool uring, int ticks) {
+    ProcFileBatch::setUringAllowed(uring);
+    ProcFileBatch batch;
+    for (auto& file : files) batch.add(*file);
+    batch.read(); // sets the ring up, outside the timing
+
+    Result result;
+    result.usedUring = batch.isUsingUring();
+    long long syscalls = ProcFileBatch::getSyscalls();
+    double cpu = cpuSeconds();
+    auto start = Clock::now();
+    for (int i = 0; i < ticks; ++i) batch.read();
+    result.wallUsPerTick = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / ticks;
+    result.cpuUsPerTick = (cpuSeconds() - cpu) * 1e6 / ticks;
+    result.syscallsPerTick = static_cast<double>(ProcFileBatch::getSyscalls() - syscalls) / ticks;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int fileCount = argc > 1 ? atoi(argv[1]) : 200;
+    int ticks = argc > 2 ? atoi(argv[2]) : 2000;
+    if (fileCount <= 0) fileCount = 200;
+    if (ticks <= 0) ticks = 2000;
+
+    std::vector<std::string> found = findCounters();
+    if (found.empty()) {
+        fprintf(stderr, "No sysfs counters found to read\n");
+        return 1;
+    }
+    std::vector<std::unique_ptr<ProcFile>> files;
+    for (int i = 0; i < fileCount; ++i) {
+        auto file = std::make_unique<ProcFile>();
+        if (file->open(found[i % found.size()])) {
+            files.push_back(std::move(file));
+        }
+    }
+    printf("%zu files (%zu distinct), %d ticks\n", files.size(), std::min(found.size(), files.size()), ticks);
+
+    Result pread = run(files, false, ticks);
+    Result uring = run(files, true, ticks);
+    printf("%-10s %14s %14s %14s\n", "backend", "syscalls/tick", "cpu us/tick", "wall us/tick");
+    printf("%-10s %14.1f %14.1f %14.1f\n", "pread", pread.syscallsPerTick, pread.cpuUsPerTick, pread.wallUsPerTick);
+    if (uring.usedUring) {
+        printf("%-10s %14.1f %14.1f %14.1f\n", "io_uring", uring.syscallsPerTick, uring.cpuUsPerTick,
+               uring.wallUsPerTick);
+    } else {
+        printf("%-10s unavailable here (kernel, io_uring_disabled or seccomp), fell back to pread\n", "io_uring");
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "InterruptMonitor.h"
+#include "ProcTableScanner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Times ProcTableScanner on recorded 256-CPU /proc/interrupts and /proc/softirqs, once per Isa,
+// against the scalar byte loop. Usage: proc_table_bench [fixture dir] [iterations]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Fixture {
+    std::string path;
+    std::string text; // with ProcFile::kPadding zero bytes after it, like ProcFile's buffer
+    size_t size = 0;
+};
+
+bool load(Fixture& fixture, const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "Can't read %s\n", path.c_str());
+        return false;
+    }
+    fixture.path = path;
+    fixture.text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    fixture.size = fixture.text.size();
+    fixture.text.append(ProcFile::kPadding, '\0');
+    return true;
+}
+
+// Same row walk as InterruptMonitor::parseTable, minus the bookkeeping. Returns a checksum so the
+// Isas can be checked against each other and the loop can't be optimized away.
+unsigned long long scanTable(const ProcTableScanner& scanner, const Fixture& fixture,
+                             std::vector<unsigned long long>& values) {
+    const char* p = fixture.text.data();
+    const char* end = p + fixture.size;
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!lineEnd) return 0;
+    size_t cpus = scanner.countTokens(p, lineEnd);
+    values.resize(cpus);
+    unsigned long long sum = cpus;
+    for (p = lineEnd + 1; p < end; p = lineEnd + 1) {
+        lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        const char* colon = static_cast<const char*>(memchr(p, ':', lineEnd - p));
+        if (!colon) continue;
+        const char* rest;
+        size_t parsed = scanner.parseRow(colon + 1, lineEnd, values.data(), cpus, &rest);
+        for (size_t i = 0; i < parsed; ++i) sum += values[i] * (i + 1);
+    }
+    return sum;
+}
+
+double perIterationUs(Clock::time_point start, int iterations) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : STATSBY_BENCH_FIXTURES;
+    int iterations = argc > 2 ? atoi(argv[2]) : 500;
+    if (iterations <= 0) iterations = 500;
+
+    Fixture fixtures[2];
+    if (!load(fixtures[0], dir + "/interrupts-256cpu.txt") || !load(fixtures[1], dir + "/softirqs-256cpu.txt")) {
+        return 1;
+    }
+
+    const ProcTableScanner::Isa isas[] = {ProcTableScanner::Isa::Scalar, ProcTableScanner::Isa::Sse2,
+                                          ProcTableScanner::Isa::Avx2};
+    unsigned long long expected[2] = {};
+    double scalarUs[2] = {};
+    bool mismatch = false;
+    std::vector<unsigned long long> values;
+
+    printf("%-8s %-24s %12s %10s %12s\n", "isa", "fixture", "scan us", "vs scalar", "update us");
+    for (ProcTableScanner::Isa isa : isas) {
+        ProcTableScanner scanner(isa);
+        if (scanner.getIsa() != isa) {
+            printf("%-8s skipped, not supported here\n", ProcTableScanner::isaName(isa));
+            continue;
+        }
+
+        // The whole collector too: file read, table bookkeeping and the rate matrix.
+        InterruptMonitor monitor(isa, fixtures[0].path, fixtures[1].path);
+        monitor.update();
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i) monitor.update();
+        double updateUs = perIterationUs(start, iterations);
+
+        for (int f = 0; f < 2; ++f) {
+            unsigned long long sum = scanTable(scanner, fixtures[f], values);
+            start = Clock::now();
+            for (int i = 0; i < iterations; ++i) sum = scanTable(scanner, fixtures[f], values);
+            double us = perIterationUs(start, iterations);
+
+            if (isa == ProcTableScanner::Isa::Scalar) {
+                expected[f] = sum;
+                scalarUs[f] = us;
+            } else if (sum != expected[f]) {
+                fprintf(stderr, "%s parsed %s differently from the scalar loop\n", ProcTableScanner::isaName(isa),
+                        fixtures[f].path.c_str());
+                mismatch = true;
+            }
+            const char* name = strrchr(fixtures[f].path.c_str(), '/');
+            printf("%-8s %-24s %12.1f %9.2fx", ProcTableScanner::isaName(isa), name ? name + 1 : fixtures[f].path.c_str(),
+                   us, scalarUs[f] > 0 && us > 0 ? scalarUs[f] / us : 0.0);
+            if (f == 0) {
+                printf(" %12.1f\n", updateUs);
+            } else {
+                printf("\n");
+            }
+        }
+
+        const InterruptTable& table = monitor.getInterrupts();
+        if (table.cpuCount() != 256) {
+            fprintf(stderr, "%s: expected 256 CPU columns, got %zu\n", ProcTableScanner::isaName(isa), table.cpuCount());
+            mismatch = true;
+        }
+    }
+    return mismatch ? 1 : 0;
+}
@@ -11,15 +11,24 @@
 #include <X11/keysym.h>
 #include <string.h>
 #endif
+#include "AllocGuard.h"
 #include "ConfigManager.h"
+#include "EventLoop.h"
+#include "MetricRegistry.h"
+#include "ProcFileBatch.h"
 #include "SystemMonitor.h"
-#include <atomic>
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <cfloat>
 #include <cmath>
-#include <mutex>
-#include <queue>
-#include <thread>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
 
+// First, so the signals it blocks for signalfd are also blocked in the collector
+// threads SystemMonitor starts.
+EventLoop eventLoop;
 SystemMonitor systemMonitor;
 AppConfig appConfig;
 ConfigManager configManager("config.ini");
@@ -31,6 +40,10 @@ float target_alpha = 1.0f;
 double fade_start_time = 0.0;
 const double fade_duration = 0.2;
 
+double wakeup_rate = 0.0; // epoll wakeups per second, for --debug
+double batch_file_rate = 0.0;    // files read through ProcFileBatch per second
+double batch_syscall_rate = 0.0; // and the syscalls that took
+
 float current_hue = 0.0f;
 const float hue_speed = 0.05f;
 
@@ -38,17 +51,6 @@ static void glfw_error_callback(int error, const char *description) {
   fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-struct HotKeyMsg {
-  int key;
-  int action;
-  int mods;
-};
-
-// Global KeyPress thread
-std::queue<HotKeyMsg> q; // here: queue of integers just to count calls
-std::mutex mtx;
-std::atomic<bool> done{false};
-
 void registerGlobalHotkey() {
   Display *x11Display = glfwGetX11Display();
   Window root = DefaultRootWindow(x11Display);
@@ -76,37 +78,474 @@ static void glfw_key_callback(GLFWwindow *window, int key, int scancode,
   }
 }
 
-static void pollGlobalHotkeys(GLFWwindow *window) {
-  Display *dpy = glfwGetX11Display();
+// Global F1 (toggle) and F2 (burst capture) on a second X connection, so they
+// work while another window has focus without GLFW's event handling eating the
+// root window's key presses.
+static void grabGlobalHotkey(Display *dpy) {
   Window root = DefaultRootWindow(dpy);
-  int kc = XKeysymToKeycode(dpy, XK_F1);
 
-  // Grab F1 without modifiers
+  // Grab without modifiers, with Caps Lock and Num Lock in any state
   unsigned mods[4] = {0, LockMask, Mod2Mask, LockMask | Mod2Mask};
-  for (auto m : mods)
-    XGrabKey(dpy, kc, m, root, True, GrabModeAsync, GrabModeAsync);
+  for (KeySym key : {XK_F1, XK_F2}) {
+    int kc = XKeysymToKeycode(dpy, key);
+    for (auto m : mods)
+      XGrabKey(dpy, kc, m, root, True, GrabModeAsync, GrabModeAsync);
+  }
   XSelectInput(dpy, root, KeyPressMask);
-  //   Display *x11Display = glfwGetX11Display();
-  while (!done.load()) {
-    while (XPending(dpy)) { // Check if any X11 events are waiting
-      XEvent event;
-      XNextEvent(dpy, &event);
-      if (event.type == KeyPress && XLookupKeysym(&event.xkey, 0) == XK_F1) {
-        printf("F1 detected (global, even when unfocused)");
-        // You could simulate a GLFW key callback call here:
-        // keyCallback(window, GLFW_KEY_F1, 0, GLFW_PRESS, 0);
-        // glfw_key_callback(window, GLFW_KEY_F1, 0, GLFW_PRESS, 0);
-        {
-          std::lock_guard<std::mutex> lock(mtx);
-          q.push({GLFW_KEY_F1, GLFW_PRESS, 0});
-        }
-        glfwPostEmptyEvent();
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  XFlush(dpy);
+}
+
+// Drains the hotkey connection and returns how many F1 presses it held; F2
+// presses are counted in bursts.
+static int takeGlobalHotkeys(Display *dpy, int &bursts) {
+  int presses = 0;
+  while (XPending(dpy)) {
+    XEvent event;
+    XNextEvent(dpy, &event);
+    if (event.type != KeyPress)
+      continue;
+    KeySym key = XLookupKeysym(&event.xkey, 0);
+    if (key == XK_F1)
+      presses++;
+    else if (key == XK_F2)
+      bursts++;
+  }
+  return presses;
+}
+
+// Settings read once rather than every frame, applied at startup and whenever
+// config.ini changes on disk.
+static void applyConfig(bool reload) {
+  AppConfig previous = appConfig;
+  // A reload that doesn't parse leaves everything as it was.
+  if (!configManager.loadConfig(appConfig) && reload)
+    return;
+  // Restarting the probes throws away their history, so only when they changed.
+  if (!reload || appConfig.probe_targets != previous.probe_targets ||
+      appConfig.probe_interval_ms != previous.probe_interval_ms ||
+      appConfig.probe_timeout_ms != previous.probe_timeout_ms)
+    systemMonitor.setProbeTargets(appConfig.probe_targets,
+                                  appConfig.probe_interval_ms,
+                                  appConfig.probe_timeout_ms);
+  systemMonitor.setCgroupPath(appConfig.cgroup_path);
+  systemMonitor.setCustomMetrics(appConfig.custom_metrics);
+}
+
+// Prints the total rate, busiest CPU and top few sources of one IRQ table.
+static void drawInterruptTable(const char *title, const InterruptTable &table,
+                               const ImVec4 &color) {
+  if (table.cpuCount() == 0)
+    return;
+
+  size_t busiestCpu = 0;
+  for (size_t c = 1; c < table.cpuCount(); ++c)
+    if (table.cpuRates[c] > table.cpuRates[busiestCpu])
+      busiestCpu = c;
+  ImGui::TextColored(color, "%s: %.0f/s (CPU%d %.0f/s, imbalance %.2fx)",
+                     title, table.totalRate, table.cpuIds[busiestCpu],
+                     table.cpuRates[busiestCpu], table.imbalance);
+
+  const int top_count = 3;
+  size_t top[top_count];
+  int found = 0;
+  for (size_t r = 0; r < table.names.size(); ++r) {
+    if (table.rowRates[r] <= 0.0)
+      continue;
+    int pos = found < top_count ? found++ : top_count;
+    while (pos > 0 && table.rowRates[top[pos - 1]] < table.rowRates[r]) {
+      if (pos < top_count)
+        top[pos] = top[pos - 1];
+      --pos;
+    }
+    if (pos < top_count)
+      top[pos] = r;
+  }
+  for (int i = 0; i < found; ++i) {
+    size_t r = top[i];
+    size_t hottest = 0;
+    for (size_t c = 1; c < table.cpuCount(); ++c)
+      if (table.rate(r, c) > table.rate(r, hottest))
+        hottest = c;
+    ImGui::TextColored(color, "  %s: %.0f/s, %.0f%% on CPU%d %s",
+                       table.names[r].c_str(), table.rowRates[r],
+                       table.rate(r, hottest) / table.rowRates[r] * 100.0,
+                       table.cpuIds[hottest], table.descriptions[r].c_str());
+  }
+}
+
+// Run-queue latency percentiles plus a log2 histogram of the used range.
+static void drawRunqueueLatency(const RunqueueLatencyStats &stats,
+                                const ImVec4 &color) {
+  if (!stats.available) {
+    ImGui::TextColored(color, "Runq Latency: %s", stats.status.c_str());
+    return;
+  }
+  ImGui::TextColored(color, "Runq Latency: p50 <%.0f us p99 <%.0f us (%.0f/s)",
+                     stats.p50Us, stats.p99Us, stats.wakeupsPerSec);
+  if (stats.worstCpu >= 0)
+    ImGui::TextColored(color, "  Worst CPU%d p99 <%.0f us", stats.worstCpu,
+                       stats.worstCpuP99Us);
+
+  float buckets[RunqueueLatencyStats::kSlots];
+  int used = 0;
+  for (int i = 0; i < RunqueueLatencyStats::kSlots; ++i) {
+    buckets[i] = static_cast<float>(stats.total[i]);
+    if (stats.total[i] > 0)
+      used = i + 1;
+  }
+  if (used > 0) {
+    char overlay[32];
+    snprintf(overlay, sizeof(overlay), "1us .. %lluus", 1ULL << used);
+    ImGui::PushStyleColor(ImGuiCol_PlotHistogram, color);
+    ImGui::PlotHistogram("##runq", buckets, used, 0, overlay, 0.0f, FLT_MAX,
+                         ImVec2(220, 40));
+    ImGui::PopStyleColor();
+  }
+}
+
+// Softnet totals, then only the CPUs and NICs that are actually dropping,
+// in red so they stand out.
+static void drawPacketDrops(const PacketDropStats &stats, const ImVec4 &color) {
+  ImVec4 alert(1.0f, 0.3f, 0.3f, color.w);
+  ImGui::TextColored(stats.hasDrops() ? alert : color,
+                     "Softnet: %.0f pkt/s dropped %.0f/s squeezed %.0f/s",
+                     stats.processedRate, stats.droppedRate,
+                     stats.timeSqueezeRate);
+  for (const SoftnetCpuStats &cpu : stats.cpus)
+    if (cpu.droppedRate > 0 || cpu.timeSqueezeRate > 0)
+      ImGui::TextColored(alert, "  CPU%d: dropped %.0f/s squeezed %.0f/s",
+                         cpu.cpu, cpu.droppedRate, cpu.timeSqueezeRate);
+  for (const NicDropStats &nic : stats.interfaces)
+    if (nic.hasDrops())
+      ImGui::TextColored(alert,
+                         "  %s: rx_dropped %.0f/s missed %.0f/s fifo %.0f/s "
+                         "tx_errors %.0f/s",
+                         nic.name.c_str(), nic.rxDroppedRate, nic.rxMissedRate,
+                         nic.rxFifoRate, nic.txErrorsRate);
+}
+
+// The --watch-pid/--watch-name target: totals, then the busiest threads.
+static void drawWatchedProcess(const WatchedProcessStats &stats,
+                               const ProcessMemoryStats *memory,
+                               const ImVec4 &color) {
+  if (!stats.attached) {
+    ImGui::TextColored(color, "Watch: %s", stats.status.c_str());
+    return;
+  }
+  ImGui::TextColored(color, "Watch: %s (%d): CPU %.1f%% RSS %lld MB",
+                     stats.name.c_str(), stats.pid, stats.cpuPercent,
+                     stats.rssKb / 1024);
+  if (memory && memory->valid)
+    ImGui::TextColored(color,
+                       "  PSS %lld MB USS %lld MB Swap %lld MB, "
+                       "I/O R %.1f W %.1f MB/s",
+                       memory->pssKb / 1024, memory->ussKb / 1024,
+                       memory->swapKb / 1024,
+                       memory->readBytesPerSec / (1024 * 1024),
+                       memory->writeBytesPerSec / (1024 * 1024));
+  ImGui::TextColored(color, "  %.0f switches/s, run delay %.1f ms/s",
+                     stats.switchesPerSec, stats.runDelayMs);
+  size_t shown = std::min<size_t>(stats.threads.size(), 5);
+  for (size_t i = 0; i < shown; ++i) {
+    const WatchedThreadStats &thread = stats.threads[i];
+    ImGui::TextColored(color, "  %d %s: %.1f%%, delay %.1f ms/s", thread.tid,
+                       thread.name.c_str(), thread.cpuPercent,
+                       thread.runDelayMs);
+  }
+}
+
+// OOM kill rate, then the latest kernel events in red with their victims.
+static void drawKernelEvents(const KernelEventStats &stats,
+                             const ImVec4 &color) {
+  ImVec4 alert(1.0f, 0.3f, 0.3f, color.w);
+  if (!stats.available && !stats.status.empty())
+    ImGui::TextColored(color, "Kernel events: %s", stats.status.c_str());
+  ImGui::TextColored(stats.oomKillRate > 0 ? alert : color,
+                     "OOM kills: %.2f/s (%lld total)", stats.oomKillRate,
+                     stats.oomKillTotal);
+  size_t shown = std::min<size_t>(stats.events.size(), 5);
+  for (size_t i = 0; i < shown; ++i) {
+    const KernelEvent &event = stats.events[i];
+    char when[16];
+    strftime(when, sizeof(when), "%H:%M:%S", localtime(&event.when));
+    if (event.pid > 0)
+      ImGui::TextColored(alert, "  %s %s: %s (%d)", when,
+                         KernelEventMonitor::typeName(event.type),
+                         event.victim.c_str(), event.pid);
+    else if (!event.victim.empty())
+      ImGui::TextColored(alert, "  %s %s: %s", when,
+                         KernelEventMonitor::typeName(event.type),
+                         event.victim.c_str());
+    else
+      ImGui::TextColored(alert, "  %s %s: %s", when,
+                         KernelEventMonitor::typeName(event.type),
+                         event.message.c_str());
+  }
+}
+
+// One line per config-defined metric. Stale values are dimmed, a metric that
+// has never produced one shows why.
+static void drawCustomMetrics(const std::vector<CustomMetricStats> &metrics,
+                              const ImVec4 &color) {
+  ImVec4 alert(1.0f, 0.3f, 0.3f, color.w);
+  ImVec4 dim(color.x * 0.5f, color.y * 0.5f, color.z * 0.5f, color.w);
+  for (const CustomMetricStats &metric : metrics) {
+    if (!metric.valid)
+      ImGui::TextColored(metric.error.empty() ? dim : alert, "%s: %s",
+                         metric.label.c_str(),
+                         metric.error.empty() ? "waiting"
+                                              : metric.error.c_str());
+    else
+      ImGui::TextColored(metric.stale ? dim : color, "%s: %g %s",
+                         metric.label.c_str(), metric.value,
+                         metric.unit.c_str());
+  }
+}
+
+// Everything one spike capture recorded. Used for the browser in the config
+// window; the overlay only shows the newest reason.
+static void drawSpikeSnapshot(const SpikeSnapshot &snapshot,
+                              const ImVec4 &color) {
+  char when[32];
+  strftime(when, sizeof(when), "%H:%M:%S", localtime(&snapshot.when));
+  ImGui::TextColored(color, "%s  %s (over %.1f s)", when,
+                     snapshot.reason.c_str(), snapshot.windowSec);
+  ImGui::TextColored(color, "CPU %.0f%%, memory PSI %.1f%%, I/O PSI %.1f%%",
+                     snapshot.cpuPercent, snapshot.memoryPressure,
+                     snapshot.ioPressure);
+  // Every registered metric at the trigger, whether or not it has a line.
+  char metric_line[128];
+  for (const MetricDescriptor &metric : kMetrics)
+    if (formatMetric(metric_line, sizeof(metric_line), metric,
+                     snapshot.metrics))
+      ImGui::TextColored(color, "  %s", metric_line);
+  for (const SpikeProcess &process : snapshot.topProcesses)
+    ImGui::TextColored(color, "  %d %s: %.1f%% RSS %lld MB", process.pid,
+                       process.name.c_str(), process.cpuPercent,
+                       process.rssKb / 1024);
+  std::string cores;
+  for (size_t i = 0; i < snapshot.coreUsage.size(); ++i) {
+    // "%.0f" of a double has no bounded size for snprintf; to_chars just stops.
+    char core[32];
+    char *end = core + sizeof(core) - 1; // keeps room for the '%'
+    char *p = core;
+    if (i)
+      *p++ = ' ';
+    p = std::to_chars(p, end, snapshot.coreIds[i]).ptr;
+    *p++ = ':';
+    p = std::to_chars(p, end, snapshot.coreUsage[i], std::chars_format::fixed, 0)
+            .ptr;
+    *p++ = '%';
+    cores.append(core, p);
+  }
+  ImGui::TextColored(color, "Cores: %s", cores.c_str());
+  for (const SpikeCgroup &cgroup : snapshot.cgroups)
+    ImGui::TextColored(color, "  %s: %.1f%% %lld MB", cgroup.path.c_str(),
+                       cgroup.cpuPercent, cgroup.memoryKb / 1024);
+  for (const SpikeIrq &irq : snapshot.interrupts)
+    ImGui::TextColored(color, "  IRQ %s %s: %.0f/s", irq.name.c_str(),
+                       irq.description.c_str(), irq.rate);
+  for (const SpikeIrq &irq : snapshot.softirqs)
+    ImGui::TextColored(color, "  SoftIRQ %s: %.0f/s", irq.name.c_str(),
+                       irq.rate);
+}
+
+// One burst series over the zoomed window [first, first + shown). The wheel
+// zooms around the cursor and dragging pans; every series shares the window.
+static void drawBurstSeries(const char *label, const float *values,
+                            size_t stride, float maxValue, int &first,
+                            int &shown, int total) {
+  ImVec2 size(ImGui::GetContentRegionAvail().x, 60);
+  const float *start = reinterpret_cast<const float *>(
+      reinterpret_cast<const char *>(values) + first * stride);
+  float peak = 0.0f;
+  for (int i = 0; i < shown; ++i)
+    peak = std::max(peak, *reinterpret_cast<const float *>(
+                              reinterpret_cast<const char *>(start) +
+                              i * stride));
+  char overlay[64];
+  snprintf(overlay, sizeof(overlay), "%s (peak %.1f)", label, peak);
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  ImGui::PlotLines("##burst", start, shown, 0, overlay, 0.0f,
+                   maxValue > 0 ? maxValue : std::max(1.0f, peak), size,
+                   static_cast<int>(stride));
+  // An invisible button on top takes the mouse, so dragging pans instead of
+  // moving the window.
+  ImGui::SetCursorScreenPos(origin);
+  ImGui::PushID(label);
+  ImGui::InvisibleButton("zoom", size);
+  ImGui::PopID();
+  if (!ImGui::IsItemHovered() && !ImGui::IsItemActive())
+    return;
+  ImGuiIO &io = ImGui::GetIO();
+  float x = std::clamp((io.MousePos.x - origin.x) / size.x, 0.0f, 1.0f);
+  if (io.MouseWheel != 0) {
+    int anchor = first + static_cast<int>(x * shown);
+    shown = std::clamp(
+        static_cast<int>(shown * (io.MouseWheel > 0 ? 0.8f : 1.25f)),
+        std::min(10, total), total);
+    first = anchor - static_cast<int>(x * shown);
+  }
+  if (ImGui::IsItemActive())
+    first -= static_cast<int>(io.MouseDelta.x / size.x * shown);
+  first = std::clamp(first, 0, std::max(0, total - shown));
+  int index = std::min(total - 1, first + static_cast<int>(x * shown));
+  ImGui::SetTooltip("%s: %.1f", label,
+                    *reinterpret_cast<const float *>(
+                        reinterpret_cast<const char *>(values) +
+                        index * stride));
+}
+
+// The last burst capture as stacked plots sharing one zoom window, plus a
+// CSV export next to the config file.
+static void drawBurstCapture(const BurstCaptureMonitor &burst,
+                             const ImVec4 &color,
+                             const std::string &configPath) {
+  static int first = 0;
+  static int shown = 0;
+  static int core = 0;
+  static std::string saved;
+  int total = static_cast<int>(burst.getSampleCount());
+  if (total < 2) {
+    ImGui::Text("No burst captured yet.");
+    return;
+  }
+  if (shown < 10 || shown > total || burst.isCapturing()) {
+    first = 0;
+    shown = total;
+  }
+  char when[32];
+  std::time_t started = burst.getStartTime();
+  strftime(when, sizeof(when), "%H:%M:%S", localtime(&started));
+  const std::vector<BurstSample> &samples = burst.getSamples();
+  ImGui::TextColored(color,
+                     "%s  %s: %d samples, sampler on CPU%d, %d missed", when,
+                     burst.getReason().c_str(), total, burst.getSamplerCpu(),
+                     burst.getMissed());
+  ImGui::TextColored(color, "Showing %.2f - %.2f s (wheel zooms, drag pans)",
+                     samples[first].seconds,
+                     samples[first + shown - 1].seconds);
+
+  size_t stride = sizeof(BurstSample);
+  drawBurstSeries("CPU %", &samples[0].cpuPercent, stride, 100.0f, first,
+                  shown, total);
+  drawBurstSeries("Running", &samples[0].running, stride, 0.0f, first, shown,
+                  total);
+  drawBurstSeries("Blocked", &samples[0].blocked, stride, 0.0f, first, shown,
+                  total);
+  drawBurstSeries("CPU PSI %", &samples[0].cpuPressure, stride, 100.0f,
+                  first, shown, total);
+  drawBurstSeries("Memory PSI %", &samples[0].memoryPressure, stride, 100.0f,
+                  first, shown, total);
+  drawBurstSeries("I/O PSI %", &samples[0].ioPressure, stride, 100.0f, first,
+                  shown, total);
+  int cores = static_cast<int>(burst.getCoreCount());
+  if (cores > 0) {
+    core = std::min(core, cores - 1);
+    ImGui::SliderInt("Core", &core, 0, cores - 1);
+    ImGui::SameLine();
+    ImGui::Text("CPU%d", burst.getCoreIds()[core]);
+    drawBurstSeries("Core %", &burst.getCoreUsage()[core],
+                    cores * sizeof(float), 100.0f, first, shown, total);
+  }
+  if (ImGui::Button("Reset Zoom"))
+    shown = total;
+  ImGui::SameLine();
+  if (!burst.isCapturing() && ImGui::Button("Save CSV")) {
+    size_t slash = configPath.rfind('/');
+    std::string dir =
+        slash == std::string::npos ? "." : configPath.substr(0, slash);
+    char name[48];
+    strftime(name, sizeof(name), "/burst-%Y%m%d-%H%M%S.csv",
+             localtime(&started));
+    saved = burst.save(dir + name) ? "Saved " + dir + name
+                                   : "Could not write " + dir + name;
+  }
+  if (!saved.empty())
+    ImGui::TextColored(color, "%s", saved.c_str());
+}
+
+// Lines from a collector that missed its deadline are dimmed until it
+// catches up.
+static ImVec4 sourceColor(const SystemMonitor &monitor, CollectorSource source,
+                          const ImVec4 &color) {
+  if (!monitor.isStale(source))
+    return color;
+  return ImVec4(color.x * 0.5f, color.y * 0.5f, color.z * 0.5f, color.w);
+}
+
+// One line per registered metric that belongs in this window and is switched
+// on, in registry order. The ones a pool collector fills in dim while stale.
+static void drawMetrics(const SystemMonitor &monitor, const AppConfig &config,
+                        MetricPlace place, const ImVec4 &color) {
+  char line[128];
+  for (const MetricDescriptor &metric : kMetrics) {
+    if (metric.place != place ||
+        !config.show_metrics[static_cast<size_t>(metric.id)])
+      continue;
+    if (!formatMetric(line, sizeof(line), metric, monitor.getMetrics()))
+      continue;
+    ImVec4 shown = color;
+    if (monitor.isStale(metric.id))
+      shown = ImVec4(color.x * 0.5f, color.y * 0.5f, color.z * 0.5f, color.w);
+    ImGui::TextColored(shown, "%s", line);
+  }
+}
+
+// The "Show ..." checkboxes for one window's metrics.
+static void drawMetricToggles(AppConfig &config, MetricPlace place) {
+  char label[64];
+  for (const MetricDescriptor &metric : kMetrics) {
+    if (metric.place != place || !metric.showKey)
+      continue;
+    snprintf(label, sizeof(label), "Show %s", metric.label);
+    ImGui::Checkbox(label,
+                    &config.show_metrics[static_cast<size_t>(metric.id)]);
+  }
+}
+
+// One block per detected card, labelled GPU0, GPU1, ... when there are
+// several, switched by the GpuCards metrics' toggles. Fields a backend cannot
+// read are left out.
+static void drawGpuCards(const std::vector<GpuCardStats> &cards,
+                         const AppConfig &config, const ImVec4 &color) {
+  auto shown = [&](MetricId id) {
+    return config.show_metrics[static_cast<size_t>(id)];
+  };
+  if (cards.empty()) {
+    if (shown(MetricId::GpuUsage))
+      ImGui::TextColored(color, "GPU: none detected");
+    return;
+  }
+  for (size_t i = 0; i < cards.size(); ++i) {
+    const GpuCardStats &card = cards[i];
+    std::string label = cards.size() > 1 ? "GPU" + std::to_string(i) : "GPU";
+    if (shown(MetricId::GpuUsage) && card.hasUsage) {
+      if (card.hasFrequency)
+        ImGui::TextColored(color, "%s Usage: %.2f%% @ %d MHz (%s)",
+                           label.c_str(), card.usage, card.frequency,
+                           card.driver.c_str());
+      else
+        ImGui::TextColored(color, "%s Usage: %.2f%% (%s)", label.c_str(),
+                           card.usage, card.driver.c_str());
+    }
+    if (shown(MetricId::GpuMemoryUsed) && card.hasMemory)
+      ImGui::TextColored(color, "%s Mem: %lld MB / %lld MB", label.c_str(),
+                         card.memoryUsed, card.memoryTotal);
+    if (shown(MetricId::GpuTemperature) &&
+        (card.hasTemperature || card.hasPower)) {
+      if (card.hasTemperature && card.hasPower)
+        ImGui::TextColored(color, "%s Temp: %d C, %.1f W", label.c_str(),
+                           card.temperature, card.power);
+      else if (card.hasTemperature)
+        ImGui::TextColored(color, "%s Temp: %d C", label.c_str(),
+                           card.temperature);
+      else
+        ImGui::TextColored(color, "%s Power: %.1f W", label.c_str(),
+                           card.power);
     }
   }
 }
-// }
 
 #include <string>
 // #include <vector> Not used currently
@@ -124,10 +563,14 @@ int main(int argc, char **argv) {
       debug_mode = true;
     } else if (std::string(argv[i]) == "--config") {
       config_mode = true;
+    } else if (std::string(argv[i]) == "--watch-pid" && i + 1 < argc) {
+      systemMonitor.watchProcess(atoi(argv[++i]));
+    } else if (std::string(argv[i]) == "--watch-name" && i + 1 < argc) {
+      systemMonitor.watchProcessName(argv[++i]);
     }
   }
 
-  configManager.loadConfig(appConfig);
+  applyConfig(false);
 
   if (config_mode) {
   }
@@ -247,27 +690,163 @@ int main(int argc, char **argv) {
   double last_frame_time = glfwGetTime();
   int frame_count = 0;
 
-  std::thread t(pollGlobalHotkeys, window);
+  // The X connections, the sampling timer, PSI triggers, kernel events, the
+  // config file, the watched process and signals all wake the same
+  // epoll_wait. With nothing animating, the loop sleeps there until one of
+  // them has something.
+  Display *dpy = glfwGetX11Display();
+  Display *hotkey_dpy = XOpenDisplay(NULL);
+  eventLoop.watch(ConnectionNumber(dpy), EventLoop::Display);
+  if (hotkey_dpy) {
+    grabGlobalHotkey(hotkey_dpy);
+    eventLoop.watch(ConnectionNumber(hotkey_dpy), EventLoop::Hotkey);
+  }
+  eventLoop.watchConfig(configManager.get_config_path());
+  eventLoop.watchPressure(systemMonitor.getPressureFds());
+  systemMonitor.setNotifyFd(eventLoop.getWakeFd());
+  eventLoop.watch(systemMonitor.getCollectedFd(), EventLoop::Collected);
+  eventLoop.armTimer(1);
+
+  // The colour cycle is slow enough that ten frames a second look smooth.
+  const double hue_frame_interval = 0.1;
+  int frames_pending = 1;
+  long long last_wakeups = 0;
+  long long last_batch_files = 0;
+  long long last_batch_syscalls = 0;
+  int exit_watch_attach = 0; // attach whose pidfd eventLoop is watching
 
   // start of main loop
   while (!glfwWindowShouldClose(window)) {
-    double current_time = glfwGetTime();
-    double delta_time = current_time - last_frame_time;
-    last_frame_time = current_time;
-
-    frame_count++; // Increment frame count every frame
+    double now = glfwGetTime();
+    int timeout = -1;
+    // Xlib may already have read events off the socket into its own queue.
+    if (frames_pending > 0 || now < fade_start_time + fade_duration ||
+        XPending(dpy) > 0)
+      timeout = 0;
+    else if (appConfig.enable_fading_colors)
+      timeout = std::max(
+          0, static_cast<int>((last_frame_time + hue_frame_interval - now) *
+                              1000));
+    if (!eventLoop.isAvailable())
+      glfwWaitEventsTimeout(timeout < 0 ? 0.25 : timeout / 1000.0);
+    unsigned events = eventLoop.wait(timeout);
+    if (events & EventLoop::Quit)
+      break;
 
+    glfwPollEvents();
+    // ImGui needs a second frame to settle after input.
+    if (config_mode && (events & EventLoop::Display))
+      frames_pending = 2;
+    if (events & EventLoop::Hotkey) {
+      int bursts = 0;
+      for (int i = takeGlobalHotkeys(hotkey_dpy, bursts); i > 0; --i)
+        glfw_key_callback(window, GLFW_KEY_F1, 0, GLFW_PRESS, 0);
+      if (bursts > 0 && systemMonitor.startBurstCapture("F2"))
+        frames_pending = std::max(frames_pending, 1);
+    }
+    if (events & EventLoop::Config)
+      applyConfig(true);
+    if (events & EventLoop::Pressure)
+      systemMonitor.notifyPressure();
+    // A watched process exiting is noticed now rather than at the next
+    // update, which can be sample_max_ms away, and the fast rate that follows
+    // picks up a replacement by name quickly.
+    if (events & (EventLoop::Wake | EventLoop::Exited))
+      systemMonitor.snapSampling();
+    // Slow collectors publish whenever they finish, not on the next round.
+    if ((events & EventLoop::Collected) && systemMonitor.publishCollected())
+      frames_pending = std::max(frames_pending, 1);
+    bool update_due =
+        events & (EventLoop::Timer | EventLoop::Config | EventLoop::Pressure |
+                  EventLoop::Wake | EventLoop::Exited);
+
+    // With adaptive sampling each source decides how often it runs; the timer
+    // is armed for whichever is due first.
+    int sample_min_ms = appConfig.adaptive_sampling
+                            ? std::max(50, appConfig.sample_min_ms)
+                            : 1000;
+    int sample_max_ms = appConfig.adaptive_sampling
+                            ? std::max(sample_min_ms, appConfig.sample_max_ms)
+                            : 1000;
     static double last_stat_update_time = 0.0;
-    if (current_time - last_stat_update_time > 1.0) {
+    double current_time = glfwGetTime();
+    double since_update = current_time - last_stat_update_time;
+    if (!eventLoop.isAvailable())
+      update_due = since_update > sample_min_ms / 1000.0;
+    // PSI, kernel events and config changes still leave sample_min_ms between
+    // updates.
+    if (update_due && since_update < sample_min_ms / 1000.0) {
+      eventLoop.armTimer(
+          static_cast<int>((sample_min_ms / 1000.0 - since_update) * 1000) + 1);
+      update_due = false;
+    }
+    if (update_due) {
+      systemMonitor.setSamplingBounds(sample_min_ms, sample_max_ms);
+      ProcFileBatch::setUringAllowed(appConfig.io_uring_reads);
+      systemMonitor.setInterruptStatsEnabled(appConfig.show_interrupts);
+      systemMonitor.setPerfCountersEnabled(appConfig.show_perf_counters);
+      systemMonitor.setRunqueueLatencyEnabled(appConfig.show_runqueue_latency);
+      systemMonitor.setNumaStatsEnabled(appConfig.show_numa);
+      systemMonitor.setTcpStatsEnabled(appConfig.show_tcp);
+      systemMonitor.setPacketDropStatsEnabled(appConfig.show_packet_drops);
+      systemMonitor.setGpuProcessStatsEnabled(appConfig.show_gpu_processes);
+      systemMonitor.setSpikeCaptureEnabled(appConfig.show_spike_captures);
+      systemMonitor.setCgroupCpuEnabled(appConfig.show_cgroup_cpu);
+      systemMonitor.setKernelEventsEnabled(appConfig.show_kernel_events);
+      systemMonitor.setCustomMetricsEnabled(appConfig.show_custom_metrics);
+      systemMonitor.setBurstCapture(appConfig.burst_seconds,
+                                    appConfig.burst_cpu,
+                                    appConfig.burst_on_trigger);
+      systemMonitor.setSpikeThresholds(
+          appConfig.spike_cpu_threshold, appConfig.spike_memory_pressure,
+          appConfig.spike_io_pressure, appConfig.spike_history);
+      systemMonitor.setCompressedMemoryEnabled(
+          appConfig.show_compressed_memory || appConfig.show_hugepages);
       systemMonitor.update();
       // Calculate FPS based on frames rendered in the last second
       if (current_time - last_stat_update_time > 0) { // Avoid division by zero
           systemMonitor.setFps(frame_count / (current_time - last_stat_update_time));
       }
       frame_count = 0; // Reset frame count
+      wakeup_rate = (eventLoop.getWakeups() - last_wakeups) /
+                    (current_time - last_stat_update_time);
+      last_wakeups = eventLoop.getWakeups();
+      batch_file_rate = (ProcFileBatch::getFilesRead() - last_batch_files) /
+                        (current_time - last_stat_update_time);
+      batch_syscall_rate =
+          (ProcFileBatch::getSyscalls() - last_batch_syscalls) /
+          (current_time - last_stat_update_time);
+      last_batch_files = ProcFileBatch::getFilesRead();
+      last_batch_syscalls = ProcFileBatch::getSyscalls();
       last_stat_update_time = current_time;
+      frames_pending = std::max(frames_pending, 1);
+      const WatchedProcessStats &watched =
+          systemMonitor.getWatchedProcessStats();
+      if (watched.attached && watched.attachCount != exit_watch_attach) {
+        eventLoop.watchExit(systemMonitor.getWatchedPidFd());
+        exit_watch_attach = watched.attachCount;
+      }
+
+      auto until = systemMonitor.getNextUpdate() -
+                   std::chrono::steady_clock::now();
+      long long next_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(until).count();
+      eventLoop.armTimer(static_cast<int>(std::clamp<long long>(
+          next_ms, sample_min_ms, sample_max_ms)));
     }
 
+    // Keep drawing one frame past a fade so it ends on the target alpha.
+    bool fading = current_time < fade_start_time + fade_duration;
+    bool hue_due = appConfig.enable_fading_colors &&
+                   current_time - last_frame_time >= hue_frame_interval;
+    if (frames_pending == 0 && !fading && !hue_due)
+      continue;
+    frames_pending = fading ? 1 : std::max(0, frames_pending - 1);
+
+    double delta_time = current_time - last_frame_time;
+    last_frame_time = current_time;
+    frame_count++;
+
     if (current_time < fade_start_time + fade_duration) {
       float t = (current_time - fade_start_time) / fade_duration;
 
@@ -290,19 +869,6 @@ int main(int argc, char **argv) {
     }
     text_color.w = window_alpha;
 
-    // look for key event from worker thread
-    glfwPollEvents();
-    {
-      std::lock_guard<std::mutex> lk(mtx);
-      while (!q.empty()) {
-        auto m = q.front();
-        q.pop();
-        glfw_key_callback(window, GLFW_KEY_F1, 0, GLFW_PRESS, 0);
-      }
-    }
-
-    // Poll for GLFW events
-    glfwPollEvents();
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -318,39 +884,203 @@ int main(int argc, char **argv) {
                        ImGuiWindowFlags_NoSavedSettings |
                        ImGuiWindowFlags_NoBackground);
 
-      if (appConfig.show_cpu_usage)
-        ImGui::TextColored(text_color, "CPU: %.2f%%",
-                           systemMonitor.getCpuUsage());
-      if (appConfig.show_cpu_temp)
-        ImGui::TextColored(text_color, "CPU Temp: %d C",
-                           systemMonitor.getCpuTemperature());
-      if (appConfig.show_memory_stats)
-        ImGui::TextColored(text_color, "Mem: %lld MB / %lld MB (%.2f%%)",
-                           systemMonitor.getUsedMemory() / 1024,
-                           systemMonitor.getTotalMemory() / 1024,
-                           (double)systemMonitor.getUsedMemory() /
-                               systemMonitor.getTotalMemory() * 100.0);
-      if (appConfig.show_net_down)
-        ImGui::TextColored(text_color, "Net Down: %.2f KB/s",
-                           systemMonitor.getDownloadSpeed() / 1024.0);
-      if (appConfig.show_net_up)
-        ImGui::TextColored(text_color, "Net Up: %.2f KB/s",
-                           systemMonitor.getUploadSpeed() / 1024.0);
-      if (appConfig.show_ping)
-        ImGui::TextColored(text_color, "Ping: %.2f ms",
-                           systemMonitor.getPingLatency());
-      if (appConfig.show_gpu_usage)
-        ImGui::TextColored(text_color, "GPU Usage: %.2f%%",
-                           systemMonitor.getGpuUsage());
-      if (appConfig.show_gpu_mem)
-        ImGui::TextColored(text_color, "GPU Mem: %lld MB / %lld MB",
-                           systemMonitor.getGpuMemoryUsed(),
-                           systemMonitor.getGpuMemoryTotal());
-      if (appConfig.show_gpu_temp)
-        ImGui::TextColored(text_color, "GPU Temp: %d C",
-                           systemMonitor.getGpuTemperature());
-      if (appConfig.show_fps)
-        ImGui::TextColored(text_color, "FPS: %.2f", systemMonitor.getFps());
+      if (systemMonitor.isWatchingProcess())
+        drawWatchedProcess(systemMonitor.getWatchedProcessStats(),
+                           systemMonitor.findProcessMemory(
+                               systemMonitor.getWatchedProcessStats().pid),
+                           text_color);
+      drawMetrics(systemMonitor, appConfig, MetricPlace::Overlay, text_color);
+      if (appConfig.show_cgroup_cpu) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::CgroupCpu, text_color);
+        const CgroupCpuStats &cgroup = systemMonitor.getCgroupCpuStats();
+        ImVec4 alert(1.0f, 0.3f, 0.3f, color.w);
+        if (!cgroup.available)
+          ImGui::TextColored(color, "Cgroup CPU: unavailable");
+        else if (cgroup.limited)
+          ImGui::TextColored(color,
+                             "Cgroup CPU: %.2f / %.2f cores (%.1f%%)",
+                             cgroup.usageCores, cgroup.quotaCores,
+                             cgroup.quotaPercent);
+        else
+          ImGui::TextColored(color, "Cgroup CPU: %.2f cores (no limit)",
+                             cgroup.usageCores);
+        if (cgroup.available && cgroup.limited)
+          ImGui::TextColored(cgroup.throttlesPerSec > 0 ? alert : color,
+                             "Throttled: %.0f%% of periods, %.0f ms/s "
+                             "(%lld total)",
+                             cgroup.throttledPercent, cgroup.throttledMsPerSec,
+                             cgroup.totalThrottles);
+      }
+      if (appConfig.show_numa) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::Numa, text_color);
+        const NumaStats &numa = systemMonitor.getNumaStats();
+        ImGui::TextColored(color, "NUMA: remote %.1f%% miss %.1f%%",
+                           numa.remotePercent, numa.missPercent);
+        for (const NumaNodeStats &node : numa.nodes)
+          ImGui::TextColored(
+              color,
+              "  Node%d: %lld MB / %lld MB, hit %.0f/s miss %.0f/s "
+              "foreign %.0f/s ilv %.0f/s",
+              node.node, node.usedMemory / 1024, node.totalMemory / 1024,
+              node.hitRate, node.missRate, node.foreignRate,
+              node.interleaveRate);
+      }
+      if (appConfig.show_compressed_memory) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::CompressedMemory, text_color);
+        const CompressedMemoryStats &zmem =
+            systemMonitor.getCompressedMemoryStats();
+        if (!zmem.zram.empty())
+          ImGui::TextColored(color,
+                             "ZRAM: %.0f MB stored in %.0f MB (%.2fx)",
+                             zmem.zramOriginalBytes / 1048576.0,
+                             zmem.zramUsedBytes / 1048576.0, zmem.zramRatio);
+        if (zmem.zswapEnabled || zmem.zswapPoolBytes > 0)
+          ImGui::TextColored(color,
+                             "Zswap: %.0f MB stored in %.0f MB (%.2fx)",
+                             zmem.zswapStoredBytes / 1048576.0,
+                             zmem.zswapPoolBytes / 1048576.0, zmem.zswapRatio);
+        ImGui::TextColored(color, "Mem Demand (uncompressed): %lld MB",
+                           systemMonitor.getUncompressedMemoryDemand() / 1024);
+      }
+      if (appConfig.show_hugepages) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::CompressedMemory, text_color);
+        const CompressedMemoryStats &zmem =
+            systemMonitor.getCompressedMemoryStats();
+        ImGui::TextColored(color,
+                           "HugePages: %lld / %lld used (%lld KB), THP %s "
+                           "%lld MB",
+                           zmem.hugePagesTotal - zmem.hugePagesFree,
+                           zmem.hugePagesTotal, zmem.hugePageSize,
+                           zmem.thpMode.c_str(), zmem.anonHugePages / 1024);
+        ImGui::TextColored(color,
+                           "THP: fault %.0f/s fallback %.0f/s collapse %.0f/s "
+                           "(failed %.0f/s) split %.0f/s",
+                           zmem.thpFaultAllocRate, zmem.thpFaultFallbackRate,
+                           zmem.thpCollapseAllocRate,
+                           zmem.thpCollapseFailedRate, zmem.thpSplitRate);
+      }
+      if (appConfig.show_tcp) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::Tcp, text_color);
+        const TcpStats &tcp = systemMonitor.getTcpStats();
+        if (tcp.socketCountsAvailable)
+          ImGui::TextColored(color,
+                             "TCP: %d estab %d listen %d time_wait %d "
+                             "close_wait %d syn_recv",
+                             tcp.sockets[1], tcp.sockets[10], tcp.sockets[6],
+                             tcp.sockets[8], tcp.sockets[3] + tcp.sockets[12]);
+        ImGui::TextColored(color,
+                           "TCP Retrans: %.0f/s (%.2f%%) RST: %.0f/s "
+                           "InErrs: %.0f/s",
+                           tcp.retransSegsRate, tcp.retransPercent,
+                           tcp.outRstsRate + tcp.estabResetsRate,
+                           tcp.inErrsRate);
+        ImGui::TextColored(color,
+                           "TCP Listen Overflows: %.0f/s Drops: %.0f/s",
+                           tcp.listenOverflowsRate, tcp.listenDropsRate);
+      }
+      if (appConfig.show_packet_drops)
+        drawPacketDrops(systemMonitor.getPacketDropStats(),
+                        sourceColor(systemMonitor,
+                                    CollectorSource::PacketDrops, text_color));
+      if (appConfig.show_probes) {
+        ImVec4 alert(1.0f, 0.3f, 0.3f, text_color.w);
+        for (const ProbeStats &probe : systemMonitor.getProbeStats()) {
+          if (!probe.ok && !probe.lastError.empty())
+            ImGui::TextColored(alert, "  %s: %s", probe.label.c_str(),
+                               probe.lastError.c_str());
+          else if (probe.http)
+            ImGui::TextColored(text_color,
+                               "  %s: connect p50 %.1f p99 %.1f ms, "
+                               "ttfb p50 %.1f p99 %.1f ms",
+                               probe.label.c_str(), probe.p50ConnectMs,
+                               probe.p99ConnectMs, probe.p50TtfbMs,
+                               probe.p99TtfbMs);
+          else
+            ImGui::TextColored(text_color,
+                               "  %s: connect p50 %.1f p95 %.1f p99 %.1f ms",
+                               probe.label.c_str(), probe.p50ConnectMs,
+                               probe.p95ConnectMs, probe.p99ConnectMs);
+        }
+      }
+      drawGpuCards(
+          systemMonitor.getGpuCards(), appConfig,
+          sourceColor(systemMonitor, CollectorSource::Gpu, text_color));
+      if (appConfig.show_gpu_processes) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::GpuProcesses, text_color);
+        const GpuProcessTable &gpuProcs = systemMonitor.getGpuProcessStats();
+        size_t shown = std::min<size_t>(gpuProcs.processes.size(), 5);
+        for (size_t i = 0; i < shown; ++i) {
+          const GpuProcessStats &proc = gpuProcs.processes[i];
+          ImGui::TextColored(color,
+                             "  %d %s: %.0f%% %s, VRAM %lld MB, GTT %lld MB",
+                             proc.pid, proc.name.c_str(), proc.busyPercent,
+                             proc.busiestEngine.c_str(), proc.vramKb / 1024,
+                             proc.systemKb / 1024);
+        }
+      }
+      if (appConfig.show_kernel_events)
+        drawKernelEvents(systemMonitor.getKernelEventStats(), text_color);
+      if (appConfig.show_spike_captures) {
+        const SpikeCaptureMonitor &spikes = systemMonitor.getSpikeCapture();
+        ImGui::TextColored(text_color,
+                           "Spikes: %d (PSI mem %.1f%% io %.1f%%)",
+                           spikes.getTriggerCount(),
+                           spikes.getMemoryPressure(), spikes.getIoPressure());
+        if (spikes.getCaptureCount() > 0)
+          ImGui::TextColored(text_color, "  last: %s",
+                             spikes.getCapture(0).reason.c_str());
+      }
+      {
+        const BurstCaptureMonitor &burst = systemMonitor.getBurstCapture();
+        if (burst.isCapturing())
+          ImGui::TextColored(text_color, "Burst capture (%s): %.1f / %zu s",
+                             burst.getReason().c_str(),
+                             burst.getSampleCount() /
+                                 double(BurstCaptureMonitor::kRateHz),
+                             burst.getCapacity() /
+                                 BurstCaptureMonitor::kRateHz);
+      }
+      if (appConfig.show_custom_metrics)
+        drawCustomMetrics(systemMonitor.getCustomMetrics(),
+                          sourceColor(systemMonitor,
+                                      CollectorSource::CustomMetrics,
+                                      text_color));
+      if (appConfig.show_interrupts) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::Interrupts, text_color);
+        drawInterruptTable("IRQ", systemMonitor.getInterruptTable(),
+                           color);
+        drawInterruptTable("SoftIRQ", systemMonitor.getSoftirqTable(),
+                           color);
+      }
+      if (appConfig.show_perf_counters) {
+        ImVec4 color = sourceColor(
+            systemMonitor, CollectorSource::PerfCounters, text_color);
+        const PerfCounterStats &perf = systemMonitor.getPerfCounterStats();
+        if (perf.softwareAvailable) {
+          ImGui::TextColored(color,
+                             "Ctx Switches: %.0f/s Migrations: %.0f/s",
+                             perf.contextSwitchesPerSec, perf.migrationsPerSec);
+          ImGui::TextColored(color, "Page Faults: %.0f/s (major %.0f/s)",
+                             perf.pageFaultsPerSec, perf.majorFaultsPerSec);
+        }
+        if (perf.hardwareAvailable)
+          ImGui::TextColored(color, "IPC: %.2f Cache Misses: %.0f/s",
+                             perf.instructionsPerCycle, perf.cacheMissesPerSec);
+        if (!perf.status.empty())
+          ImGui::TextColored(color, "Perf: %s", perf.status.c_str());
+      }
+      if (appConfig.show_runqueue_latency)
+        drawRunqueueLatency(systemMonitor.getRunqueueLatencyStats(),
+                            sourceColor(systemMonitor,
+                                        CollectorSource::RunqueueLatency,
+                                        text_color));
 
       ImGui::End();
     }
@@ -366,12 +1096,72 @@ int main(int argc, char **argv) {
                        ImGuiWindowFlags_NoSavedSettings |
                        ImGuiWindowFlags_NoBackground);
 
-      if (appConfig.show_app_cpu)
-        ImGui::TextColored(text_color, "App CPU: %.2f%%",
-                           systemMonitor.getProcessCpuUsage());
-      if (appConfig.show_app_mem)
-        ImGui::TextColored(text_color, "App Mem: %lld KB",
-                           systemMonitor.getProcessMemoryUsage());
+      drawMetrics(systemMonitor, appConfig, MetricPlace::Debug, text_color);
+      if (appConfig.show_metrics[static_cast<size_t>(MetricId::AppMemory)]) {
+        const ProcessMemoryStats *self =
+            systemMonitor.findProcessMemory(getpid());
+        const ProcessMemorySamplerStats &sampler =
+            systemMonitor.getProcessMemoryStats();
+        if (self && self->valid)
+          ImGui::TextColored(text_color,
+                             "App PSS: %lld KB USS: %lld KB Swap: %lld KB",
+                             self->pssKb, self->ussKb, self->swapKb);
+        ImGui::TextColored(text_color,
+                           "smaps_rollup: %.0f us/update (budget %.0f), "
+                           "%d deferred",
+                           sampler.tickCostUs, sampler.budgetUs,
+                           sampler.deferred);
+        for (const ProcessMemoryStats &process : sampler.processes)
+          ImGui::TextColored(text_color, "  pid %d: %.0f us every %d ms",
+                             process.pid, process.rollupCostUs,
+                             process.rollupIntervalMs);
+      }
+      {
+        ImVec4 alert(1.0f, 0.3f, 0.3f, text_color.w);
+        if (systemMonitor.hasPressureTriggers())
+          ImGui::TextColored(text_color,
+                             "Sampling: core every %d ms, %d PSI triggers",
+                             systemMonitor.getCoreIntervalMs(),
+                             systemMonitor.getPressureTriggerCount());
+        else
+          ImGui::TextColored(text_color,
+                             "Sampling: core every %d ms (no PSI triggers)",
+                             systemMonitor.getCoreIntervalMs());
+        ImGui::TextColored(text_color, "Main loop: %.1f wakeups/s",
+                           wakeup_rate);
+        ImGui::TextColored(text_color,
+                           "Sysfs reads (%s): %.1f files in %.1f syscalls/s",
+                           ProcFileBatch::getUringCount() > 0 ? "io_uring"
+                                                              : "pread",
+                           batch_file_rate, batch_syscall_rate);
+        ImGui::TextColored(text_color, "Collectors (last / deadline):");
+        for (const CollectorStatus &collector :
+             systemMonitor.getCollectorStatus()) {
+          if (!collector.enabled)
+            continue;
+          ImGui::TextColored(collector.stale ? alert : text_color,
+                             "  %s: every %d ms, %.1f / %.0f ms, "
+                             "%d overruns%s",
+                             collector.name.c_str(),
+                             collector.intervalMs > 0 ? collector.intervalMs
+                                                      : sample_min_ms,
+                             collector.lastMs, collector.deadlineMs,
+                             collector.overruns,
+                             collector.running   ? " (running)"
+                             : collector.stale ? " (stale)"
+                                               : "");
+        }
+        if (AllocGuard::isEnabled()) {
+          ImGui::TextColored(text_color, "Allocations last tick: update %lld",
+                             systemMonitor.getUpdateAllocations());
+          for (const CollectorStatus &collector :
+               systemMonitor.getCollectorStatus()) {
+            if (collector.enabled && collector.allocations > 0)
+              ImGui::TextColored(alert, "  %s: %lld", collector.name.c_str(),
+                                 collector.allocations);
+          }
+        }
+      }
 
       ImGui::End();
     }
@@ -393,21 +1183,80 @@ int main(int argc, char **argv) {
       }
 
       if (ImGui::CollapsingHeader("Stat Visibility")) {
-        ImGui::Checkbox("Show CPU Usage", &appConfig.show_cpu_usage);
-        ImGui::Checkbox("Show CPU Temp", &appConfig.show_cpu_temp);
-        ImGui::Checkbox("Show Memory Stats", &appConfig.show_memory_stats);
-        ImGui::Checkbox("Show Net Down", &appConfig.show_net_down);
-        ImGui::Checkbox("Show Net Up", &appConfig.show_net_up);
-        ImGui::Checkbox("Show Ping", &appConfig.show_ping);
-        ImGui::Checkbox("Show GPU Usage", &appConfig.show_gpu_usage);
-        ImGui::Checkbox("Show GPU Memory", &appConfig.show_gpu_mem);
-        ImGui::Checkbox("Show GPU Temp", &appConfig.show_gpu_temp);
-        ImGui::Checkbox("Show FPS", &appConfig.show_fps);
+        drawMetricToggles(appConfig, MetricPlace::Overlay);
+        ImGui::Checkbox("Show Cgroup CPU", &appConfig.show_cgroup_cpu);
+        ImGui::Checkbox("Show NUMA Nodes", &appConfig.show_numa);
+        ImGui::Checkbox("Show Compressed Memory",
+                        &appConfig.show_compressed_memory);
+        ImGui::Checkbox("Show Huge Pages", &appConfig.show_hugepages);
+        ImGui::Checkbox("Show TCP Health", &appConfig.show_tcp);
+        ImGui::Checkbox("Show Packet Drops", &appConfig.show_packet_drops);
+        ImGui::Checkbox("Show GPU Processes", &appConfig.show_gpu_processes);
+        ImGui::Checkbox("Show Latency Probes", &appConfig.show_probes);
+        drawMetricToggles(appConfig, MetricPlace::GpuCards);
+        ImGui::Checkbox("Show Interrupts", &appConfig.show_interrupts);
+        ImGui::Checkbox("Show Perf Counters", &appConfig.show_perf_counters);
+        ImGui::Checkbox("Show Kernel Events", &appConfig.show_kernel_events);
+        ImGui::Checkbox("Show Custom Metrics",
+                        &appConfig.show_custom_metrics);
+        ImGui::Checkbox("Show Runqueue Latency (eBPF)",
+                        &appConfig.show_runqueue_latency);
+      }
+
+      if (ImGui::CollapsingHeader("Sampling")) {
+        ImGui::Checkbox("Adaptive Sampling", &appConfig.adaptive_sampling);
+        ImGui::SliderInt("Fastest (ms)", &appConfig.sample_min_ms, 50, 1000);
+        ImGui::SliderInt("Slowest (ms)", &appConfig.sample_max_ms, 1000,
+                         30000);
+        ImGui::Checkbox("Batch Sysfs Reads (io_uring)",
+                        &appConfig.io_uring_reads);
+      }
+
+      if (ImGui::CollapsingHeader("Spike Capture")) {
+        ImGui::Checkbox("Capture Spikes", &appConfig.show_spike_captures);
+        ImGui::SliderFloat("CPU Threshold", &appConfig.spike_cpu_threshold,
+                           0.0f, 100.0f, "%.0f%%");
+        ImGui::SliderFloat("Memory PSI Threshold",
+                           &appConfig.spike_memory_pressure, 0.0f, 100.0f,
+                           "%.0f%%");
+        ImGui::SliderFloat("I/O PSI Threshold", &appConfig.spike_io_pressure,
+                           0.0f, 100.0f, "%.0f%%");
+        ImGui::SliderInt("History", &appConfig.spike_history, 1, 32);
+
+        static int spike_index = 0;
+        const SpikeCaptureMonitor &spikes = systemMonitor.getSpikeCapture();
+        int captured = static_cast<int>(spikes.getCaptureCount());
+        if (captured > 0) {
+          spike_index = std::min(spike_index, captured - 1);
+          ImGui::SliderInt("Capture (0 = newest)", &spike_index, 0,
+                           captured - 1);
+          drawSpikeSnapshot(spikes.getCapture(spike_index), text_color);
+        } else {
+          ImGui::Text("No spikes captured yet.");
+        }
+      }
+
+      if (ImGui::CollapsingHeader("Burst Capture")) {
+        ImGui::SliderInt("Duration (s)", &appConfig.burst_seconds, 1,
+                         BurstCaptureMonitor::kMaxSeconds);
+        ImGui::Checkbox("Start on Spike or PSI Trigger",
+                        &appConfig.burst_on_trigger);
+        ImGui::InputInt("Sampler CPU (-1 = auto)", &appConfig.burst_cpu);
+        const BurstCaptureMonitor &burst = systemMonitor.getBurstCapture();
+        if (burst.isCapturing()) {
+          ImGui::Text("Capturing...");
+        } else if (ImGui::Button("Start Burst Capture (F2)")) {
+          systemMonitor.setBurstCapture(appConfig.burst_seconds,
+                                        appConfig.burst_cpu,
+                                        appConfig.burst_on_trigger);
+          systemMonitor.startBurstCapture("manual");
+        }
+        drawBurstCapture(burst, text_color,
+                         configManager.get_config_path());
       }
 
       if (ImGui::CollapsingHeader("App Debug Stats (requires --debug)")) {
-        ImGui::Checkbox("Show App CPU", &appConfig.show_app_cpu);
-        ImGui::Checkbox("Show App Memory", &appConfig.show_app_mem);
+        drawMetricToggles(appConfig, MetricPlace::Debug);
       }
 
       if (ImGui::Button("Save Configuration")) {
@@ -429,16 +1278,14 @@ int main(int argc, char **argv) {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
     glfwSwapBuffers(window);
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
 
-  // gracefully stop key worker thread
-  done = true;
-  t.join();
+  if (hotkey_dpy)
+    XCloseDisplay(hotkey_dpy);
 
   glfwDestroyWindow(window);
   glfwTerminate();
@@ -0,0 +1,95 @@
+#include "AllocGuard.h"
+#include "SystemMonitor.h"
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs SystemMonitor with every collector that works unprivileged switched on and this process
+// watched, and fails if a tick allocates once warmed up. Built with AllocGuard.cpp compiled in
+// with STATSBY_ALLOC_GUARD, so operator new is counted whatever the main build was configured with.
+
+namespace {
+
+constexpr int kWarmupUpdates = 10;
+constexpr int kCheckedUpdates = 30;
+
+void tick(SystemMonitor& monitor) {
+    std::this_thread::sleep_until(monitor.getNextUpdate());
+    monitor.update();
+    monitor.publishCollected();
+}
+
+} // namespace
+
+int main() {
+    if (!AllocGuard::isEnabled()) {
+        fprintf(stderr, "FAIL: built without allocation counting\n");
+        return 1;
+    }
+
+    // A few idle threads, so the watched process has a thread list to walk.
+    std::mutex mutex;
+    std::condition_variable done;
+    bool stopping = false;
+    std::vector<std::thread> idlers;
+    for (int i = 0; i < 3; ++i) {
+        idlers.emplace_back([&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return stopping; });
+        });
+    }
+
+    SystemMonitor monitor;
+    monitor.setSamplingBounds(20, 20);
+    monitor.setInterruptStatsEnabled(true);
+    monitor.setNumaStatsEnabled(true);
+    monitor.setCompressedMemoryEnabled(true);
+    monitor.setTcpStatsEnabled(true);
+    monitor.setPacketDropStatsEnabled(true);
+    monitor.setGpuProcessStatsEnabled(true);
+    monitor.setCgroupCpuEnabled(true);
+    monitor.setKernelEventsEnabled(true);
+    monitor.setSpikeCaptureEnabled(true);
+    monitor.watchProcess(getpid());
+
+    for (int i = 0; i < kWarmupUpdates; ++i) {
+        tick(monitor);
+    }
+    int failures = 0;
+    int collectorTicks = 0;
+    long long updateTotal = 0;
+    for (int i = 0; i < kCheckedUpdates; ++i) {
+        tick(monitor);
+        updateTotal += monitor.getUpdateAllocations();
+        for (const CollectorStatus& collector : monitor.getCollectorStatus()) {
+            if (collector.enabled && collector.allocations > 0) {
+                fprintf(stderr, "FAIL: %s allocated %lld times in update %d\n", collector.name.c_str(),
+                        collector.allocations, kWarmupUpdates + i);
+                collectorTicks++;
+            }
+        }
+    }
+    if (updateTotal > 0) {
+        fprintf(stderr, "FAIL: SystemMonitor::update allocated %lld times over %d updates after warm-up\n",
+                updateTotal, kCheckedUpdates);
+    }
+    failures += collectorTicks + (updateTotal > 0);
+    if (!monitor.getWatchedProcessStats().attached || monitor.getWatchedProcessStats().threads.size() < 4) {
+        fprintf(stderr, "FAIL: not following this process's threads\n");
+        failures++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    done.notify_all();
+    for (std::thread& idler : idlers) idler.join();
+    printf("%d updates after warm-up: %lld allocations in update, %d collector runs that allocated\n",
+           kCheckedUpdates, updateTotal, collectorTicks);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "GpuBackend.h"
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// Probes a fake /sys/class/drm with an i915 card0, an amdgpu card1 and a card0-DP-1 connector,
+// plus a fake /proc, and checks which backends come back and what they read.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Rewrites in place, like sysfs changing under an open fd, so the backends' held files see it.
+void writeFile(const fs::path& path, const std::string& text) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << text << "\n";
+}
+
+// card/device/driver -> ../../../bus/pci/drivers/<driver>, as sysfs lays it out.
+void makeCard(const fs::path& drm, const std::string& name, const std::string& driver) {
+    fs::path driverDir = drm.parent_path() / "drivers" / driver;
+    fs::create_directories(driverDir);
+    fs::create_directories(drm / name / "device");
+    fs::create_directory_symlink(driverDir, drm / name / "device" / "driver");
+}
+
+} // namespace
+
+int main() {
+    char rootTemplate[] = "/tmp/statsby-gpu-XXXXXX";
+    if (!mkdtemp(rootTemplate)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    fs::path root = rootTemplate;
+    fs::path drm = root / "sys" / "class" / "drm";
+    fs::path proc = root / "proc";
+    fs::create_directories(proc);
+
+    makeCard(drm, "card0", "i915");
+    writeFile(drm / "card0" / "gt" / "gt0" / "rps_act_freq_mhz", "1100");
+    writeFile(drm / "card0" / "gt" / "gt0" / "rps_max_freq_mhz", "1500");
+    writeFile(drm / "card0" / "gt" / "gt0" / "rc6_residency_ms", "1000");
+    writeFile(drm / "card0" / "device" / "hwmon" / "hwmon5" / "energy1_input", "5000000");
+
+    makeCard(drm, "card1", "amdgpu");
+    fs::path amd = drm / "card1" / "device";
+    writeFile(amd / "gpu_busy_percent", "42");
+    writeFile(amd / "mem_info_vram_used", "1073741824");
+    writeFile(amd / "mem_info_vram_total", "8589934592");
+    writeFile(amd / "hwmon" / "hwmon3" / "temp1_input", "55000");
+    writeFile(amd / "hwmon" / "hwmon3" / "power1_average", "123000000");
+    writeFile(amd / "hwmon" / "hwmon3" / "freq1_input", "1800000000");
+
+    // A connector of card0; its device link points at the same driver, but it is not a card.
+    makeCard(drm, "card0-DP-1", "amdgpu");
+
+    auto backends = probeGpuBackends(drm.string(), proc.string());
+    check(backends.size() == 2, "one backend per card, none for the connector or nvidia");
+    if (backends.size() != 2) {
+        fs::remove_all(root);
+        return 1;
+    }
+    check(dynamic_cast<IntelBackend*>(backends[0].get()) != nullptr, "card0 gets the Intel backend");
+    check(dynamic_cast<AmdgpuBackend*>(backends[1].get()) != nullptr, "card1 gets the amdgpu backend");
+    check(backends[0]->getCards()[0].name == "card0" && backends[0]->getCards()[0].driver == "i915",
+          "card0 named i915");
+    check(backends[1]->getCards()[0].name == "card1" && backends[1]->getCards()[0].driver == "amdgpu",
+          "card1 named amdgpu");
+
+    for (auto& backend : backends) backend->update();
+    const GpuCardStats& intel = backends[0]->getCards()[0];
+    const GpuCardStats& amdgpu = backends[1]->getCards()[0];
+    check(intel.hasFrequency && intel.frequency == 1100 && intel.maxFrequency == 1500, "i915 frequencies");
+    check(!intel.hasUsage && !intel.hasPower, "i915 busy % and power wait for a second sample");
+    check(amdgpu.hasUsage && amdgpu.usage == 42.0, "amdgpu busy %");
+    check(amdgpu.hasMemory && amdgpu.memoryUsed == 1024 && amdgpu.memoryTotal == 8192, "amdgpu VRAM in MB");
+    check(amdgpu.hasTemperature && amdgpu.temperature == 55, "amdgpu temperature");
+    check(amdgpu.hasPower && amdgpu.power == 123.0, "amdgpu power");
+    check(amdgpu.hasFrequency && amdgpu.frequency == 1800, "amdgpu clock");
+
+    // No RC6 time since the last sample means the GT was busy throughout.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    writeFile(amd / "gpu_busy_percent", "7");
+    writeFile(drm / "card0" / "device" / "hwmon" / "hwmon5" / "energy1_input", "6000000");
+    for (auto& backend : backends) backend->update();
+    check(amdgpu.usage == 7.0, "amdgpu rereads its open files");
+    check(intel.hasUsage && intel.usage == 100.0, "i915 busy % from the RC6 delta");
+    check(intel.hasPower && intel.power > 0.0, "i915 power from the energy delta");
+
+    // The NVIDIA driver is found under procRoot, not the host's /proc.
+    writeFile(proc / "driver" / "nvidia" / "version", "NVRM version: test");
+    backends = probeGpuBackends(drm.string(), proc.string());
+    check(backends.size() == 3 && dynamic_cast<NvidiaSmiBackend*>(backends.back().get()) != nullptr,
+          "nvidia-smi added last when procRoot has the driver");
+
+    fs::remove_all(root);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "ProbeEngine.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs ProbeEngine end to end against listeners on 127.0.0.1: a plain TCP target, an HTTP one,
+// a closed port and a name that can't resolve, all probed at once.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+class Listener {
+public:
+    // Accepts on an ephemeral loopback port. With http, answers anything it is sent with a 200.
+    explicit Listener(bool http) : http(http), stopping(false) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 || listen(fd, 64) != 0 ||
+            getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            perror("listener");
+            return;
+        }
+        port = ntohs(address.sin_port);
+        thread = std::thread([this] { serve(); });
+    }
+
+    ~Listener() {
+        stopping = true;
+        if (thread.joinable()) thread.join();
+        if (fd >= 0) close(fd);
+    }
+
+    int getPort() const { return port; }
+    int getRequests() const { return requests; }
+
+private:
+    int fd;
+    int port = 0;
+    bool http;
+    std::atomic<bool> stopping;
+    std::atomic<int> requests{0};
+    std::thread thread;
+
+    void serve() {
+        while (!stopping) {
+            pollfd listening = {fd, POLLIN, 0};
+            if (poll(&listening, 1, 20) <= 0) continue;
+            int client = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) continue;
+            pollfd readable = {client, POLLIN, 0};
+            char request[512];
+            if (http && poll(&readable, 1, 500) > 0 && recv(client, request, sizeof(request), 0) > 0) {
+                requests++;
+                const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+                send(client, response, sizeof(response) - 1, MSG_NOSIGNAL);
+            }
+            close(client);
+        }
+    }
+};
+
+int closedPort() {
+    // Bound but never listened on, so connecting is refused.
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(fd, reinterpret_cast<sockaddr*>(&address), length);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    int port = ntohs(address.sin_port);
+    close(fd);
+    return port;
+}
+
+} // namespace
+
+int main() {
+    Listener tcp(false);
+    Listener http(true);
+    if (tcp.getPort() == 0 || http.getPort() == 0) {
+        return 1;
+    }
+
+    const std::string specs[] = {
+        "127.0.0.1:" + std::to_string(tcp.getPort()),
+        "http://127.0.0.1:" + std::to_string(http.getPort()) + "/health",
+        "127.0.0.1:" + std::to_string(closedPort()),
+        "statsby-probe-test.invalid:80",
+    };
+    std::vector<ProbeTarget> targets;
+    for (const std::string& spec : specs) {
+        ProbeTarget target;
+        check(ProbeTarget::parse(spec, target), "target parses");
+        targets.push_back(target);
+    }
+
+    ProbeEngine engine;
+    engine.start(targets, 100, 500);
+    check(engine.isRunning(), "engine starts");
+
+    // Ten rounds at the 100 ms minimum interval, plus slack for a slow machine.
+    std::vector<ProbeStats> stats;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        engine.copyStats(stats);
+        if (stats.size() == 4 && stats[0].samples >= 10 && stats[1].samples >= 10 && stats[2].failures > 0 &&
+            stats[3].failures > 0) {
+            break;
+        }
+    }
+    engine.stop();
+    check(!engine.isRunning(), "engine stops");
+    if (stats.size() != 4) {
+        fprintf(stderr, "FAIL: expected stats for 4 targets, got %zu\n", stats.size());
+        return 1;
+    }
+
+    const ProbeStats& plain = stats[0];
+    check(plain.ok && plain.lastError.empty(), "plain target connects");
+    check(plain.samples >= 10, "plain target keeps probing while the others fail");
+    check(plain.lastConnectMs > 0 && plain.p50ConnectMs <= plain.p99ConnectMs, "connect percentiles are ordered");
+    // Loopback handshakes take microseconds; anything near the timeout means a probe sat behind another.
+    check(plain.p99ConnectMs < 250, "loopback connect p99 well under the timeout");
+
+    const ProbeStats& web = stats[1];
+    check(web.http && web.ok, "HTTP target answers");
+    check(web.samples >= 10 && http.getRequests() >= 10, "HTTP target sends a GET every round");
+    check(web.lastTtfbMs > 0 && web.p50TtfbMs <= web.p99TtfbMs, "TTFB recorded");
+
+    const ProbeStats& refused = stats[2];
+    check(!refused.ok && refused.samples == 0 && refused.failures > 0, "closed port fails");
+    check(refused.lastError != "timeout", "refusal is reported as such, not as a timeout");
+
+    const ProbeStats& unresolved = stats[3];
+    check(!unresolved.ok && unresolved.samples == 0, "unresolvable name never probes");
+
+    for (const ProbeStats& target : stats) {
+        printf("%-40s ok=%d samples=%d failures=%d p50=%.3f p99=%.3f ttfb=%.3f %s\n", target.label.c_str(),
+               target.ok, target.samples, target.failures, target.p50ConnectMs, target.p99ConnectMs,
+               target.p50TtfbMs, target.lastError.c_str());
+    }
+    return failures == 0 ? 0 : 1;
+}